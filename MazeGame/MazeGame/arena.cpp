@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <cstdlib>
+#include "arena.h"
+
+Arena::Arena(size_t block_size) : block_size_(block_size), current_block_(0), finalizers_(nullptr) {}
+
+Arena::~Arena() {
+    Reset();
+    for (Block& block : blocks_) {
+        free(block.data);
+    }
+}
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+    while (current_block_ < blocks_.size()) {
+        Block& block = blocks_[current_block_];
+        size_t start = (block.used + alignment - 1) & ~(alignment - 1);
+        if (start + size <= block.size) {
+            block.used = start + size;
+            return block.data + start;
+        }
+
+        current_block_++;  // Whatever's left at the end of this block is wasted until the next reset
+    }
+
+    size_t size_needed = size + alignment;
+    Block block;
+    block.size = size_needed > block_size_ ? size_needed : block_size_;
+    block.data = static_cast<char*>(malloc(block.size));  // malloc aligns for any fundamental type, which covers everything we store
+    block.used = 0;
+    if (block.data == nullptr) {
+        printf("Arena failed to allocate a %zu byte block. Exiting...\n", block.size);
+        exit(1);
+    }
+
+    blocks_.push_back(block);
+    current_block_ = blocks_.size() - 1;
+    return Allocate(size, alignment);
+}
+
+void Arena::Reset() {
+    if (current_ == this) {
+        printf("Warning: resetting an arena while a Scope still allocates from it\n");
+    }
+
+    // Finalizers were pushed onto the front of the list, so this destroys objects in the reverse order they were made. Destructors
+    // mustn't allocate from this arena, since it's about to be rewound.
+    Finalizer* finalizer = finalizers_;
+    finalizers_ = nullptr;
+    for (; finalizer != nullptr; finalizer = finalizer->next) {
+        finalizer->destroy(finalizer->object);
+    }
+
+    for (Block& block : blocks_) {
+        block.used = 0;
+    }
+    current_block_ = 0;
+}
+
+size_t Arena::BytesUsed() const {
+    size_t used = 0;
+    for (const Block& block : blocks_) {
+        used += block.used;
+    }
+
+    return used;
+}
+
+size_t Arena::BytesReserved() const {
+    size_t reserved = 0;
+    for (const Block& block : blocks_) {
+        reserved += block.size;
+    }
+
+    return reserved;
+}
+
+Arena* Arena::Current() {
+    return current_;
+}
+
+void Arena::AddFinalizer(void (*destroy)(void*), void* object) {
+    Finalizer* finalizer = static_cast<Finalizer*>(Allocate(sizeof(Finalizer), alignof(Finalizer)));
+    finalizer->destroy = destroy;
+    finalizer->object = object;
+    finalizer->next = finalizers_;
+    finalizers_ = finalizer;
+}
+
+Arena::Scope::Scope(Arena* arena) : previous_(current_) {
+    current_ = arena;
+}
+
+Arena::Scope::~Scope() {
+    current_ = previous_;
+}
+
+Arena* Arena::current_ = nullptr;
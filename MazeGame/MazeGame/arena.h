@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * A bump allocator for objects that all share one lifetime, like everything belonging to a level. Allocating is a pointer bump,
+ * individual frees are no-ops, and Reset() destroys everything made with New() (newest first) and rewinds the whole arena at once.
+ * Blocks are kept across resets, so once the arena has grown to fit a level, loading the next one doesn't touch the heap.
+ */
+class Arena {
+   public:
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+    explicit Arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+
+    void* Allocate(size_t size, size_t alignment);
+
+    template <typename T, typename... Args>
+    T* New(Args&&... args) {
+        void* memory = Allocate(sizeof(T), alignof(T));
+        T* object = new (memory) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            AddFinalizer(&Destroy<T>, object);
+        }
+
+        return object;
+    }
+
+    template <typename T>
+    T* NewArray(size_t count) {  // Uninitialized, so only for types that don't need destroying
+        static_assert(std::is_trivially_destructible<T>::value, "Arena arrays are never destroyed");
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void Reset();
+
+    size_t BytesUsed() const;
+    size_t BytesReserved() const;
+
+    static Arena* Current();  // The arena of the innermost Scope, or nullptr when there isn't one
+
+    // While a Scope is alive, MakeShared() allocates from its arena. This is how objects built deep inside constructors (like
+    // a GameObject's transform) end up in the level arena without every constructor taking one.
+    class Scope {
+       public:
+        explicit Scope(Arena* arena);
+        ~Scope();
+
+       private:
+        Arena* previous_;
+    };
+
+   private:
+    struct Block {
+        char* data;
+        size_t size;
+        size_t used;
+    };
+
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+        Finalizer* next;
+    };
+
+    template <typename T>
+    static void Destroy(void* object) {
+        static_cast<T*>(object)->~T();
+    }
+
+    void AddFinalizer(void (*destroy)(void*), void* object);
+
+    size_t block_size_;
+    std::vector<Block> blocks_;
+    size_t current_block_;
+    Finalizer* finalizers_;  // Newest first
+
+    static Arena* current_;
+};
+
+// Lets standard containers and std::allocate_shared carve their storage out of an arena
+template <typename T>
+class ArenaAllocator {
+   public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(Arena* arena) : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(arena_->Allocate(sizeof(T) * count, alignof(T)));
+    }
+    void deallocate(T*, size_t) {}  // Reclaimed when the arena is reset
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena_ == other.arena_;
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return arena_ != other.arena_;
+    }
+
+   private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    Arena* arena_;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// std::make_shared, except inside an Arena::Scope the object and its control block live in that arena. Anything made this way
+// must be released before the arena is reset.
+template <typename T, typename... Args>
+std::shared_ptr<T> MakeShared(Args&&... args) {
+    Arena* arena = Arena::Current();
+    if (arena == nullptr) {
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+
+    return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
@@ -1,138 +1,221 @@
 #include <algorithm>
 #include <cmath>
+#include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
 #include "bounding_box.h"
+#include "gl_state.h"
+#include "model.h"
 #include "shader_manager.h"
 #include "texture_manager.h"
 
 using glm::vec3;
-using std::max;
-using std::min;
-
-BoundingBox::BoundingBox() {
-    transform = std::make_shared<Transformable>(false);
-}
-
-BoundingBox::BoundingBox(std::vector<glm::vec4> points) : BoundingBox() {
-    float min_x = INFINITY, min_y = INFINITY, min_z = INFINITY, max_x = -INFINITY, max_y = -INFINITY, max_z = -INFINITY;
-    for (auto point : points) {
-        min_x = min(min_x, point.x);
-        min_y = min(min_y, point.y);
-        min_z = min(min_z, point.z);
-        max_x = max(max_x, point.x);
-        max_y = max(max_y, point.y);
-        max_z = max(max_z, point.z);
+
+static_assert(sizeof(BoundingBox) == 6 * sizeof(float), "BoundingBox should stay a plain pair of points");
+
+BoundingBox::BoundingBox() : min_(vec3(INFINITY)), max_(vec3(-INFINITY)) {}
+
+BoundingBox::BoundingBox(const vec3& min, const vec3& max) : min_(min), max_(max) {}
+
+BoundingBox::BoundingBox(const vec3* points, size_t count) : BoundingBox() {
+    for (size_t i = 0; i < count; i++) {
+        ExpandToBound(points[i]);
     }
+}
 
-    InitToBounds(vec3(min_x, min_y, min_z), vec3(max_x, max_y, max_z));
+BoundingBox::BoundingBox(const std::vector<vec3>& points) : BoundingBox(points.data(), points.size()) {}
+
+void BoundingBox::ExpandToBound(const vec3& point) {
+    min_ = glm::min(min_, point);
+    max_ = glm::max(max_, point);
+}
+
+void BoundingBox::ExpandToBound(const BoundingBox& other) {
+    min_ = glm::min(min_, other.min_);
+    max_ = glm::max(max_, other.max_);
 }
 
-BoundingBox::BoundingBox(std::vector<vec3> points) : BoundingBox() {  // Terrible copy of above but meh
-    float min_x = INFINITY, min_y = INFINITY, min_z = INFINITY, max_x = -INFINITY, max_y = -INFINITY, max_z = -INFINITY;
-    for (auto point : points) {
-        min_x = min(min_x, point.x);
-        min_y = min(min_y, point.y);
-        min_z = min(min_z, point.z);
-        max_x = max(max_x, point.x);
-        max_y = max(max_y, point.y);
-        max_z = max(max_z, point.z);
+void BoundingBox::ExpandToBound(const std::vector<BoundingBox>& bounding_boxes) {
+    for (const BoundingBox& bounding_box : bounding_boxes) {
+        ExpandToBound(bounding_box);
     }
+}
 
-    InitToBounds(vec3(min_x, min_y, min_z), vec3(max_x, max_y, max_z));
+std::array<vec3, 8> BoundingBox::GetBoxVertices() const {
+    return {min_,
+            vec3(min_.x, min_.y, max_.z),
+            vec3(min_.x, max_.y, min_.z),
+            vec3(min_.x, max_.y, max_.z),
+            vec3(max_.x, min_.y, min_.z),
+            vec3(max_.x, min_.y, max_.z),
+            vec3(max_.x, max_.y, min_.z),
+            max_};
 }
 
-BoundingBox::~BoundingBox() = default;
+BoundingBox BoundingBox::Transformed(const glm::mat4& transform) const {
+    if (IsEmpty()) return *this;
 
-void BoundingBox::ExpandToBound(const BoundingBox& other) {
-    vec3 new_min = vec3(min(min_->X(), other.min_->X()), min(min_->Y(), other.min_->Y()), min(min_->Z(), other.min_->Z()));
-    vec3 new_max = vec3(max(max_->X(), other.max_->X()), max(max_->Y(), other.max_->Y()), max(max_->Z(), other.max_->Z()));
+    // Center/extent method: same result as transforming all 8 corners, for a fraction of the work
+    vec3 center = vec3(transform * glm::vec4(Center(), 1.0f));
+    vec3 half_extents = HalfExtents();
+    vec3 transformed_half_extents = glm::abs(vec3(transform[0])) * half_extents.x + glm::abs(vec3(transform[1])) * half_extents.y +
+                                    glm::abs(vec3(transform[2])) * half_extents.z;
 
-    min_->ResetAndSetTranslation(new_min);
-    max_->ResetAndSetTranslation(new_max);
+    return BoundingBox(center - transformed_half_extents, center + transformed_half_extents);
 }
 
-void BoundingBox::ExpandToBound(const std::vector<BoundingBox> bounding_boxes) {
-    for (BoundingBox bounding_box : bounding_boxes) {
-        ExpandToBound(bounding_box);
+BoundingBox BoundingBox::Translated(const vec3& translation) const {
+    return BoundingBox(min_ + translation, max_ + translation);
+}
+
+bool BoundingBox::SweepAgainst(const vec3& displacement, const BoundingBox& obstacle, float* time_of_impact, vec3* normal) const {
+    // Already overlapping. The way out is along the axis it's least far in along, toward the nearer face
+    float least_penetration = INFINITY;
+    int least_axis = -1;
+    float least_side = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        float into_min = max_[axis] - obstacle.min_[axis];
+        float into_max = obstacle.max_[axis] - min_[axis];
+        if (into_min <= 0 || into_max <= 0) {  // Apart along this axis, so they don't overlap
+            least_axis = -1;
+            break;
+        }
+        if (std::min(into_min, into_max) < least_penetration) {
+            least_penetration = std::min(into_min, into_max);
+            least_axis = axis;
+            least_side = into_min < into_max ? -1.0f : 1.0f;
+        }
+    }
+    if (least_axis != -1) {
+        if (displacement[least_axis] * least_side >= 0) return false;  // Sliding along it or backing out
+
+        *time_of_impact = 0;
+        *normal = vec3(0);
+        (*normal)[least_axis] = least_side;
+        return true;
     }
+
+    float entry = -INFINITY, exit = INFINITY;
+    int entry_axis = -1;
+    for (int axis = 0; axis < 3; axis++) {
+        if (displacement[axis] == 0) {
+            // Never moving into it along this axis. Touching faces count as apart, so sliding along a wall isn't blocked by it
+            if (max_[axis] <= obstacle.min_[axis] || obstacle.max_[axis] <= min_[axis]) return false;
+            continue;
+        }
+
+        float inverse = 1.0f / displacement[axis];
+        bool positive = displacement[axis] > 0;
+        float axis_entry = (positive ? obstacle.min_[axis] - max_[axis] : obstacle.max_[axis] - min_[axis]) * inverse;
+        float axis_exit = (positive ? obstacle.max_[axis] - min_[axis] : obstacle.min_[axis] - max_[axis]) * inverse;
+        if (axis_entry > entry) {
+            entry = axis_entry;
+            entry_axis = axis;
+        }
+        exit = std::min(exit, axis_exit);
+    }
+
+    if (entry_axis == -1 || entry < 0 || entry >= 1 || entry > exit) return false;
+
+    *time_of_impact = entry;
+    *normal = vec3(0);
+    (*normal)[entry_axis] = displacement[entry_axis] > 0 ? -1.0f : 1.0f;
+    return true;
 }
 
-std::vector<vec3> BoundingBox::GetBoxVertices() {
-    std::vector<vec3> vertices;
-    auto min = min_->WorldPosition();
-    auto max = max_->WorldPosition();
+bool BoundingBox::RayCast(const vec3& origin, const vec3& direction, float max_distance, float* distance, vec3* normal) const {
+    float entry = -INFINITY, exit = INFINITY;
+    int entry_axis = -1;
+    for (int axis = 0; axis < 3; axis++) {
+        if (direction[axis] == 0) {
+            if (origin[axis] < min_[axis] || max_[axis] < origin[axis]) return false;  // Runs alongside the box, never into it
+            continue;
+        }
+
+        float inverse = 1.0f / direction[axis];
+        bool positive = direction[axis] > 0;
+        float axis_entry = ((positive ? min_[axis] : max_[axis]) - origin[axis]) * inverse;
+        float axis_exit = ((positive ? max_[axis] : min_[axis]) - origin[axis]) * inverse;
+        if (axis_entry > entry) {
+            entry = axis_entry;
+            entry_axis = axis;
+        }
+        exit = std::min(exit, axis_exit);
+    }
 
-    vertices.push_back(min);
-    vertices.push_back(vec3(min.x, min.y, max.z));
-    vertices.push_back(vec3(min.x, max.y, min.z));
-    vertices.push_back(vec3(min.x, max.y, max.z));
-    vertices.push_back(vec3(max.x, min.y, min.z));
-    vertices.push_back(vec3(max.x, min.y, max.z));
-    vertices.push_back(vec3(max.x, max.y, min.z));
-    vertices.push_back(max);
+    if (entry_axis == -1 || entry < 0 || entry > max_distance || entry > exit) return false;
 
-    return vertices;
+    *distance = entry;
+    *normal = vec3(0);
+    (*normal)[entry_axis] = direction[entry_axis] > 0 ? -1.0f : 1.0f;
+    return true;
 }
 
 bool BoundingBox::ContainsOrIntersects(const BoundingBox& other) const {
-    return Overlaps(other.min_->X(), other.max_->X(), min_->X(), max_->X()) &&
-           Overlaps(other.min_->Y(), other.max_->Y(), min_->Y(), max_->Y()) &&
-           Overlaps(other.min_->Z(), other.max_->Z(), min_->Z(), max_->Z());
+    return Overlaps(other.min_.x, other.max_.x, min_.x, max_.x) && Overlaps(other.min_.y, other.max_.y, min_.y, max_.y) &&
+           Overlaps(other.min_.z, other.max_.z, min_.z, max_.z);
+}
+
+bool BoundingBox::Contains(const BoundingBox& other) const {
+    return min_.x <= other.min_.x && min_.y <= other.min_.y && min_.z <= other.min_.z && other.max_.x <= max_.x &&
+           other.max_.y <= max_.y && other.max_.z <= max_.z;
+}
+
+bool BoundingBox::IsEmpty() const {
+    return min_.x > max_.x || min_.y > max_.y || min_.z > max_.z;
+}
+
+float BoundingBox::SurfaceArea() const {
+    if (IsEmpty()) return 0;
+
+    vec3 size = max_ - min_;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+float BoundingBox::DistanceTo(const vec3& point) const {
+    vec3 outside = glm::max(glm::max(min_ - point, point - max_), vec3(0));
+    return glm::length(outside);
 }
 
 void BoundingBox::Render() const {
     vec3 color = vec3(1, 0, 0);
 
-    glUseProgram(ShaderManager::Textured_Shader);
-    glBindVertexArray(debug_render_model->model_vao_);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    GLState::UseProgram(ShaderManager::Textured_Shader);
+    GLState::BindVertexArray(debug_render_model->model_vao_);
+    GLState::PolygonMode(GL_LINE);
 
     glm::mat4 model_matrix;
-    vec3 scale = vec3(max_->X() - min_->X(), max_->Y() - min_->Y(), max_->Z() - min_->Z());
-    vec3 center = vec3(max_->WorldPosition() + min_->WorldPosition());
-    center *= 0.5f;
-    model_matrix = glm::translate(model_matrix, center);
-    model_matrix = glm::scale(model_matrix, scale);
+    model_matrix = glm::translate(model_matrix, Center());
+    model_matrix = glm::scale(model_matrix, max_ - min_);
     // printf("Center: %f, %f, %f\n", center.x, center.y, center.z);
 
     glUniformMatrix4fv(ShaderManager::Attributes.model, 1, GL_FALSE, glm::value_ptr(model_matrix));
 
-    // glUniformMatrix4fv(ShaderManager::Attributes.model, 1, GL_FALSE,
-    //                   glm::value_ptr(transform->WorldTransform()));  // pass model matrix to shader
-
     glUniform1i(ShaderManager::Attributes.texID, UNTEXTURED);
     glUniform3fv(ShaderManager::Attributes.color, 1, glm::value_ptr(color));  // Set the color
 
     glDrawArrays(GL_TRIANGLES, debug_render_model->vbo_vertex_start_index_, debug_render_model->NumVerts());
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    // glBindVertexArray(0);
-    glUseProgram(0);
+    GLState::PolygonMode(GL_FILL);
 }
 
 vec3 BoundingBox::Max() const {
-    return vec3(max_->X(), max_->Y(), max_->Z());
+    return max_;
 }
 
 vec3 BoundingBox::Min() const {
-    return vec3(min_->X(), min_->Y(), min_->Z());
+    return min_;
 }
 
-bool BoundingBox::Overlaps(double otherMin, double otherMax, double min, double max) {
-    return IsBetween(otherMin, min, max) || IsBetween(otherMax, min, max) || IsBetween(min, otherMin, otherMax) ||
-           IsBetween(max, otherMin, otherMax);
+vec3 BoundingBox::Center() const {
+    return (min_ + max_) * 0.5f;
 }
 
-bool BoundingBox::IsBetween(double val, double low, double high) {
-    return val >= low && val <= high;
+vec3 BoundingBox::HalfExtents() const {
+    return (max_ - min_) * 0.5f;
 }
 
-void BoundingBox::InitToBounds(vec3 min, vec3 max) {
-    min_ = std::make_shared<Transformable>(min, false);
-    max_ = std::make_shared<Transformable>(max, false);
-
-    min_->SetParent(transform);
-    max_->SetParent(transform);
+bool BoundingBox::Overlaps(float otherMin, float otherMax, float min, float max) {
+    return otherMin <= max && min <= otherMax;  // Inclusive, so touching boxes count
 }
 
 Model* BoundingBox::debug_render_model;
@@ -1,38 +1,57 @@
 #pragma once
-#include <memory>
+#include <array>
 #include <vector>
-#include "model.h"
-#include "transformable.h"
+#include "glm.hpp"
+
+class Model;
 
 /**
- * Known problem: this does nothing to account for rotation or shearing of the parent transform.
+ * A plain axis-aligned box. It's a 24 byte value type, so copying, transforming, and testing boxes never allocates.
+ * Use Transformed() to get the world-space box around a model-space one, and OrientedBoundingBox when rotation matters.
  */
 class BoundingBox {
    public:
-    BoundingBox();
-    explicit BoundingBox(std::vector<glm::vec4> points);  // Grows BB to encompass all points
-    explicit BoundingBox(std::vector<glm::vec3> points);
-    ~BoundingBox();
+    BoundingBox();  // An empty box, which grows to fit the first thing it's expanded to bound
+    BoundingBox(const glm::vec3& min, const glm::vec3& max);
+    BoundingBox(const glm::vec3* points, size_t count);  // Grows BB to encompass all points
+    explicit BoundingBox(const std::vector<glm::vec3>& points);
 
+    void ExpandToBound(const glm::vec3& point);
     void ExpandToBound(const BoundingBox& other);
-    void ExpandToBound(const std::vector<BoundingBox> bounding_boxes);
-    std::vector<glm::vec3> GetBoxVertices();
+    void ExpandToBound(const std::vector<BoundingBox>& bounding_boxes);
+    std::array<glm::vec3, 8> GetBoxVertices() const;
+
+    BoundingBox Transformed(const glm::mat4& transform) const;  // The smallest box around this one after it's transformed
+    BoundingBox Translated(const glm::vec3& translation) const;
+
+    // Whether this box, moving by displacement, runs into obstacle. If so, time_of_impact is the fraction of the displacement
+    // covered before they touch, and normal is the face of obstacle it hit. Boxes that already overlap hit at once if the move
+    // goes deeper along the axis they overlap least on, with normal along that axis, so something that's been pushed partway
+    // into an obstacle can slide along it or back out but never go through
+    bool SweepAgainst(const glm::vec3& displacement, const BoundingBox& obstacle, float* time_of_impact, glm::vec3* normal) const;
+
+    // Whether a ray from origin enters this box within max_distance, in multiples of direction's length. If so, distance is where
+    // and normal is the face it enters through. Rays that start inside the box don't hit it, so casting from inside something
+    // (like the player) sees past it
+    bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, float* distance, glm::vec3* normal) const;
 
     bool ContainsOrIntersects(const BoundingBox& other) const;
+    bool Contains(const BoundingBox& other) const;  // Whether other lies entirely inside this box
+    bool IsEmpty() const;
+    float SurfaceArea() const;
+    float DistanceTo(const glm::vec3& point) const;  // 0 for points inside the box
     void Render() const;  // Renders the bounding box in as a wireframe
 
     glm::vec3 Max() const;
     glm::vec3 Min() const;
-
-    std::shared_ptr<Transformable> transform;
+    glm::vec3 Center() const;
+    glm::vec3 HalfExtents() const;
 
     static Model* debug_render_model;
 
    private:
-    static bool Overlaps(double otherMin, double otherMax, double min, double max);
-    static bool IsBetween(double val, double low, double high);
-    void InitToBounds(glm::vec3 min, glm::vec3 max);
+    static bool Overlaps(float otherMin, float otherMax, float min, float max);
 
-    std::shared_ptr<Transformable> min_;
-    std::shared_ptr<Transformable> max_;
+    glm::vec3 min_;
+    glm::vec3 max_;
 };
@@ -0,0 +1,21 @@
+#pragma once
+#include <algorithm>
+#include "glm.hpp"
+
+// Cheaper to test than a box, and unaffected by rotation. Looser, though, so it's only good for rejecting things early
+struct BoundingSphere {
+    glm::vec3 center;
+    float radius;
+
+    BoundingSphere Transformed(const glm::mat4& transform) const {
+        float max_scale = std::max(std::max(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1]))),
+                                   glm::length(glm::vec3(transform[2])));
+        return BoundingSphere{glm::vec3(transform * glm::vec4(center, 1.0f)), radius * max_scale};
+    }
+
+    bool Intersects(const BoundingSphere& other) const {
+        glm::vec3 offset = other.center - center;
+        float radii = radius + other.radius;
+        return glm::dot(offset, offset) <= radii * radii;
+    }
+};
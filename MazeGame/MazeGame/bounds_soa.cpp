@@ -0,0 +1,79 @@
+#include <cmath>
+#include "bounds_soa.h"
+
+BoundsSoA::BoundsSoA(Arena* arena)
+    : min_x_(ArenaAllocator<float>(arena)),
+      min_y_(ArenaAllocator<float>(arena)),
+      min_z_(ArenaAllocator<float>(arena)),
+      max_x_(ArenaAllocator<float>(arena)),
+      max_y_(ArenaAllocator<float>(arena)),
+      max_z_(ArenaAllocator<float>(arena)),
+      size_(0) {}
+
+int BoundsSoA::Add(const BoundingBox& bounds) {
+    if (size_ == PaddedSize()) {
+        // An empty box (min above max) fails every overlap test, so it's safe padding
+        size_t padded = min_x_.size() + LANES;
+        min_x_.resize(padded, INFINITY);
+        min_y_.resize(padded, INFINITY);
+        min_z_.resize(padded, INFINITY);
+        max_x_.resize(padded, -INFINITY);
+        max_y_.resize(padded, -INFINITY);
+        max_z_.resize(padded, -INFINITY);
+    }
+
+    Set(size_, bounds);
+    return size_++;
+}
+
+void BoundsSoA::Set(int index, const BoundingBox& bounds) {
+    glm::vec3 min = bounds.Min(), max = bounds.Max();
+    min_x_[index] = min.x;
+    min_y_[index] = min.y;
+    min_z_[index] = min.z;
+    max_x_[index] = max.x;
+    max_y_[index] = max.y;
+    max_z_[index] = max.z;
+}
+
+BoundingBox BoundsSoA::Get(int index) const {
+    return BoundingBox(glm::vec3(min_x_[index], min_y_[index], min_z_[index]), glm::vec3(max_x_[index], max_y_[index], max_z_[index]));
+}
+
+bool BoundsSoA::Overlaps(int index, const BoundingBox& bounds) const {
+    glm::vec3 min = bounds.Min(), max = bounds.Max();
+    return min_x_[index] <= max.x && min.x <= max_x_[index] && min_y_[index] <= max.y && min.y <= max_y_[index] &&
+           min_z_[index] <= max.z && min.z <= max_z_[index];
+}
+
+int BoundsSoA::Size() const {
+    return size_;
+}
+
+int BoundsSoA::PaddedSize() const {
+    return static_cast<int>(min_x_.size());
+}
+
+const float* BoundsSoA::MinX() const {
+    return min_x_.data();
+}
+
+const float* BoundsSoA::MinY() const {
+    return min_y_.data();
+}
+
+const float* BoundsSoA::MinZ() const {
+    return min_z_.data();
+}
+
+const float* BoundsSoA::MaxX() const {
+    return max_x_.data();
+}
+
+const float* BoundsSoA::MaxY() const {
+    return max_y_.data();
+}
+
+const float* BoundsSoA::MaxZ() const {
+    return max_z_.data();
+}
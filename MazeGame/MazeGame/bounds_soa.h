@@ -0,0 +1,33 @@
+#pragma once
+#include "arena.h"
+#include "bounding_box.h"
+
+/**
+ * Boxes stored as six separate float arrays, so OverlapKernels can load one coordinate of eight boxes with a single instruction.
+ * The arrays are padded to a multiple of LANES with boxes that overlap nothing, so kernels never need a scalar tail.
+ */
+class BoundsSoA {
+   public:
+    static const int LANES = 8;
+
+    explicit BoundsSoA(Arena* arena);
+
+    int Add(const BoundingBox& bounds);  // Indices count up from 0
+    void Set(int index, const BoundingBox& bounds);
+    BoundingBox Get(int index) const;
+    bool Overlaps(int index, const BoundingBox& bounds) const;  // The scalar test, for checking one box
+
+    int Size() const;
+    int PaddedSize() const;
+
+    const float* MinX() const;
+    const float* MinY() const;
+    const float* MinZ() const;
+    const float* MaxX() const;
+    const float* MaxY() const;
+    const float* MaxZ() const;
+
+   private:
+    ArenaVector<float> min_x_, min_y_, min_z_, max_x_, max_y_, max_z_;
+    int size_;
+};
@@ -59,7 +59,7 @@ float Camera::GetTotalHorizontalRotation() const {
     return total_horizontal_rotation;
 }
 
-void Camera::Update() {
+void Camera::Simulate(float dt) {
     /*const Uint8* key_state = SDL_GetKeyboardState(NULL);
     if (key_state[SDL_SCANCODE_UP]) {
         Rotate(CAMERA_ROTATION_SPEED, 0);
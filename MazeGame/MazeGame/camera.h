@@ -19,7 +19,7 @@ class Camera : public Updatable {
     glm::vec3 GetNormalizedLookPosition() const;
     float GetTotalHorizontalRotation() const;
 
-    void Update() override;
+    void Simulate(float dt) override;
 
     std::shared_ptr<Transformable> transform;
 
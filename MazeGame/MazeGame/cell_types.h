@@ -0,0 +1,82 @@
+#pragma once
+#include "texture_manager.h"
+
+// What a character in a map file becomes
+typedef enum { CELL_INVALID = 0, CELL_GROUND, CELL_WALL, CELL_DOOR, CELL_KEY, CELL_SPAWN, CELL_GOAL, CELL_FRACTAL, NUM_CELL_KINDS } CellKind;
+
+typedef enum { WALL_MODEL = 0, DOOR_MODEL, KEY_MODEL, START_MODEL, GOAL_MODEL, NUM_CELL_MODELS } CellModel;
+
+struct CellDescriptor {
+    CellKind kind;
+    bool solid;
+    float color_r, color_g, color_b;
+    CellModel model;
+    TEXTURE texture;
+    bool needs_ground;  // Every cell gets a ceiling, but only cells with something in them need a floor put under it
+};
+
+struct CellTable {
+    CellDescriptor cells[256];
+
+    constexpr const CellDescriptor& operator[](char c) const {
+        return cells[static_cast<unsigned char>(c)];
+    }
+};
+
+constexpr CellDescriptor MakeCell(CellKind kind, bool solid, CellModel model, TEXTURE texture, bool needs_ground, float color_r = 0,
+                                  float color_g = 1, float color_b = 0) {
+    return CellDescriptor{kind, solid, color_r, color_g, color_b, model, texture, needs_ground};
+}
+
+constexpr CellDescriptor DescribeCell(char c) {
+    switch (c) {
+        case '0':
+            return MakeCell(CELL_GROUND, false, WALL_MODEL, TEX1, false);
+        case 'W':
+            return MakeCell(CELL_WALL, true, WALL_MODEL, FRACTAL, false);
+        case 'S':
+            return MakeCell(CELL_SPAWN, false, START_MODEL, UNTEXTURED, true, 0, 1, 0);
+        case 'G':
+            return MakeCell(CELL_GOAL, false, GOAL_MODEL, UNTEXTURED, true, 1, 1, 0);
+        case 'F':
+            return MakeCell(CELL_FRACTAL, false, WALL_MODEL, FRACTAL, true);
+        case 'A':
+            return MakeCell(CELL_DOOR, true, DOOR_MODEL, UNTEXTURED, true, 1, 0.9f, 0);
+        case 'B':
+            return MakeCell(CELL_DOOR, true, DOOR_MODEL, UNTEXTURED, true, 0.3f, 0.5f, 0.8f);
+        case 'C':
+            return MakeCell(CELL_DOOR, true, DOOR_MODEL, UNTEXTURED, true, 0.5f, 0.7f, 0.1f);
+        case 'D':
+            return MakeCell(CELL_DOOR, true, DOOR_MODEL, UNTEXTURED, true, 0.1f, 0.2f, 0.1f);
+        case 'E':
+            return MakeCell(CELL_DOOR, true, DOOR_MODEL, UNTEXTURED, true, 0.8f, 0.2f, 0.8f);
+        case 'a':
+            return MakeCell(CELL_KEY, false, KEY_MODEL, UNTEXTURED, true, 1, 0.9f, 0);
+        case 'b':
+            return MakeCell(CELL_KEY, false, KEY_MODEL, UNTEXTURED, true, 0.3f, 0.5f, 0.8f);
+        case 'c':
+            return MakeCell(CELL_KEY, false, KEY_MODEL, UNTEXTURED, true, 0.5f, 0.7f, 0.1f);
+        case 'd':
+            return MakeCell(CELL_KEY, false, KEY_MODEL, UNTEXTURED, true, 0.1f, 0.2f, 0.1f);
+        case 'e':
+            return MakeCell(CELL_KEY, false, KEY_MODEL, UNTEXTURED, true, 0.8f, 0.2f, 0.8f);
+        default:
+            return MakeCell(CELL_INVALID, false, WALL_MODEL, UNTEXTURED, false);
+    }
+}
+
+constexpr CellTable MakeCellTable() {
+    CellTable table = {};
+    for (int c = 0; c < 256; c++) {
+        table.cells[c] = DescribeCell(static_cast<char>(c));
+    }
+
+    return table;
+}
+
+// Built entirely at compile time, so looking up a cell while loading is a single indexed load
+constexpr CellTable CELL_TABLE = MakeCellTable();
+
+static_assert(CELL_TABLE['W'].solid && CELL_TABLE['W'].kind == CELL_WALL, "Walls should be solid");
+static_assert(CELL_TABLE['a'].kind == CELL_KEY && CELL_TABLE['A'].kind == CELL_DOOR, "Keys are lowercase and doors uppercase");
+static_assert(CELL_TABLE['#'].kind == CELL_INVALID, "Unknown characters should be invalid");
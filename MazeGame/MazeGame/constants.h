@@ -20,18 +20,71 @@ const int TEXCOORD_OFFSET = 3;
 const float CAMERA_ROTATION_SPEED = 0.01f;
 const float CAMERA_MOVE_SPEED = 0.01f;
 const float MAX_MOVE_SPEED = 2.0f * CAMERA_MOVE_SPEED;
-const float VR_MOVE_SPEED_FACTOR = 2.0f;
+const float VR_MOVE_SPEED_FACTOR = 1.0f;  // Thumbstick speed at full tilt, relative to the keyboard
 
 const float ABSOLUTE_TOLERANCE = 0.00001f;
 
+// Per-step constants like CAMERA_MOVE_SPEED and DOOR_SHRINK_FACTOR were tuned when game logic ran once per eye, twice a 90 Hz frame.
+// Scaling them by dt / REFERENCE_STEP keeps those speeds now that it runs in fixed steps.
+const float REFERENCE_STEP = 1.0f / 180.0f;
+// Game logic always advances by this much, however fast the headset renders, so gameplay is the same at 72 Hz or 144 Hz
+const float SIMULATION_STEP = 1.0f / 90.0f;
+const float MAX_FRAME_TIME = 0.1f;  // Keeps a long hitch (like loading a level) from running a burst of catch-up steps
+
 const float PLAYER_HALF_HEIGHT = 0.25f;
 const float START_CAMERA_Z = 2 * PLAYER_HALF_HEIGHT;
 const float GRAVITY = 0.0015f;
 const float JUMP_VELOCITY = 0.04f;
 const float GROUND_LEVEL = 0.0f;
+const float FLOOR_HEIGHT = -0.5f;                // Center of the floor cubes
+const float CEILING_HEIGHT = FLOOR_HEIGHT + 2.3f;  // Center of the ceiling cubes
 const float JUMPING_LATERAL_MOVEMENT_FACTOR = 0.04f;
 const float CROUCH_DISTANCE = 0.25f;
 const float CROUCH_SPEED_FACTOR = 0.35f;
+const float PLAYER_COLLISION_SKIN = 0.001f;  // Gap left between the player and whatever they walk into, so the next sweep starts clear
+const int MAX_SLIDE_ITERATIONS = 3;          // Enough to slide along one wall and stop in a corner
+
+// Simulation level of detail, in map cells and steps. See SimulationScheduler
+const float LOD_NEAR_DISTANCE = 3.0f;   // Closer than this ticks every step while in view
+const float LOD_FAR_DISTANCE = 8.0f;    // Further than this ticks every 4th step while in view
+const float LOD_VIEW_COSINE = -0.25f;   // How far off the look direction still counts as in view. Generous, since heads turn quickly
+const int LOD_MAX_INTERVAL = 8;         // What hidden far objects tick at
+const float LOD_WAKE_DURATION = 2.0f;   // Seconds an object runs at full rate after it's interacted with
+const int LOD_TICK_BUDGET = 16;         // Reduced-rate ticks per step. Any more that are due wait for the next step
+
+// Rigid bodies for loose items, in world units (1.5 m each) and seconds. See PhysicsWorld
+const float PHYSICS_GRAVITY = 9.8f / 1.5f;
+const int PHYSICS_SUBSTEPS = 2;                 // Per simulation step, whatever's going on
+const int PHYSICS_ITERATIONS = 8;               // Solver passes over the contacts per substep
+const float PHYSICS_CONTACT_MARGIN = 0.02f;     // Corners this close get a contact before they touch, so fast bodies don't tunnel
+const float PHYSICS_PENETRATION_SLOP = 0.002f;  // Overlap that's left alone, so resting contacts don't jitter
+const float PHYSICS_BAUMGARTE = 0.2f;           // Fraction of the overlap past the slop pushed out each substep
+const float PHYSICS_FRICTION = 0.6f;
+const float PHYSICS_RESTITUTION = 0.3f;
+const float PHYSICS_RESTITUTION_THRESHOLD = 0.5f;  // Slower impacts don't bounce at all
+const float PHYSICS_SLEEP_LINEAR_SPEED = 0.05f;
+const float PHYSICS_SLEEP_ANGULAR_SPEED = 0.2f;  // Radians per second
+const float PHYSICS_SLEEP_DELAY = 0.5f;          // Seconds an island has to stay below both speeds before it sleeps
+
+// See JobSystem
+const int JOB_MAX_WORKERS = 8;           // On top of the main and simulation threads, which help out while they wait
+const int JOB_MAX_EXTERNAL_THREADS = 4;  // Threads other than the workers that can submit jobs, like the main and simulation threads
+const int JOB_QUEUE_CAPACITY = 1024;     // Per thread. A job submitted to a full queue runs straight away instead
+const int JOB_MAX_DEPENDENTS = 8;        // Jobs that can wait on one counter
+const int JOB_SPINS_BEFORE_SLEEP = 64;   // Failed attempts to find work before an idle worker sleeps
+const int JOB_CHUNKS_PER_THREAD = 4;     // How finely ParallelFor() splits its range, so threads that finish early can steal
+
+// The smallest share of each parallel pass worth handing to another thread: about 5us of work, against the 1us or so it takes to
+// queue a chunk and have it picked up. Fewer items than this just run on the calling thread
+const int JOB_TRANSFORMS_PER_CHUNK = 256;  // World transforms and bounds, about 30ns each
+const int JOB_BODIES_PER_CHUNK = 128;      // Physics bodies' forces or integration, about 40ns each
+const int JOB_PACKETS_PER_CHUNK = 256;     // Render packets to frustum cull, about 20ns each
+const int JOB_TRIGGERS_PER_CHUNK = 4;      // Triggers to re-test, each a pass over every body plus any mesh tests, 1us and up
+
+const float RENDER_DEPTH_BUCKET = 1.0f / 64;  // Depth covered by each bucket in RenderQueue keys, so near objects still sort apart
+const int GL_STATE_TEXTURE_UNITS = 8;         // Texture units GLState shadows. Binding on higher ones always makes the call
+
+const int INSTANCE_TILE_CELLS = 8;  // Static objects are instanced in batches per tile this many cells across, so each can be culled
 
 const float DOOR_SHRINK_FACTOR = 0.9f;
 const float MIN_DOOR_SCALE = 0.005f;
@@ -39,6 +92,7 @@ const float DOOR_ROTATION_SPEED = 0.1f;
 const float KEY_ROTATION_SPEED = 0.005f;
 const float KEY_HEIGHT = 0.15f;
 const int KEY_DROP_PICKUP_COOLDOWN_MS = 3500;
+const float KEY_MASS = 1.0f;
 
 const glm::mat4 world_to_openvr_scale = glm::scale(glm::mat4(), glm::vec3(1.5, 1.5, 1.5));
 const glm::mat4 openvr_to_world_rotation = glm::rotate(glm::mat4(), (float)(M_PI / 2.0f), glm::vec3(1, 0, 0));
@@ -1,117 +1,152 @@
-#include <gtc/type_ptr.hpp>
 #include "constants.h"
 #include "controller.h"
-#include "shader_manager.h"
+#include "map.h"
 #include "vr_input_manager.h"
 #include "vr_manager.h"
 
 Controller::Controller() {
-    glm::vec3 tip_pos = transform->WorldPosition();
-    glm::vec3 lower = tip_pos - CONTROLLER_TIP_COLLIDER_HALF_DIAGONAL;
-    glm::vec3 upper = tip_pos + CONTROLLER_TIP_COLLIDER_HALF_DIAGONAL;
-    std::vector<glm::vec3> points = {lower, upper};
-
-    bounding_box_ = std::make_shared<BoundingBox>(points);
-    bounding_box_->transform->SetParent(transform);
+    UpdateWorldBounds();
 }
 
-void Controller::Render(const glm::mat4& worldViewMatrix) const {
-    if (!show_controller || !render_model) {
+void Controller::PollInput(HandInput* input) {
+    vr::InputDigitalActionData_t action_data;
+    bool grab_changed = VRInputManager::GetDigitalActionDataEdge(action_grab, action_data);
+    input->grab_pressed = grab_changed && action_data.bState;
+    input->grab_released = grab_changed && !action_data.bState;
+    input->grab_held = action_data.bState;
+
+    vr::InputPoseActionData_t poseData;
+    if (vr::VRInput()->GetPoseActionData(action_pose, vr::TrackingUniverseStanding, 0, &poseData, sizeof(poseData),
+                                         vr::k_ulInvalidInputValueHandle) != vr::VRInputError_None ||
+        !poseData.bActive || !poseData.pose.bPoseIsValid) {
+        input->pose_valid = false;
+        show_controller = false;
         return;
     }
 
-    glUseProgram(ShaderManager::RenderModel_Shader);
-    const glm::mat4& matDeviceToTracking = transform->WorldTransform();
-    glm::mat4 matMVP = worldViewMatrix * matDeviceToTracking;
-    glUniformMatrix4fv(glGetUniformLocation(ShaderManager::RenderModel_Shader, "matrix"), 1, GL_FALSE, glm::value_ptr(matMVP));
+    input->pose_valid = true;
+    input->pose = VRManager::ConvertSteamVRMatrixToMat4(poseData.pose.mDeviceToAbsoluteTracking);
+    const float* velocity = poseData.pose.vVelocity.v;
+    const float* angular_velocity = poseData.pose.vAngularVelocity.v;
+    input->velocity = glm::vec3(velocity[0], velocity[1], velocity[2]);
+    input->angular_velocity = glm::vec3(angular_velocity[0], angular_velocity[1], angular_velocity[2]);
 
-    render_model->Draw();
-    // bounding_box_->Render();
-}
+    vr::InputOriginInfo_t originInfo;
+    if (vr::VRInput()->GetOriginTrackedDeviceInfo(poseData.activeOrigin, &originInfo, sizeof(originInfo)) == vr::VRInputError_None &&
+        originInfo.trackedDeviceIndex != vr::k_unTrackedDeviceIndexInvalid) {
+        FrameString sRenderModelName = VRManager::GetTrackedDeviceString(originInfo.trackedDeviceIndex, vr::Prop_RenderModelName_String);
+        if (render_model_name != sRenderModelName.c_str()) {  // Only copied to the heap when the model actually changes
+            render_model_name = sRenderModelName.c_str();
+        }
 
-void Controller::HandleInput() {
-    // Check for grab action
-    vr::InputDigitalActionData_t action_data;
-    if (VRInputManager::GetDigitalActionDataEdge(action_grab, action_data)) {
-        if (action_data.bState) {  // Just grabbed
-            printf("Grabbed!\n");
-            Grab();
-        } else {  // Just ungrabbed
-            printf("Ungrabbed!\n");
-            Ungrab();
+        if (held_key_ == nullptr) {
+            show_controller = true;
+        } else {
+            show_controller = false;
         }
     }
+}
 
-    if (action_data.bState && input_manager->map_->fractal_->holder_ != nullptr && input_manager->map_->fractal_->holder_ != this) {
-        input_manager->map_->fractal_->transform->Scale(glm::vec3(1.01,1,1.01));
+void Controller::ApplyInput(const HandInput& input) {
+    if (input.grab_pressed) {
+        printf("Grabbed!\n");
+        Grab();
+    } else if (input.grab_released) {
+        printf("Ungrabbed!\n");
+        Ungrab();
     }
 
-    // Update pose
-    vr::InputPoseActionData_t poseData;
-    if (vr::VRInput()->GetPoseActionData(action_pose, vr::TrackingUniverseStanding, 0, &poseData, sizeof(poseData),
-                                         vr::k_ulInvalidInputValueHandle) != vr::VRInputError_None ||
-        !poseData.bActive || !poseData.pose.bPoseIsValid) {
-        show_controller = false;
-    } else {
-        raw_pose = VRManager::ConvertSteamVRMatrixToMat4(poseData.pose.mDeviceToAbsoluteTracking);
-        transform->Set(openvr_to_world * raw_pose);
-
-        vr::InputOriginInfo_t originInfo;
-        if (vr::VRInput()->GetOriginTrackedDeviceInfo(poseData.activeOrigin, &originInfo, sizeof(originInfo)) == vr::VRInputError_None &&
-            originInfo.trackedDeviceIndex != vr::k_unTrackedDeviceIndexInvalid) {
-            std::string sRenderModelName =
-                VRManager::GetTrackedDeviceString(originInfo.trackedDeviceIndex, vr::Prop_RenderModelName_String);
-            if (sRenderModelName != render_model_name) {
-                render_model = input_manager->FindOrLoadRenderModel(sRenderModelName.c_str());
-                render_model_name = sRenderModelName;
-            }
-
-            if (held_key_ == nullptr) {
-                show_controller = true;
-            } else {
-                show_controller = false;
-            }
-        }
+    Fractal* fractal = map_ != nullptr ? map_->fractal_ : nullptr;
+    if (input.grab_held && fractal != nullptr && fractal->holder_ != nullptr && fractal->holder_ != this) {
+        fractal->transform->Scale(glm::vec3(1.01,1,1.01));
     }
+
+    if (!input.pose_valid) {
+        velocity_ = angular_velocity_ = glm::vec3(0);
+        return;
+    }
+
+    raw_pose = input.pose;
+    transform->Set(openvr_to_world * raw_pose);
+    UpdateWorldBounds();
+    velocity_ = glm::mat3(openvr_to_world) * input.velocity;  // Scaled into world units
+    angular_velocity_ = glm::mat3(openvr_to_world_rotation) * input.angular_velocity;
+}
+
+void Controller::Extract(ControllerSnapshot* snapshot) const {
+    snapshot->visible = show_controller && !render_model_name.empty();
+    snapshot->world_transform = transform->WorldTransform();
+    snapshot->render_model_name = render_model_name;  // Copies into the snapshot's existing storage
+}
+
+void Controller::OnTriggerEnter(GameObject* other) {
+    UpdateInRange();
+}
+
+void Controller::OnTriggerExit(GameObject* other) {
+    UpdateInRange();
+}
+
+void Controller::UpdateInRange() {
+    key_in_range_ = static_cast<Key*>(triggers_->FirstOverlap(trigger_, BROADPHASE_KEY));  // Only keys are in the key category
+    fractal_in_range_ = triggers_->FirstOverlap(trigger_, BROADPHASE_FRACTAL) != nullptr;
 }
 
 void Controller::Grab() {
-    Key* key = input_manager->map_->FirstIntersectedKey(*bounding_box_);
-    if (key != nullptr && held_key_ == nullptr) {
-        held_key_ = key;
+    if (key_in_range_ != nullptr && key_in_range_->CanBePickedUp() && held_key_ == nullptr) {
+        held_key_ = key_in_range_;
         held_key_->SetHolder(this);
 
-        held_key_->transform->ResetAndSetTranslation(glm::vec3(0));
-        held_key_->transform->Rotate(M_PI / 2, glm::vec3(1, 0, 0));
-        held_key_->transform->Rotate(M_PI / 2, glm::vec3(0, 1, 0));
-        held_key_->transform->Translate(glm::vec3(-0.01, -0.15, 0));
-        held_key_->transform->SetParent(transform);
+        held_key_->transform->SetParent(transform, TransformBuilder()
+                                                        .Rotate(M_PI / 2, glm::vec3(1, 0, 0))
+                                                        .Rotate(M_PI / 2, glm::vec3(0, 1, 0))
+                                                        .Translate(glm::vec3(-0.01, -0.15, 0)));
     } else {
-        Fractal* fractal = input_manager->map_->fractal_;
-        if (fractal->IntersectsWith(*bounding_box_) && fractal->holder_ == nullptr) {
+        Fractal* fractal = map_ != nullptr ? map_->fractal_ : nullptr;
+        if (fractal != nullptr && fractal_in_range_ && fractal->holder_ == nullptr) {
             fractal->holder_ = this;
-            fractal->transform->ResetAndSetTranslation(glm::vec3(0,0,-0.2));
-            fractal->transform->Scale(0.3f);
-            fractal->transform->SetParent(transform);
+            fractal->transform->SetParent(transform, TransformBuilder(glm::vec3(0, 0, -0.2)).Scale(0.3f));
         }
     }
 }
 
 void Controller::Ungrab() {
-    if (input_manager->map_->fractal_->holder_ == this) {
-        Fractal* fractal = input_manager->map_->fractal_;
+    Fractal* fractal = map_ != nullptr ? map_->fractal_ : nullptr;
+    if (fractal != nullptr && fractal->holder_ == this) {
         glm::vec3 previous_pos = glm::vec3(fractal->transform->X(), fractal->transform->Y(), fractal->transform->Z());
         fractal->transform->ClearParent();
-        fractal->transform->ResetAndSetTranslation(previous_pos);
-        fractal->transform->Scale(0.3f);
+        fractal->transform->Set(TransformBuilder(previous_pos).Scale(0.3f));
         fractal->holder_ = nullptr;
     }
     if (held_key_ == nullptr) return;
 
-    held_key_->Drop();
+    // The pose's velocity is the tracked origin's, and the key is out at the end of a lever from it
+    glm::vec3 lever = held_key_->world_bounds.Center() - transform->WorldPosition();
+    held_key_->Drop(velocity_ + glm::cross(angular_velocity_, lever), angular_velocity_);
     held_key_ = nullptr;
 }
 
 void Controller::UseKey() {
     held_key_ = nullptr;
 }
+
+void Controller::SetMap(Map* map) {
+    map_ = map;
+    held_key_ = nullptr;
+    key_in_range_ = nullptr;
+    fractal_in_range_ = false;
+
+    triggers_ = map != nullptr ? &map->Triggers() : nullptr;
+    if (triggers_ != nullptr) {
+        trigger_ = triggers_->AddTrigger(world_bounds_, BROADPHASE_KEY | BROADPHASE_FRACTAL, this);
+        triggers_->SetTriggerPrecise(trigger_, true);  // Grabbing the empty air inside a key's box shouldn't pick it up
+    }
+}
+
+void Controller::UpdateWorldBounds() {
+    // Follows the tip's position and scale but not its rotation, so the grab volume doesn't swing around with the wrist
+    glm::vec3 tip_pos = transform->WorldPosition();
+    glm::vec3 half_diagonal = CONTROLLER_TIP_COLLIDER_HALF_DIAGONAL * transform->GetScale();
+    world_bounds_ = BoundingBox(tip_pos - half_diagonal, tip_pos + half_diagonal);
+    if (triggers_ != nullptr) triggers_->MoveTrigger(trigger_, world_bounds_);
+}
@@ -1,23 +1,46 @@
 #pragma once
 #include <OpenVR/openvr.h>
+#include <string>
 #include "bounding_box.h"
 #include "glm.hpp"
 #include "key.h"
-#include "render_model.h"
 #include "transformable.h"
+#include "trigger_system.h"
 
-class VRInputManager;
+class Map;
 
-class Controller {
+// What the render thread needs to draw a controller, copied out of the simulation each tick
+struct ControllerSnapshot {
+    bool visible = false;
+    glm::mat4 world_transform;
+    std::string render_model_name;  // The render thread loads the model, since that needs the GL context
+};
+
+// One hand's input for a simulation tick, as read from OpenVR. It's all the simulation sees of the hand, so it can be recorded
+// and played back
+struct HandInput {
+    bool grab_pressed = false, grab_released = false;  // Since the last tick
+    bool grab_held = false;
+    bool pose_valid = false;
+    glm::mat4 pose;  // Device to tracking space
+    glm::vec3 velocity, angular_velocity;  // In tracking space
+};
+
+// Keeps track of what's in grab range through a trigger around its tip, so grabbing doesn't have to search for anything
+class Controller : public TriggerListener {
    public:
     Controller();
 
-    void Render(const glm::mat4& worldViewMatrix) const;
-    void HandleInput();
+    void PollInput(HandInput* input);  // Reads the hand's actions and pose from OpenVR, and keeps the render model up to date
+    void ApplyInput(const HandInput& input);
+    void Extract(ControllerSnapshot* snapshot) const;
+    void OnTriggerEnter(GameObject* other) override;
+    void OnTriggerExit(GameObject* other) override;
 
     void Grab();
     void Ungrab();
     void UseKey();
+    void SetMap(Map* map);  // Lets go of anything from the previous map, which may have been unloaded out from under the controller
 
     vr::VRInputValueHandle_t source = vr::k_ulInvalidInputValueHandle;
     vr::VRActionHandle_t action_pose = vr::k_ulInvalidActionHandle;
@@ -25,12 +48,21 @@ class Controller {
     vr::VRActionHandle_t action_grab = vr::k_ulInvalidActionHandle;
     glm::mat4 raw_pose;
     std::shared_ptr<Transformable> transform = std::make_shared<Transformable>();
-    RenderModel* render_model = nullptr;
     std::string render_model_name;
-    bool show_controller;
-    VRInputManager* input_manager;
+    bool show_controller = false;
 
    private:
-    std::shared_ptr<BoundingBox> bounding_box_;
+    void UpdateWorldBounds();
+
+    void UpdateInRange();
+
+    BoundingBox world_bounds_;
+    Map* map_ = nullptr;
     Key* held_key_ = nullptr;
+    TriggerSystem* triggers_ = nullptr;  // The current map's
+    int trigger_ = -1;
+    Key* key_in_range_ = nullptr;
+    bool fractal_in_range_ = false;
+    glm::vec3 velocity_ = glm::vec3(0);  // In world space, as of the last pose, so a dropped key can be thrown
+    glm::vec3 angular_velocity_ = glm::vec3(0);
 };
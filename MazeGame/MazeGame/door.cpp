@@ -1,7 +1,9 @@
+#include <cmath>
 #include "constants.h"
 #include "door.h"
+#include "map.h"
 
-Door::Door(Model* model, char id) : GameObject(model) {
+Door::Door(Model* model, Map* map, char id) : GameObject(model, map) {
     id_ = id;
 }
 
@@ -10,20 +12,23 @@ bool Door::MatchesId(char id) {
 }
 
 void Door::GoAway() {
+    if (is_going_away) return;
     is_going_away = true;
+
+    // Moving it out of the maze once it's gone isn't the 'right' way to do this but it works
+    map_->Tasks().Animate(this, [this](float dt) { return Shrink(dt); }, [this] { transform->Translate(0, 0, -1000); });
 }
 
-void Door::Update() {
-    if (is_going_away) {
-        scale *= DOOR_SHRINK_FACTOR;
-        transform->Scale(DOOR_SHRINK_FACTOR);
-        transform->Rotate(DOOR_ROTATION_SPEED, glm::vec3(0, 1, 1));
-    }
+bool Door::IsGoingAway() const {
+    return is_going_away;
+}
 
-    if (scale < MIN_DOOR_SCALE) {
-        is_going_away = false;
-        transform->Translate(0, 0, -1000);  // This isn't the 'right' way to do this but it works
-    }
+bool Door::Shrink(float dt) {
+    float steps = dt / REFERENCE_STEP;
+    float shrink = std::pow(DOOR_SHRINK_FACTOR, steps);
+    scale *= shrink;
+    transform->Scale(shrink);
+    transform->Rotate(DOOR_ROTATION_SPEED * steps, glm::vec3(0, 1, 1));
 
-    GameObject::Update();
+    return scale >= MIN_DOOR_SCALE;
 }
@@ -1,9 +1,11 @@
 #pragma once
 #include "game_object.h"
 
-class Door : public GameObject {
+class Map;
+
+class Door final : public GameObject {
    public:
-    Door(Model* model, char id);
+    Door(Model* model, Map* map, char id);
     ~Door() = default;
 
     bool IsSolid() override {
@@ -11,11 +13,12 @@ class Door : public GameObject {
     }
 
     bool MatchesId(char id);
-    void GoAway();
-
-    void Update() override;
+    void GoAway();  // Shrinks and spins out of the way, then leaves the maze
+    bool IsGoingAway() const;
 
    private:
+    bool Shrink(float dt);  // One tick of going away. Returns whether there's more to go
+
     char id_;
     bool is_going_away = false;
     float scale = 1.0f;
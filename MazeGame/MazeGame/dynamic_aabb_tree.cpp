@@ -0,0 +1,303 @@
+#include <algorithm>
+#include "dynamic_aabb_tree.h"
+
+using glm::vec3;
+
+const int DynamicAabbTree::NULL_NODE;
+const int DynamicAabbTree::FREE_NODE;
+constexpr float DynamicAabbTree::FAT_MARGIN;
+constexpr float DynamicAabbTree::DISPLACEMENT_MULTIPLIER;
+
+DynamicAabbTree::DynamicAabbTree(Arena* arena)
+    : nodes_(ArenaAllocator<Node>(arena)), root_(NULL_NODE), free_list_(NULL_NODE), proxy_count_(0) {
+    nodes_.reserve(64);
+}
+
+int DynamicAabbTree::CreateProxy(const BoundingBox& bounds, uint32_t categories, GameObject* object) {
+    int leaf = AllocateNode();
+    Node& node = nodes_[leaf];
+    node.bounds = bounds;
+    node.fat_bounds = Fatten(bounds, vec3(0), FAT_MARGIN);
+    node.categories = categories;
+    node.object = object;
+
+    InsertLeaf(leaf);
+    proxy_count_++;
+    return leaf;
+}
+
+void DynamicAabbTree::DestroyProxy(int proxy) {
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    proxy_count_--;
+}
+
+bool DynamicAabbTree::MoveProxy(int proxy, const BoundingBox& bounds, const vec3& displacement) {
+    Node& node = nodes_[proxy];
+    node.bounds = bounds;
+
+    BoundingBox fat_bounds = Fatten(bounds, displacement, FAT_MARGIN);
+    if (node.fat_bounds.Contains(bounds)) {
+        // Still inside, but an object that stopped after moving fast would keep a needlessly huge box, so shrink that too
+        BoundingBox largest_allowed = Fatten(fat_bounds, vec3(0), 4 * FAT_MARGIN);
+        if (largest_allowed.Contains(node.fat_bounds)) return false;
+    }
+
+    RemoveLeaf(proxy);
+    nodes_[proxy].fat_bounds = fat_bounds;
+    InsertLeaf(proxy);
+    return true;
+}
+
+GameObject* DynamicAabbTree::Object(int proxy) const {
+    return nodes_[proxy].object;
+}
+
+const BoundingBox& DynamicAabbTree::Bounds(int proxy) const {
+    return nodes_[proxy].bounds;
+}
+
+uint32_t DynamicAabbTree::Categories(int proxy) const {
+    return nodes_[proxy].categories;
+}
+
+int DynamicAabbTree::Nearest(const vec3& point, float max_distance, uint32_t category_mask, float* distance) const {
+    int nearest = NULL_NODE;
+    if (root_ == NULL_NODE) return nearest;
+
+    NodeStack stack;
+    stack.Push(root_);
+    while (!stack.Empty()) {
+        const Node& node = nodes_[stack.Pop()];
+        if (!(node.categories & category_mask) || node.fat_bounds.DistanceTo(point) > max_distance) continue;
+
+        if (node.IsLeaf()) {
+            float leaf_distance = node.bounds.DistanceTo(point);
+            if (leaf_distance <= max_distance) {
+                max_distance = leaf_distance;
+                nearest = static_cast<int>(&node - nodes_.data());
+            }
+            continue;
+        }
+
+        // Visit the closer child first, so the search bound shrinks as early as possible
+        float distance1 = nodes_[node.child1].fat_bounds.DistanceTo(point);
+        float distance2 = nodes_[node.child2].fat_bounds.DistanceTo(point);
+        stack.Push(distance1 < distance2 ? node.child2 : node.child1);
+        stack.Push(distance1 < distance2 ? node.child1 : node.child2);
+    }
+
+    if (nearest != NULL_NODE && distance != nullptr) *distance = max_distance;
+    return nearest;
+}
+
+void DynamicAabbTree::FindPairs(FrameVector<std::pair<int, int>>& pairs) const {
+    for (int i = 0; i < static_cast<int>(nodes_.size()); i++) {
+        if (nodes_[i].IsFree() || !nodes_[i].IsLeaf()) continue;
+
+        Query(nodes_[i].bounds, ~0u, [&](int other) {
+            if (other > i) pairs.push_back(std::make_pair(i, other));
+            return false;
+        });
+    }
+}
+
+int DynamicAabbTree::ProxyCount() const {
+    return proxy_count_;
+}
+
+float DynamicAabbTree::Cost() const {
+    float cost = 0;
+    for (const Node& node : nodes_) {
+        if (!node.IsFree() && !node.IsLeaf()) cost += node.fat_bounds.SurfaceArea();
+    }
+
+    return cost;
+}
+
+int DynamicAabbTree::AllocateNode() {
+    int index;
+    if (free_list_ == NULL_NODE) {
+        nodes_.push_back(Node());
+        index = static_cast<int>(nodes_.size()) - 1;
+    } else {
+        index = free_list_;
+        free_list_ = nodes_[index].parent;
+    }
+
+    Node& node = nodes_[index];
+    node.parent = node.child1 = node.child2 = NULL_NODE;
+    node.categories = 0;
+    node.object = nullptr;
+    return index;
+}
+
+void DynamicAabbTree::FreeNode(int node) {
+    nodes_[node].parent = free_list_;
+    nodes_[node].child2 = FREE_NODE;
+    free_list_ = node;
+}
+
+void DynamicAabbTree::InsertLeaf(int leaf) {
+    if (root_ == NULL_NODE) {
+        root_ = leaf;
+        nodes_[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    int sibling = FindBestSibling(nodes_[leaf].fat_bounds);
+    int old_parent = nodes_[sibling].parent;
+    int new_parent = AllocateNode();  // Can move nodes_, so no references are held across it
+
+    nodes_[new_parent].parent = old_parent;
+    nodes_[new_parent].child1 = sibling;
+    nodes_[new_parent].child2 = leaf;
+    nodes_[sibling].parent = new_parent;
+    nodes_[leaf].parent = new_parent;
+
+    if (old_parent == NULL_NODE) {
+        root_ = new_parent;
+    } else if (nodes_[old_parent].child1 == sibling) {
+        nodes_[old_parent].child1 = new_parent;
+    } else {
+        nodes_[old_parent].child2 = new_parent;
+    }
+
+    RefitAncestors(new_parent);
+}
+
+void DynamicAabbTree::RemoveLeaf(int leaf) {
+    if (leaf == root_) {
+        root_ = NULL_NODE;
+        return;
+    }
+
+    int parent = nodes_[leaf].parent;
+    int grandparent = nodes_[parent].parent;
+    int sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+    // The sibling takes the parent's place
+    nodes_[sibling].parent = grandparent;
+    FreeNode(parent);
+    if (grandparent == NULL_NODE) {
+        root_ = sibling;
+        return;
+    }
+
+    if (nodes_[grandparent].child1 == parent) {
+        nodes_[grandparent].child1 = sibling;
+    } else {
+        nodes_[grandparent].child2 = sibling;
+    }
+    RefitAncestors(grandparent);
+}
+
+int DynamicAabbTree::FindBestSibling(const BoundingBox& bounds) const {
+    int index = root_;
+    while (!nodes_[index].IsLeaf()) {
+        const Node& node = nodes_[index];
+        float combined_area = Union(node.fat_bounds, bounds).SurfaceArea();
+
+        // Cost of pairing the new leaf with this whole subtree, versus the growth every ancestor of a deeper sibling would see
+        float cost = 2 * combined_area;
+        float inheritance_cost = 2 * (combined_area - node.fat_bounds.SurfaceArea());
+
+        float child_costs[2];
+        int children[2] = {node.child1, node.child2};
+        for (int i = 0; i < 2; i++) {
+            const Node& child = nodes_[children[i]];
+            child_costs[i] = Union(child.fat_bounds, bounds).SurfaceArea() + inheritance_cost;
+            if (!child.IsLeaf()) child_costs[i] -= child.fat_bounds.SurfaceArea();  // Only its growth is new cost
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1]) break;
+        index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+    }
+
+    return index;
+}
+
+void DynamicAabbTree::RefitAncestors(int node) {
+    while (node != NULL_NODE) {
+        Rotate(node);
+        Refit(node);
+        node = nodes_[node].parent;
+    }
+}
+
+void DynamicAabbTree::Refit(int node) {
+    const Node& child1 = nodes_[nodes_[node].child1];
+    const Node& child2 = nodes_[nodes_[node].child2];
+    nodes_[node].fat_bounds = Union(child1.fat_bounds, child2.fat_bounds);
+    nodes_[node].categories = child1.categories | child2.categories;
+}
+
+void DynamicAabbTree::Rotate(int node) {
+    int b = nodes_[node].child1;
+    int c = nodes_[node].child2;
+
+    // Swapping a child with one of its sibling's children leaves this node's box alone, but changes the sibling's. Take
+    // whichever swap shrinks it most, if any does
+    float best_area_saved = 0;
+    int parent_of_first = NULL_NODE, first = NULL_NODE, parent_of_second = NULL_NODE, second = NULL_NODE;
+    int pairs[2][2] = {{b, c}, {c, b}};
+    for (auto& pair : pairs) {
+        int child = pair[0];
+        int sibling = pair[1];
+        if (nodes_[sibling].IsLeaf()) continue;
+
+        float sibling_area = nodes_[sibling].fat_bounds.SurfaceArea();
+        int nephews[2] = {nodes_[sibling].child1, nodes_[sibling].child2};
+        for (int i = 0; i < 2; i++) {
+            // child trades places with nephews[i], so the sibling ends up around the child and the other nephew
+            float area_saved = sibling_area - Union(nodes_[child].fat_bounds, nodes_[nephews[1 - i]].fat_bounds).SurfaceArea();
+            if (area_saved > best_area_saved) {
+                best_area_saved = area_saved;
+                parent_of_first = node;
+                first = child;
+                parent_of_second = sibling;
+                second = nephews[i];
+            }
+        }
+    }
+
+    if (first == NULL_NODE) return;
+
+    SwapNodes(parent_of_first, first, parent_of_second, second);
+    Refit(parent_of_second);
+}
+
+void DynamicAabbTree::SwapNodes(int parent_of_first, int first, int parent_of_second, int second) {
+    Node& first_parent = nodes_[parent_of_first];
+    Node& second_parent = nodes_[parent_of_second];
+    (first_parent.child1 == first ? first_parent.child1 : first_parent.child2) = second;
+    (second_parent.child1 == second ? second_parent.child1 : second_parent.child2) = first;
+    nodes_[first].parent = parent_of_second;
+    nodes_[second].parent = parent_of_first;
+}
+
+BoundingBox DynamicAabbTree::Fatten(const BoundingBox& bounds, const vec3& displacement, float margin) {
+    vec3 stretch = DISPLACEMENT_MULTIPLIER * displacement;
+    vec3 min = bounds.Min() - vec3(margin) + glm::min(stretch, vec3(0));
+    vec3 max = bounds.Max() + vec3(margin) + glm::max(stretch, vec3(0));
+    return BoundingBox(min, max);
+}
+
+BoundingBox DynamicAabbTree::Union(const BoundingBox& a, const BoundingBox& b) {
+    BoundingBox combined = a;
+    combined.ExpandToBound(b);
+    return combined;
+}
+
+bool DynamicAabbTree::RayHitsBox(const vec3& origin, const vec3& inverse_direction, const BoundingBox& bounds, float max_distance,
+                                 float* entry_distance) {
+    vec3 to_min = (bounds.Min() - origin) * inverse_direction;
+    vec3 to_max = (bounds.Max() - origin) * inverse_direction;
+    vec3 slab_entry = glm::min(to_min, to_max);
+    vec3 slab_exit = glm::max(to_min, to_max);
+
+    float entry = std::max(std::max(slab_entry.x, slab_entry.y), std::max(slab_entry.z, 0.0f));
+    float exit = std::min(std::min(slab_exit.x, slab_exit.y), slab_exit.z);
+    *entry_distance = entry;
+    return entry <= exit && entry <= max_distance;
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "arena.h"
+#include "bounding_box.h"
+#include "frame_allocator.h"
+#include "glm.hpp"
+
+class GameObject;
+
+/**
+ * Bounding volume hierarchy for objects that can be anywhere, like held keys and the fractal, next to the UniformGrid that
+ * covers the maze itself. Leaves store a fattened copy of their box, so an object that moves a little doesn't touch the tree
+ * at all. When one does leave its fat box it's reinserted where the surface area heuristic says it's cheapest, and the nodes
+ * above it are rotated if that makes the tree cheaper to query.
+ */
+class DynamicAabbTree {
+   public:
+    static const int NULL_NODE = -1;
+
+    explicit DynamicAabbTree(Arena* arena);
+
+    int CreateProxy(const BoundingBox& bounds, uint32_t categories, GameObject* object);
+    void DestroyProxy(int proxy);
+    // displacement is how far the object moved since the last update, used to stretch its fat box in the direction it's going.
+    // Returns whether the proxy had to be reinserted
+    bool MoveProxy(int proxy, const BoundingBox& bounds, const glm::vec3& displacement);
+
+    GameObject* Object(int proxy) const;
+    const BoundingBox& Bounds(int proxy) const;  // The box it was last given, not the fat one
+    uint32_t Categories(int proxy) const;
+
+    // Calls callback(proxy) for every proxy in any of the categories whose box overlaps bounds, until the callback returns true.
+    // Returns whether it stopped early
+    template <typename Callback>
+    bool Query(const BoundingBox& bounds, uint32_t category_mask, Callback callback) const;
+
+    // Walks the proxies whose boxes the ray passes through within max_distance. callback(proxy) returns the distance along the
+    // ray at which it actually hits the object, or a negative number if it misses. Returns the nearest proxy that was hit, or
+    // NULL_NODE, and its distance in hit_distance. Distances are in multiples of direction's length
+    template <typename Callback>
+    int RayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, uint32_t category_mask, float* hit_distance,
+                Callback callback) const;
+
+    // The proxy in any of the categories whose box is closest to point, or NULL_NODE if none is within max_distance
+    int Nearest(const glm::vec3& point, float max_distance, uint32_t category_mask, float* distance) const;
+
+    // Every overlapping pair of proxies, each reported once with the lower proxy id first
+    void FindPairs(FrameVector<std::pair<int, int>>& pairs) const;
+
+    int ProxyCount() const;
+    float Cost() const;  // Total surface area of the internal nodes, which is what the heuristic is trying to keep low
+
+   private:
+    // Extra room given to every fat box, and how many frames of motion to stretch it by
+    static constexpr float FAT_MARGIN = 0.1f;
+    static constexpr float DISPLACEMENT_MULTIPLIER = 2.0f;
+    static const int FREE_NODE = -2;
+
+    struct Node {
+        BoundingBox fat_bounds;
+        BoundingBox bounds;  // Leaves only
+        int parent;          // Doubles as the next free node when this one is unused
+        int child1, child2;
+        uint32_t categories;  // For internal nodes, every category below them, so whole subtrees can be skipped
+        GameObject* object;
+
+        bool IsLeaf() const {
+            return child1 == NULL_NODE;
+        }
+
+        bool IsFree() const {
+            return child2 == FREE_NODE;
+        }
+    };
+
+    // Traversal stack that only touches the heap for trees deeper than it expects
+    class NodeStack {
+       public:
+        NodeStack() : size_(0) {}
+
+        void Push(int node) {
+            if (size_ < FIXED_SIZE) {
+                fixed_[size_] = node;
+            } else {
+                overflow_.push_back(node);
+            }
+            size_++;
+        }
+
+        int Pop() {
+            size_--;
+            if (size_ < FIXED_SIZE) return fixed_[size_];
+
+            int node = overflow_.back();
+            overflow_.pop_back();
+            return node;
+        }
+
+        bool Empty() const {
+            return size_ == 0;
+        }
+
+       private:
+        static const int FIXED_SIZE = 64;
+        int fixed_[FIXED_SIZE];
+        std::vector<int> overflow_;
+        int size_;
+    };
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int FindBestSibling(const BoundingBox& bounds) const;
+    void RefitAncestors(int node);  // Recomputes boxes from node up to the root, rotating as it goes
+    void Refit(int node);
+    void Rotate(int node);
+    void SwapNodes(int parent_of_first, int first, int parent_of_second, int second);
+
+    static BoundingBox Fatten(const BoundingBox& bounds, const glm::vec3& displacement, float margin);
+    static BoundingBox Union(const BoundingBox& a, const BoundingBox& b);
+    static bool RayHitsBox(const glm::vec3& origin, const glm::vec3& inverse_direction, const BoundingBox& bounds, float max_distance,
+                           float* entry_distance);
+
+    ArenaVector<Node> nodes_;
+    int root_;
+    int free_list_;
+    int proxy_count_;
+};
+
+template <typename Callback>
+bool DynamicAabbTree::Query(const BoundingBox& bounds, uint32_t category_mask, Callback callback) const {
+    if (root_ == NULL_NODE) return false;
+
+    NodeStack stack;
+    stack.Push(root_);
+    while (!stack.Empty()) {
+        int index = stack.Pop();
+        const Node& node = nodes_[index];
+        if (!(node.categories & category_mask) || !node.fat_bounds.ContainsOrIntersects(bounds)) continue;
+
+        if (!node.IsLeaf()) {
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+        } else if (node.bounds.ContainsOrIntersects(bounds) && callback(index)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template <typename Callback>
+int DynamicAabbTree::RayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, uint32_t category_mask,
+                             float* hit_distance, Callback callback) const {
+    int nearest = NULL_NODE;
+    if (root_ == NULL_NODE) return nearest;
+
+    glm::vec3 inverse_direction = 1.0f / direction;  // Infinite along axes the ray doesn't move on, which the slab test handles
+    NodeStack stack;
+    stack.Push(root_);
+    while (!stack.Empty()) {
+        int index = stack.Pop();
+        const Node& node = nodes_[index];
+        float entry;
+        if (!(node.categories & category_mask) || !RayHitsBox(origin, inverse_direction, node.fat_bounds, max_distance, &entry)) continue;
+
+        if (!node.IsLeaf()) {
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+            continue;
+        }
+
+        float distance = callback(index);
+        if (distance >= 0 && distance <= max_distance) {
+            max_distance = distance;  // Anything further away than this hit can be skipped now
+            nearest = index;
+        }
+    }
+
+    if (nearest != NULL_NODE && hit_distance != nullptr) *hit_distance = max_distance;
+    return nearest;
+}
@@ -3,7 +3,7 @@
 
 class Controller;
 
-class Fractal : public GameObject {
+class Fractal final : public GameObject {
    public:
     Fractal(Model* model) : GameObject(model) {}
     ~Fractal() = default;
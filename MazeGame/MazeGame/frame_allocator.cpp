@@ -0,0 +1,23 @@
+#include "frame_allocator.h"
+
+void* FrameAllocator::Allocate(size_t size, size_t alignment) {
+    return arena_.Allocate(size, alignment);
+}
+
+void FrameAllocator::Reset() {
+    size_t used = arena_.BytesUsed();
+    if (used > high_water_mark_) high_water_mark_ = used;
+
+    arena_.Reset();
+}
+
+size_t FrameAllocator::BytesUsed() {
+    return arena_.BytesUsed();
+}
+
+size_t FrameAllocator::HighWaterMark() {
+    return high_water_mark_;
+}
+
+thread_local Arena FrameAllocator::arena_(256 * 1024);
+thread_local size_t FrameAllocator::high_water_mark_ = 0;
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "arena.h"
+
+/**
+ * Scratch memory that only has to last until the end of the current frame. Allocating is a pointer bump with no heap lock, and
+ * VRManager::RenderFrame() calls Reset() once everything for the frame is done, which frees it all at once.
+ * Nothing allocated here may be kept past that point. Each thread has its own arena, so the simulation thread resets its
+ * scratch memory after every tick instead, independently of the frames.
+ */
+class FrameAllocator {
+   public:
+    static void* Allocate(size_t size, size_t alignment);
+    static void Reset();
+
+    static size_t BytesUsed();
+    static size_t HighWaterMark();  // The most any one frame on this thread has used so far
+
+   private:
+    static thread_local Arena arena_;
+    static thread_local size_t high_water_mark_;
+};
+
+// Stateless, so it can be default constructed wherever a standard container expects an allocator
+template <typename T>
+class FrameAllocatorAdapter {
+   public:
+    typedef T value_type;
+
+    FrameAllocatorAdapter() = default;
+    template <typename U>
+    FrameAllocatorAdapter(const FrameAllocatorAdapter<U>&) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(FrameAllocator::Allocate(sizeof(T) * count, alignof(T)));
+    }
+    void deallocate(T*, size_t) {}  // Freed by FrameAllocator::Reset()
+
+    template <typename U>
+    bool operator==(const FrameAllocatorAdapter<U>&) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const FrameAllocatorAdapter<U>&) const {
+        return false;
+    }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocatorAdapter<T>>;
+typedef std::basic_string<char, std::char_traits<char>, FrameAllocatorAdapter<char>> FrameString;
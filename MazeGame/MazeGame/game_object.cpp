@@ -2,17 +2,14 @@
 
 #include <algorithm>
 #include <functional>
-#include <gtc/type_ptr.hpp>
 #include "game_object.h"
-#include "glad.h"
 #include "map.h"
-#include "shader_manager.h"
 
 GameObject::GameObject() {
     model_ = nullptr;
     map_ = nullptr;
     texture_index_ = UNTEXTURED;
-    transform = std::make_shared<Transformable>();
+    transform = MakeShared<Transformable>();
 }
 
 GameObject::GameObject(Model* model) : GameObject(model, nullptr) {}
@@ -23,56 +20,91 @@ GameObject::GameObject(Model* model, Map* map) : GameObject() {
     texture_index_ = UNTEXTURED;
     material = Material(glm::vec3(1, 0, 1));
 
-    InitBoundingBox(model->Vertices());
+    model_bounds = model->Bounds();
+    UpdateWorldBounds();
 }
 
-GameObject::~GameObject() = default;
+GameObject::~GameObject() {
+    // Unhook from anything outside the level (the headset, a controller holding this), so no one keeps the transform alive
+    // after the level arena it lives in is reset
+    transform->ClearParent();
+    transform->ClearChildren();
+}
 
 void GameObject::SetTextureIndex(TEXTURE texture_index) {
     texture_index_ = texture_index;
 }
 
-void GameObject::Update() {
-    glUseProgram(ShaderManager::Textured_Shader);
-    // glBindVertexArray(model_->model_vao_);
-    if (model_ == nullptr) {
-        printf("GameObject must be given a valid model before calling Update()\n");
-        exit(1);
-    }
-
-    glUniformMatrix4fv(ShaderManager::Attributes.model, 1, GL_FALSE,
-                       glm::value_ptr(transform->WorldTransform()));  // pass model matrix to shader
-    glUniform1i(ShaderManager::Attributes.texID, texture_index_);     // Set which texture to use
-    if (texture_index_ == UNTEXTURED) {
-        glUniform3fv(ShaderManager::Attributes.color, 1, glm::value_ptr(material.color_));  // Update the color, if necessary
-    }
-
-    glDrawArrays(GL_TRIANGLES, model_->vbo_vertex_start_index_, model_->NumVerts());
-    // glBindVertexArray(0);
-    glUseProgram(0);
-
-    // bounding_box_->Render();
+bool GameObject::ExtractRenderPacket(RenderPacket* packet) const {
+    if (model_ == nullptr) return false;
+
+    packet->model_matrix = transform->WorldTransform();
+    packet->color = material.color_;
+    packet->texture = texture_index_;
+    packet->first_vertex = model_->vbo_vertex_start_index_;
+    packet->vertex_count = model_->NumVerts();
+    packet->bounds = model_->Sphere();
+    return true;
 }
 
 bool GameObject::IntersectsWith(const GameObject& other) const {
-    return IntersectsWith(*other.bounding_box_);
+    if (!world_bounds.ContainsOrIntersects(other.world_bounds)) return false;
+
+    return WorldOrientedBounds().Intersects(other.WorldOrientedBounds());  // The AABBs are loose around anything rotated
 }
 
 bool GameObject::IntersectsWith(const BoundingBox& other) const {
-    return bounding_box_->ContainsOrIntersects(other);
+    if (!world_bounds.ContainsOrIntersects(other)) return false;
+
+    return WorldOrientedBounds().Intersects(other);
+}
+
+bool GameObject::MeshIntersects(const GameObject& other) const {
+    if (!IntersectsWith(other)) return false;
+
+    // Each mesh against the other's box. Either test alone is only exact on one side, but between them a mesh has to reach
+    // the other's box and be reached by the other mesh, which is as tight as this needs without testing triangle pairs
+    if (model_ != nullptr && !model_->Bvh().Overlaps(other.WorldOrientedBounds(), transform->WorldTransform())) return false;
+    if (other.model_ != nullptr && !other.model_->Bvh().Overlaps(WorldOrientedBounds(), other.transform->WorldTransform())) return false;
+    return true;
+}
+
+bool GameObject::MeshIntersects(const BoundingBox& other) const {
+    if (!IntersectsWith(other)) return false;
+    if (model_ == nullptr) return true;
+
+    return model_->Bvh().Overlaps(OrientedBoundingBox(other), transform->WorldTransform());
+}
+
+bool GameObject::MeshIntersects(const BoundingSphere& other) const {
+    if (model_ == nullptr) return WorldOrientedBounds().Intersects(BoundingBox(other.center - other.radius, other.center + other.radius));
+    if (!WorldBoundingSphere().Intersects(other)) return false;
+
+    return model_->Bvh().Overlaps(other, transform->WorldTransform());
+}
+
+bool GameObject::RayCastMesh(const glm::vec3& origin, const glm::vec3& direction, float max_distance, float* distance,
+                             glm::vec3* normal) const {
+    if (model_ == nullptr) return world_bounds.RayCast(origin, direction, max_distance, distance, normal);
+
+    float box_distance;
+    glm::vec3 box_normal;
+    bool starts_inside = world_bounds.DistanceTo(origin) == 0;
+    if (!starts_inside && !world_bounds.RayCast(origin, direction, max_distance, &box_distance, &box_normal)) return false;
+
+    return model_->Bvh().RayCast(origin, direction, max_distance, transform->WorldTransform(), distance, normal);
+}
+
+void GameObject::UpdateWorldBounds() {
+    world_bounds = model_bounds.Transformed(transform->WorldTransform());
 }
 
-void GameObject::InitBoundingBox(const std::vector<glm::vec3>& vertices) {
-    std::vector<glm::vec3> world_space_vertices;    // We want the verts in world space
-    world_space_vertices.reserve(vertices.size());  // Preallocate for efficiency
-    for (const auto& vertex : vertices) {           // Convert them one by one
-        world_space_vertices.push_back(ToWorldSpace(vertex));
-    }
+BoundingSphere GameObject::WorldBoundingSphere() const {
+    if (model_ == nullptr) return BoundingSphere{glm::vec3(0), 0};
 
-    bounding_box_ = std::make_shared<BoundingBox>(world_space_vertices);  // Then encompass all verts with a bounding box
-    bounding_box_->transform->SetParent(transform);
+    return model_->Sphere().Transformed(transform->WorldTransform());
 }
 
-glm::vec3 GameObject::ToWorldSpace(const glm::vec3& model_coordinate) const {
-    return glm::vec3(transform->WorldTransform() * glm::vec4(model_coordinate, 1.0));
+OrientedBoundingBox GameObject::WorldOrientedBounds() const {
+    return OrientedBoundingBox(model_bounds, transform->WorldTransform());
 }
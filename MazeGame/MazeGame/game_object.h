@@ -1,6 +1,9 @@
 #pragma once
+#include "arena.h"
 #include "bounding_box.h"
 #include "material.h"
+#include "oriented_bounding_box.h"
+#include "scene_renderer.h"
 #include "model.h"
 #include "texture_manager.h"
 #include "transformable.h"
@@ -17,9 +20,20 @@ class GameObject : public Updatable {
 
     void SetTextureIndex(TEXTURE texture_index);
 
-    void Update() override;
+    void Simulate(float dt) override {}  // Most objects just sit there
+    bool ExtractRenderPacket(RenderPacket* packet) const;  // False if there's nothing to draw
     bool IntersectsWith(const GameObject& other) const;
     bool IntersectsWith(const BoundingBox& other) const;
+    // Narrowphase tests against the model's triangles, for once the broadphase boxes overlap. Objects without a model stand in
+    // with their oriented box
+    bool MeshIntersects(const GameObject& other) const;
+    bool MeshIntersects(const BoundingBox& other) const;
+    bool MeshIntersects(const BoundingSphere& other) const;
+    // BoundingBox::RayCast() against the model's triangles, which a ray starting inside the box can still hit
+    bool RayCastMesh(const glm::vec3& origin, const glm::vec3& direction, float max_distance, float* distance, glm::vec3* normal) const;
+    void UpdateWorldBounds();  // For objects that move and need their bounds before the next Map::UpdateTransformsAndBounds()
+    OrientedBoundingBox WorldOrientedBounds() const;
+    BoundingSphere WorldBoundingSphere() const;  // Around the model, or an empty sphere at the origin for objects without one
     virtual bool IsSolid() {  // To be overriden by child classes
         return false;
     }
@@ -27,11 +41,10 @@ class GameObject : public Updatable {
     Material material;
     std::shared_ptr<Transformable> transform;
 
-   protected:
-    void InitBoundingBox(const std::vector<glm::vec3>& vertices);
-    glm::vec3 ToWorldSpace(const glm::vec3& model_coordinate) const;
+    BoundingBox model_bounds;
+    BoundingBox world_bounds;  // model_bounds around the world transform, as of the last UpdateWorldBounds()
 
-    std::shared_ptr<BoundingBox> bounding_box_;
+   protected:
     Model* model_;
     TEXTURE texture_index_;
     Map* map_;
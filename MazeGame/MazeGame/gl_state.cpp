@@ -0,0 +1,140 @@
+#include "gl_state.h"
+
+namespace {
+const GLuint UNKNOWN = ~0u;  // Not a value any of the shadowed state can have, so the next call always goes through
+}  // namespace
+
+void GLState::Invalidate() {
+    program_ = vao_ = array_buffer_ = active_unit_ = UNKNOWN;
+    for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++) {
+        textures_[unit] = UNKNOWN;
+    }
+    depth_test_ = multisample_ = polygon_mode_ = UNKNOWN;
+    viewport_known_ = false;
+}
+
+void GLState::UseProgram(GLuint program) {
+    if (Changes(&program_, program)) glUseProgram(program);
+}
+
+void GLState::BindVertexArray(GLuint vao) {
+    if (Changes(&vao_, vao)) glBindVertexArray(vao);
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer) {
+    if (target != GL_ARRAY_BUFFER) {
+        Count(true);
+        glBindBuffer(target, buffer);
+    } else if (Changes(&array_buffer_, buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void GLState::ActiveTexture(int unit) {
+    if (Changes(&active_unit_, static_cast<GLuint>(unit))) glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::BindTexture(int unit, GLenum target, GLuint texture) {
+    if (target != GL_TEXTURE_2D || unit >= GL_STATE_TEXTURE_UNITS) {
+        Count(true);
+    } else if (!Changes(&textures_[unit], texture)) {
+        return;
+    }
+
+    ActiveTexture(unit);
+    glBindTexture(target, texture);
+}
+
+void GLState::Enable(GLenum capability) {
+    SetEnabled(capability, true);
+}
+
+void GLState::Disable(GLenum capability) {
+    SetEnabled(capability, false);
+}
+
+void GLState::PolygonMode(GLenum mode) {
+    if (Changes(&polygon_mode_, mode)) glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLState::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    bool same = viewport_known_ && viewport_[0] == x && viewport_[1] == y && viewport_[2] == width && viewport_[3] == height;
+    Count(!same);
+    if (same) return;
+
+    viewport_[0] = x;
+    viewport_[1] = y;
+    viewport_[2] = width;
+    viewport_[3] = height;
+    viewport_known_ = true;
+    glViewport(x, y, width, height);
+}
+
+void GLState::DeleteProgram(GLuint program) {
+    if (program_ == program) program_ = UNKNOWN;
+    glDeleteProgram(program);
+}
+
+void GLState::DeleteVertexArray(GLuint vao) {
+    if (vao_ == vao) vao_ = UNKNOWN;
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GLState::DeleteBuffer(GLuint buffer) {
+    if (array_buffer_ == buffer) array_buffer_ = UNKNOWN;
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLState::EndFrame() {
+    last_frame_counts_ = counts_;
+    counts_ = Counts{0, 0};
+}
+
+GLState::Counts GLState::LastFrameCounts() {
+    return last_frame_counts_;
+}
+
+bool GLState::Changes(GLuint* current, GLuint value) {
+    bool changes = *current != value;
+    Count(changes);
+    *current = value;
+    return changes;
+}
+
+void GLState::SetEnabled(GLenum capability, bool enabled) {
+    GLuint* current = capability == GL_DEPTH_TEST ? &depth_test_ : (capability == GL_MULTISAMPLE ? &multisample_ : nullptr);
+    if (current == nullptr) {
+        Count(true);
+    } else if (!Changes(current, enabled ? GL_TRUE : GL_FALSE)) {
+        return;
+    }
+
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+}
+
+void GLState::Count(bool issued) {
+#ifdef _DEBUG
+    if (issued) {
+        counts_.issued++;
+    } else {
+        counts_.elided++;
+    }
+#endif
+}
+
+GLuint GLState::program_;
+GLuint GLState::vao_;
+GLuint GLState::array_buffer_;
+GLuint GLState::active_unit_;
+GLuint GLState::textures_[GL_STATE_TEXTURE_UNITS];
+GLuint GLState::depth_test_;
+GLuint GLState::multisample_;
+GLuint GLState::polygon_mode_;
+GLint GLState::viewport_[4];
+bool GLState::viewport_known_;
+GLState::Counts GLState::counts_;
+GLState::Counts GLState::last_frame_counts_;
@@ -0,0 +1,59 @@
+#pragma once
+#include "constants.h"
+#include "glad.h"
+
+/**
+ * Shadows the GL state the renderer changes most, so setting something to what it already is doesn't make a call. It only
+ * knows about changes made through it, so everything using the main context should go through it for the state it covers:
+ * the program, VAO, array buffer, 2D texture on each unit, depth test and multisample enables, polygon mode, and viewport.
+ * Other calls pass straight through. Deleting an object through it forgets any binding of it, since GL may hand the name
+ * out again.
+ * Debug builds count the calls made and skipped each frame.
+ */
+class GLState {
+   public:
+    struct Counts {
+        int issued;
+        int elided;
+    };
+
+    // Forgets everything, so the next call for each piece of state is made regardless. Once the context exists, before anything
+    // else, and whenever something else may have used it
+    static void Invalidate();
+
+    static void UseProgram(GLuint program);
+    static void BindVertexArray(GLuint vao);
+    static void BindBuffer(GLenum target, GLuint buffer);  // Only GL_ARRAY_BUFFER is shadowed. The element buffer belongs to the VAO
+    static void ActiveTexture(int unit);
+    // Only makes unit active if it has to bind. A texture that's just been generated is always bound, so glTexParameter() etc.
+    // can follow straight after
+    static void BindTexture(int unit, GLenum target, GLuint texture);
+    static void Enable(GLenum capability);
+    static void Disable(GLenum capability);
+    static void PolygonMode(GLenum mode);  // For front and back faces
+    static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    static void DeleteProgram(GLuint program);
+    static void DeleteVertexArray(GLuint vao);
+    static void DeleteBuffer(GLuint buffer);
+
+    static void EndFrame();          // Starts counting the next frame's calls
+    static Counts LastFrameCounts();  // Always zero outside debug builds
+
+   private:
+    static bool Changes(GLuint* current, GLuint value);  // Counts the call, and records value if it's different
+    static void SetEnabled(GLenum capability, bool enabled);
+    static void Count(bool issued);
+
+    static GLuint program_;
+    static GLuint vao_;
+    static GLuint array_buffer_;
+    static GLuint active_unit_;
+    static GLuint textures_[GL_STATE_TEXTURE_UNITS];
+    static GLuint depth_test_, multisample_;  // Enables, as GL_TRUE or GL_FALSE
+    static GLuint polygon_mode_;
+    static GLint viewport_[4];
+    static bool viewport_known_;
+
+    static Counts counts_, last_frame_counts_;
+};
@@ -1,11 +1,9 @@
 #include "goal.h"
 #include "map.h"
 
-void Goal::Update() {
-    if (map_->IntersectsPlayer(this)) {
+Goal::Goal(Model* model, Map* map) : GameObject(model, map) {
+    map_->Tasks().WhenTriggered(this, BROADPHASE_PLAYER, [this](GameObject* player) {
         printf("Congratulations! You successfully completed the maze!\n");
-        exit(0);
-    }
-
-    GameObject::Update();
+        map_->Complete();  // Whoever's running the map decides what happens next, on its own thread
+    });
 }
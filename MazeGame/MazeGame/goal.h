@@ -3,10 +3,8 @@
 
 class Map;
 
-class Goal : public GameObject {
+class Goal final : public GameObject {
    public:
-    Goal(Model* model, Map* map) : GameObject(model, map) {}
+    Goal(Model* model, Map* map);  // Waits for the player to reach it
     ~Goal() = default;
-
-    void Update() override;
 };
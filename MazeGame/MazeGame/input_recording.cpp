@@ -0,0 +1,138 @@
+#include "input_recording.h"
+
+namespace {
+const char MAGIC[4] = {'M', 'Z', 'I', 'R'};
+const uint32_t VERSION = 1;
+
+// Per tick
+const uint8_t HMD_POSE_VALID = 1 << 0;
+const uint8_t SHADER_MODE_PRESSED = 1 << 1;
+
+// Per hand, shifted up by 4 for the right hand
+const uint8_t GRAB_PRESSED = 1 << 0;
+const uint8_t GRAB_RELEASED = 1 << 1;
+const uint8_t GRAB_HELD = 1 << 2;
+const uint8_t HAND_POSE_VALID = 1 << 3;
+
+template <typename T>
+void WriteValue(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T ReadValue(std::ifstream& file) {
+    T value = T();
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+}  // namespace
+
+bool InputRecorder::Open(const std::string& path, const std::string& map_file) {
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) return false;
+
+    file_.write(MAGIC, sizeof(MAGIC));
+    WriteValue(file_, VERSION);
+    WriteValue(file_, static_cast<uint32_t>(map_file.size()));
+    file_.write(map_file.data(), map_file.size());
+    return true;
+}
+
+void InputRecorder::Write(const TickInput& input, int steps, uint64_t checksum) {
+    uint8_t flags = (input.hmd_pose_valid ? HMD_POSE_VALID : 0) | (input.shader_mode_pressed ? SHADER_MODE_PRESSED : 0);
+    uint8_t hand_flags = 0;
+    for (int hand = 0; hand < 2; hand++) {
+        const HandInput& hand_input = input.hands[hand];
+        uint8_t bits = (hand_input.grab_pressed ? GRAB_PRESSED : 0) | (hand_input.grab_released ? GRAB_RELEASED : 0) |
+                       (hand_input.grab_held ? GRAB_HELD : 0) | (hand_input.pose_valid ? HAND_POSE_VALID : 0);
+        hand_flags |= bits << (4 * hand);
+    }
+
+    WriteValue(file_, static_cast<uint8_t>(steps));  // A tick never runs more than MAX_FRAME_TIME's worth
+    WriteValue(file_, flags);
+    WriteValue(file_, hand_flags);
+    WriteValue(file_, input.keyboard_forward);
+    WriteValue(file_, input.keyboard_right);
+    WriteValue(file_, input.thumbstick_forward);
+    WriteValue(file_, input.thumbstick_right);
+    if (input.hmd_pose_valid) WritePose(input.hmd_pose);
+    for (const HandInput& hand_input : input.hands) {
+        if (!hand_input.pose_valid) continue;
+        WritePose(hand_input.pose);
+        WriteValue(file_, hand_input.velocity);
+        WriteValue(file_, hand_input.angular_velocity);
+    }
+    WriteValue(file_, checksum);
+}
+
+void InputRecorder::Close() {
+    if (file_.is_open()) file_.close();
+}
+
+bool InputRecorder::IsOpen() const {
+    return file_.is_open();
+}
+
+void InputRecorder::WritePose(const glm::mat4& pose) {
+    // OpenVR poses are rigid, so the bottom row is always 0, 0, 0, 1 and needn't be stored
+    for (int column = 0; column < 4; column++) {
+        file_.write(reinterpret_cast<const char*>(&pose[column][0]), 3 * sizeof(float));
+    }
+}
+
+bool InputPlayback::Open(const std::string& path) {
+    file_.open(path, std::ios::binary);
+    if (!file_) return false;
+
+    char magic[sizeof(MAGIC)];
+    file_.read(magic, sizeof(magic));
+    if (!file_ || std::char_traits<char>::compare(magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if (ReadValue<uint32_t>(file_) != VERSION) return false;
+
+    map_file_.resize(ReadValue<uint32_t>(file_));
+    file_.read(&map_file_[0], map_file_.size());
+    return static_cast<bool>(file_);
+}
+
+const std::string& InputPlayback::MapFile() const {
+    return map_file_;
+}
+
+bool InputPlayback::Read(TickInput* input, int* steps, uint64_t* checksum) {
+    *steps = ReadValue<uint8_t>(file_);
+    uint8_t flags = ReadValue<uint8_t>(file_);
+    uint8_t hand_flags = ReadValue<uint8_t>(file_);
+    input->keyboard_forward = ReadValue<float>(file_);
+    input->keyboard_right = ReadValue<float>(file_);
+    input->thumbstick_forward = ReadValue<float>(file_);
+    input->thumbstick_right = ReadValue<float>(file_);
+
+    input->hmd_pose_valid = (flags & HMD_POSE_VALID) != 0;
+    input->shader_mode_pressed = (flags & SHADER_MODE_PRESSED) != 0;
+    if (input->hmd_pose_valid) input->hmd_pose = ReadPose();
+
+    for (int hand = 0; hand < 2; hand++) {
+        HandInput& hand_input = input->hands[hand];
+        uint8_t bits = hand_flags >> (4 * hand);
+        hand_input.grab_pressed = (bits & GRAB_PRESSED) != 0;
+        hand_input.grab_released = (bits & GRAB_RELEASED) != 0;
+        hand_input.grab_held = (bits & GRAB_HELD) != 0;
+        hand_input.pose_valid = (bits & HAND_POSE_VALID) != 0;
+        if (!hand_input.pose_valid) continue;
+
+        hand_input.pose = ReadPose();
+        hand_input.velocity = ReadValue<glm::vec3>(file_);
+        hand_input.angular_velocity = ReadValue<glm::vec3>(file_);
+    }
+    *checksum = ReadValue<uint64_t>(file_);
+
+    return static_cast<bool>(file_);  // A tick cut off partway, like by the game exiting, doesn't count
+}
+
+glm::mat4 InputPlayback::ReadPose() {
+    glm::mat4 pose;  // The identity, so the bottom row is already 0, 0, 0, 1
+    for (int column = 0; column < 4; column++) {
+        file_.read(reinterpret_cast<char*>(&pose[column][0]), 3 * sizeof(float));
+    }
+    return pose;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "vr_input_manager.h"
+
+/**
+ * Writes each tick's input to a compact binary file, along with how many steps the tick ran and the state checksum after them,
+ * so a session can be played back headlessly with InputPlayback. Poses are only written while they're valid, as the 12 floats of
+ * a rigid transform, so a tick with both hands tracked comes to a little over 200 bytes.
+ * Playing a recording made in one build back in another, and comparing checksums, shows whether (and from which tick) the two
+ * simulate differently.
+ */
+class InputRecorder {
+   public:
+    bool Open(const std::string& path, const std::string& map_file);  // False if the file can't be written
+    void Write(const TickInput& input, int steps, uint64_t checksum);
+    void Close();
+    bool IsOpen() const;
+
+   private:
+    void WritePose(const glm::mat4& pose);
+
+    std::ofstream file_;
+};
+
+// Reads back what an InputRecorder wrote, a tick at a time
+class InputPlayback {
+   public:
+    bool Open(const std::string& path);  // False if it can't be read, or isn't a recording this build understands
+    const std::string& MapFile() const;  // The level the recording starts on
+    bool Read(TickInput* input, int* steps, uint64_t* checksum);  // False once there are no more ticks
+
+   private:
+    glm::mat4 ReadPose();
+
+    std::ifstream file_;
+    std::string map_file_;
+};
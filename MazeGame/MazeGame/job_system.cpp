@@ -0,0 +1,427 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "frame_allocator.h"
+#include "job_system.h"
+
+namespace {
+const int MAX_TIMED_NAMES = 32;  // Per thread
+
+class SpinLock {
+   public:
+    void Lock() {
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            while (locked_.load(std::memory_order_relaxed)) std::this_thread::yield();
+        }
+    }
+    void Unlock() {
+        locked_.store(false, std::memory_order_release);
+    }
+
+   private:
+    std::atomic<bool> locked_{false};
+};
+
+// A ring of jobs. Its thread pushes and pops at the back, so it works on whatever it queued most recently while that's still in
+// cache, and thieves take from the front, where the oldest (and usually biggest) pieces of work are
+class JobQueue {
+   public:
+    bool Push(const Job& job) {
+        lock_.Lock();
+        int count = count_.load(std::memory_order_relaxed);
+        bool pushed = count < JOB_QUEUE_CAPACITY;
+        if (pushed) {
+            jobs_[(front_ + count) % JOB_QUEUE_CAPACITY] = job;
+            count_.store(count + 1);  // Sequentially consistent, since sleeping workers look at it. See SleepUntilWork()
+        }
+        lock_.Unlock();
+        return pushed;
+    }
+
+    bool PopBack(Job* job) {
+        if (count_.load(std::memory_order_relaxed) == 0) return false;  // Checked without the lock so idle threads stay out of it
+
+        lock_.Lock();
+        int count = count_.load(std::memory_order_relaxed);
+        if (count > 0) {
+            *job = jobs_[(front_ + count - 1) % JOB_QUEUE_CAPACITY];
+            count_.store(count - 1, std::memory_order_relaxed);
+        }
+        lock_.Unlock();
+        return count > 0;
+    }
+
+    bool StealFront(Job* job) {
+        if (count_.load(std::memory_order_relaxed) == 0) return false;
+
+        lock_.Lock();
+        int count = count_.load(std::memory_order_relaxed);
+        if (count > 0) {
+            *job = jobs_[front_];
+            front_ = (front_ + 1) % JOB_QUEUE_CAPACITY;
+            count_.store(count - 1, std::memory_order_relaxed);
+        }
+        lock_.Unlock();
+        return count > 0;
+    }
+
+    bool IsEmpty() const {
+        return count_.load() == 0;
+    }
+
+   private:
+    SpinLock lock_;
+    Job jobs_[JOB_QUEUE_CAPACITY];
+    int front_ = 0;
+    std::atomic<int> count_{0};
+};
+
+struct JobTiming {
+    const char* name;
+    int64_t runs;
+    double total_ms, max_ms;
+};
+
+// Everything belonging to one thread that runs jobs. Timings are only written by that thread, and only read when they're printed
+struct ThreadState {
+    JobQueue queue;
+    SpinLock timings_lock;
+    JobTiming timings[MAX_TIMED_NAMES];
+    int timing_count = 0;
+};
+
+// The workers, then any other threads that have submitted or waited on jobs, then one shared by every other thread that runs a
+// job, only for its timings
+ThreadState* threads = nullptr;
+int worker_count = 0;
+std::atomic<int> external_thread_count(0);  // Slots ever handed out to other threads. Released ones are reused first
+std::mutex external_slots_mutex;
+std::vector<int> free_external_slots;
+std::vector<std::thread> workers;
+std::thread::id main_thread;
+std::atomic<bool> running(false);
+
+std::mutex sleep_mutex;
+std::condition_variable sleep_condition;
+std::atomic<int> sleeping_workers(0);
+
+std::mutex main_thread_jobs_mutex;
+std::vector<Job> main_thread_jobs, running_main_thread_jobs;  // Swapped, so jobs can be queued while others run
+std::atomic<int> main_thread_job_count(0);
+
+thread_local int thread_index = -1;
+thread_local uint32_t steal_seed = 0;
+
+// Gives a thread's slot back when it exits, so threads that come and go, like the simulation thread between levels, don't use
+// them up. Anything it queued has been waited on by then, and timings left in the slot are kept
+struct ExternalSlot {
+    int external = -1;
+
+    ~ExternalSlot() {
+        if (external < 0) return;
+        std::lock_guard<std::mutex> lock(external_slots_mutex);
+        free_external_slots.push_back(external);
+    }
+};
+thread_local ExternalSlot external_slot;
+
+int ThreadIndex() {
+    if (thread_index < 0) {
+        std::lock_guard<std::mutex> lock(external_slots_mutex);
+        int external;
+        if (!free_external_slots.empty()) {
+            external = free_external_slots.back();
+            free_external_slots.pop_back();
+        } else {
+            external = external_thread_count.load();
+            if (external >= JOB_MAX_EXTERNAL_THREADS) {
+                printf("More than %d threads other than the workers are using jobs at once. Exiting...\n", JOB_MAX_EXTERNAL_THREADS);
+                exit(1);
+            }
+            external_thread_count.store(external + 1);
+        }
+        external_slot.external = external;
+        thread_index = worker_count + external;
+    }
+    return thread_index;
+}
+
+int SharedTimingIndex() {
+    return worker_count + JOB_MAX_EXTERNAL_THREADS;
+}
+
+// Where a thread's job timings go. Threads that have only run jobs inline don't need a slot of their own for that
+int TimingIndex() {
+    return thread_index >= 0 ? thread_index : SharedTimingIndex();
+}
+
+bool AnyQueued() {
+    int thread_count = worker_count + std::min(external_thread_count.load(), JOB_MAX_EXTERNAL_THREADS);
+    for (int i = 0; i < thread_count; i++) {
+        if (!threads[i].queue.IsEmpty()) return true;
+    }
+    return false;
+}
+
+// The newest job on this thread's own queue, or else the oldest on someone else's, starting from a random one so thieves spread out
+bool FindJob(int index, Job* job) {
+    if (threads[index].queue.PopBack(job)) return true;
+
+    int thread_count = worker_count + std::min(external_thread_count.load(std::memory_order_relaxed), JOB_MAX_EXTERNAL_THREADS);
+    steal_seed = steal_seed * 1664525u + 1013904223u;
+    int start = static_cast<int>((steal_seed >> 16) % thread_count);
+    for (int n = 0; n < thread_count; n++) {
+        int victim = (start + n) % thread_count;
+        if (victim != index && threads[victim].queue.StealFront(job)) return true;
+    }
+    return false;
+}
+
+void SleepUntilWork() {
+    // The queues are checked after counting this worker as asleep, and submitters check the count after queueing, so at least one
+    // of them sees the other. Submitters take the mutex to notify, so the wakeup can't land between the check and the wait
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    sleeping_workers.fetch_add(1);
+    if (running.load() && !AnyQueued()) sleep_condition.wait(lock);
+    sleeping_workers.fetch_sub(1);
+}
+
+void WakeWorker() {
+    if (sleeping_workers.load() == 0) return;
+
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    sleep_condition.notify_one();
+}
+}  // namespace
+
+JobCounter::JobCounter() : pending_(0), dependent_count_(0), locked_(false) {}
+
+bool JobCounter::IsDone() const {
+    Lock();  // So a finishing thread is completely done with the counter once this sees zero
+    bool done = pending_ == 0;
+    Unlock();
+    return done;
+}
+
+void JobCounter::Lock() const {
+    while (locked_.exchange(true, std::memory_order_acquire)) {
+        while (locked_.load(std::memory_order_relaxed)) std::this_thread::yield();
+    }
+}
+
+void JobCounter::Unlock() const {
+    locked_.store(false, std::memory_order_release);
+}
+
+void JobSystem::Init() {
+    if (threads != nullptr) return;
+
+    int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+    worker_count = std::max(0, std::min(hardware_threads - 2, JOB_MAX_WORKERS));  // The main and simulation threads have cores
+    threads = new ThreadState[worker_count + JOB_MAX_EXTERNAL_THREADS + 1];
+    main_thread = std::this_thread::get_id();
+    ThreadIndex();
+
+    running.store(true);
+    for (int i = 0; i < worker_count; i++) {
+        workers.emplace_back([i]() {
+            thread_index = i;
+            steal_seed = static_cast<uint32_t>(i) * 2654435761u;
+
+            int idle_spins = 0;
+            Job job;
+            while (running.load(std::memory_order_relaxed)) {
+                if (FindJob(i, &job)) {
+                    Execute(job);
+                    FrameAllocator::Reset();  // Scratch memory never outlives a job on a worker
+                    idle_spins = 0;
+                } else if (++idle_spins < JOB_SPINS_BEFORE_SLEEP) {
+                    std::this_thread::yield();
+                } else {
+                    SleepUntilWork();
+                    idle_spins = 0;
+                }
+            }
+        });
+    }
+    printf("Running jobs on %d worker threads\n", worker_count);
+}
+
+void JobSystem::Shutdown() {
+    if (threads == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        running.store(false);
+        sleep_condition.notify_all();
+    }
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+
+    delete[] threads;
+    threads = nullptr;
+    worker_count = 0;
+}
+
+int JobSystem::WorkerCount() {
+    return worker_count;
+}
+
+bool JobSystem::IsMainThread() {
+    return std::this_thread::get_id() == main_thread;
+}
+
+void JobSystem::Run(const Job& job) {
+    if (job.counter != nullptr) {
+        job.counter->Lock();
+        job.counter->pending_++;
+        job.counter->Unlock();
+    }
+
+    Submit(job);
+}
+
+void JobSystem::RunAfter(const Job& job, JobCounter* dependency) {
+    if (job.counter != nullptr) {
+        job.counter->Lock();
+        job.counter->pending_++;
+        job.counter->Unlock();
+    }
+
+    dependency->Lock();
+    bool waiting = dependency->pending_ > 0;
+    if (waiting) {
+        if (dependency->dependent_count_ == JOB_MAX_DEPENDENTS) {
+            printf("More than %d jobs are waiting on one counter. Exiting...\n", JOB_MAX_DEPENDENTS);
+            exit(1);
+        }
+        dependency->dependents_[dependency->dependent_count_++] = job;
+    }
+    dependency->Unlock();
+
+    if (!waiting) Submit(job);
+}
+
+void JobSystem::RunOnMainThread(const Job& job) {
+    if (job.counter != nullptr) {
+        job.counter->Lock();
+        job.counter->pending_++;
+        job.counter->Unlock();
+    }
+
+    std::lock_guard<std::mutex> lock(main_thread_jobs_mutex);
+    main_thread_jobs.push_back(job);
+    main_thread_job_count.fetch_add(1, std::memory_order_release);
+}
+
+void JobSystem::RunMainThreadJobs() {
+    if (main_thread_job_count.load(std::memory_order_acquire) == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(main_thread_jobs_mutex);
+        running_main_thread_jobs.swap(main_thread_jobs);
+        main_thread_job_count.store(0, std::memory_order_relaxed);
+    }
+    for (const Job& job : running_main_thread_jobs) Execute(job);
+    running_main_thread_jobs.clear();
+}
+
+void JobSystem::Wait(JobCounter* counter) {
+    if (threads == nullptr) return;  // Everything ran as it was submitted
+
+    int index = ThreadIndex();
+    bool main = IsMainThread();
+    Job job;
+    while (!counter->IsDone()) {
+        if (main) RunMainThreadJobs();
+
+        if (FindJob(index, &job)) {
+            Execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::PrintTimings() {
+    if (threads == nullptr) return;
+
+    std::vector<JobTiming> totals;
+    int thread_count = worker_count + std::min(external_thread_count.load(), JOB_MAX_EXTERNAL_THREADS);
+    for (int i = 0; i <= thread_count; i++) {
+        ThreadState& thread = threads[i == thread_count ? SharedTimingIndex() : i];  // The shared timings last
+        thread.timings_lock.Lock();
+        for (int t = 0; t < thread.timing_count; t++) {
+            const JobTiming& timing = thread.timings[t];
+            auto same_name = [&](const JobTiming& other) { return strcmp(other.name, timing.name) == 0; };
+            auto total = std::find_if(totals.begin(), totals.end(), same_name);
+            if (total == totals.end()) {
+                totals.push_back(timing);
+            } else {
+                total->runs += timing.runs;
+                total->total_ms += timing.total_ms;
+                total->max_ms = std::max(total->max_ms, timing.max_ms);
+            }
+        }
+        thread.timing_count = 0;
+        thread.timings_lock.Unlock();
+    }
+
+    printf("Jobs on %d workers:\n", worker_count);
+    for (const JobTiming& timing : totals) {
+        printf("  %-24s %8lld runs %10.3f ms total %8.4f ms mean %8.4f ms max\n", timing.name, static_cast<long long>(timing.runs),
+               timing.total_ms, timing.total_ms / timing.runs, timing.max_ms);
+    }
+}
+
+void JobSystem::Submit(const Job& job) {
+    if (threads == nullptr || worker_count == 0 || !threads[ThreadIndex()].queue.Push(job)) {
+        Execute(job);  // Without workers, or with a full queue, there's nowhere better for it to go
+        return;
+    }
+    WakeWorker();
+}
+
+void JobSystem::Execute(const Job& job) {
+    auto start = std::chrono::high_resolution_clock::now();
+    job.function(job.data, job.begin, job.end);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    if (threads != nullptr) {
+        ThreadState& thread = threads[TimingIndex()];
+        thread.timings_lock.Lock();
+        int t = 0;
+        while (t < thread.timing_count && thread.timings[t].name != job.name) t++;
+        if (t == thread.timing_count && t < MAX_TIMED_NAMES) thread.timings[thread.timing_count++] = JobTiming{job.name, 0, 0, 0};
+        if (t < thread.timing_count) {
+            JobTiming& timing = thread.timings[t];
+            timing.runs++;
+            timing.total_ms += ms;
+            timing.max_ms = std::max(timing.max_ms, ms);
+        }
+        thread.timings_lock.Unlock();
+    }
+
+    if (job.counter != nullptr) Finish(job.counter);
+}
+
+void JobSystem::Finish(JobCounter* counter) {
+    Job released[JOB_MAX_DEPENDENTS];
+    int released_count = 0;
+
+    counter->Lock();
+    if (--counter->pending_ == 0) {
+        released_count = counter->dependent_count_;
+        std::copy(counter->dependents_, counter->dependents_ + released_count, released);
+        counter->dependent_count_ = 0;
+    }
+    counter->Unlock();  // The last thing done to the counter, since whoever's waiting on it may destroy it straight after
+
+    for (int i = 0; i < released_count; i++) Submit(released[i]);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include "constants.h"
+
+class JobCounter;
+
+// A function to run over [begin, end). Plain data, so submitting one doesn't allocate
+struct Job {
+    void (*function)(void* data, int begin, int end);
+    void* data;
+    int begin, end;
+    const char* name;     // Timings are kept per name, so jobs doing the same work should share one
+    JobCounter* counter;  // Counts this job until it's finished. May be null
+};
+
+// How many jobs counted by it haven't finished yet. Other jobs can be made to wait for it to reach zero, and so can any thread
+class JobCounter {
+   public:
+    JobCounter();
+    bool IsDone() const;
+
+   private:
+    friend class JobSystem;
+
+    void Lock() const;
+    void Unlock() const;
+
+    int pending_;
+    Job dependents_[JOB_MAX_DEPENDENTS];  // Submitted once pending_ reaches zero
+    int dependent_count_;
+    mutable std::atomic<bool> locked_;  // Guards everything above. A thread that sees pending_ at zero may destroy the counter
+};
+
+/**
+ * Runs jobs on a pool of worker threads. Each thread that submits jobs has its own queue, taking the newest job off the back of
+ * it while thieves take the oldest off the front, so threads mostly stay out of each other's way and work spreads to whichever
+ * threads are free. Threads waiting on a counter run jobs until it's done, rather than blocking, and idle workers sleep.
+ * Jobs may use the frame allocator, which is reset after each one on a worker. Anything that touches GL has to go through
+ * RunOnMainThread() instead, since the context belongs to the main thread.
+ * How long every job takes is added up by name, and PrintTimings() reports it.
+ */
+class JobSystem {
+   public:
+    static void Init();      // On the main thread, before anything else uses it. Starts the workers
+    static void Shutdown();  // Stops the workers, once they finish the jobs they're running. Nothing else should be queued
+    static int WorkerCount();
+    static bool IsMainThread();
+
+    static void Run(const Job& job);
+    static void RunAfter(const Job& job, JobCounter* dependency);  // Runs it once the dependency is done
+    static void RunOnMainThread(const Job& job);                   // The next time the main thread waits or RunMainThreadJobs()
+    static void RunMainThreadJobs();                               // Only on the main thread
+    static void Wait(JobCounter* counter);                         // Runs other jobs until it's done
+
+    // Calls function(begin, end) over chunks of [0, count) across the workers and this thread, and returns once every chunk is
+    // done. Ranges of up to grain items just run here
+    template <typename Function>
+    static void ParallelFor(const char* name, int count, int grain, const Function& function);
+
+    static void PrintTimings();  // And starts counting again
+
+   private:
+    template <typename Function>
+    static void Invoke(void* data, int begin, int end);
+
+    static void Submit(const Job& job);  // Queues it without counting it, since that's already been done
+    static void Execute(const Job& job);
+    static void Finish(JobCounter* counter);
+};
+
+template <typename Function>
+void JobSystem::ParallelFor(const char* name, int count, int grain, const Function& function) {
+    if (count <= 0) return;
+
+    int chunk_count = WorkerCount() == 0 ? 1 : std::min((count + grain - 1) / grain, (WorkerCount() + 1) * JOB_CHUNKS_PER_THREAD);
+    Job job{&Invoke<Function>, const_cast<Function*>(&function), 0, count, name, nullptr};
+    if (chunk_count <= 1) {
+        Execute(job);  // Not worth waking anything up for
+        return;
+    }
+
+    JobCounter counter;
+    job.counter = &counter;
+    int chunk_size = (count + chunk_count - 1) / chunk_count;
+    for (int begin = chunk_size; begin < count; begin += chunk_size) {
+        job.begin = begin;
+        job.end = std::min(begin + chunk_size, count);
+        Run(job);
+    }
+
+    job.begin = 0;  // The first chunk runs here, so this thread has something to do straight away
+    job.end = chunk_size;
+    job.counter = nullptr;
+    Execute(job);
+    Wait(&counter);
+}
+
+template <typename Function>
+void JobSystem::Invoke(void* data, int begin, int end) {
+    (*static_cast<Function*>(data))(begin, end);
+}
@@ -1,4 +1,3 @@
-#include <SDL.h>
 #include <cmath>
 #include "constants.h"
 #include "controller.h"
@@ -7,54 +6,71 @@
 
 Key::Key(Model* model, Map* map, char id, glm::vec2 pos) : GameObject(model, map) {
     id_ = id;
+    holder_ = nullptr;
 
-    bounding_box_vertices_ = bounding_box_->GetBoxVertices();  // This has to happen before we translate the key
     transform->Translate(glm::vec3(pos.x, pos.y, 0));
     InitTransform();
-}
 
-void Key::Update() {
-    Door* door = map_->IntersectsDoorWithId(this, id_);
-    if (holder_ != nullptr && door != nullptr) {
-        door->GoAway();
-        GoAway();
-        holder_->UseKey();
-        holder_ = nullptr;
-    }
+    trigger_ = map_->Triggers().AddTrigger(this, BROADPHASE_DOOR, this);
+    map_->Triggers().SetTriggerEnabled(trigger_, false);
+    map_->Triggers().SetTriggerPrecise(trigger_, true);  // The hammer's box reaches well past its head and handle
+    body_ = map_->Physics().AddBody(this, KEY_MASS);     // Asleep, so it floats where it was placed until it's first picked up
+}
 
-    if (holder_ != nullptr) {
-        InitBoundingBox(bounding_box_vertices_);
-        bounding_box_->transform->ClearParent();
-    }
+void Key::OnTriggerEnter(GameObject* other) {
+    Door* door = static_cast<Door*>(other);  // Doors are all the trigger listens for
+    if (holder_ == nullptr || !door->MatchesId(id_)) return;
 
-    GameObject::Update();
+    door->GoAway();
+    map_->Scheduler().Wake(door);  // Its shrinking is the point of opening it, so it shouldn't be ticking at a reduced rate
+    holder_->UseKey();
+    GoAway();
 }
 
 void Key::GoAway() {
+    holder_ = nullptr;
+    map_->Physics().Hold(body_);  // For good
+    map_->Triggers().SetTriggerEnabled(trigger_, false);
     transform->ClearParent();
     transform->ResetAndSetTranslation(glm::vec3(0, 0, -3));
 }
 
 void Key::SetHolder(Controller* player) {
     holder_ = player;
+    map_->Triggers().SetTriggerEnabled(trigger_, holder_ != nullptr);  // Enabling it catches a key picked up inside a door
+    if (holder_ != nullptr) map_->Physics().Hold(body_);
 }
 
-void Key::Drop() {
+void Key::Drop(const glm::vec3& velocity, const glm::vec3& angular_velocity) {
     holder_ = nullptr;
-    InitTransform();
-    drop_time_ = SDL_GetTicks();
+    map_->Triggers().SetTriggerEnabled(trigger_, false);
+
+    // Let go of right where the hand had it, rather than where it'd be relative to the world
+    glm::mat4 world_transform = transform->WorldTransform();
+    transform->ClearParent();
+    transform->Set(world_transform);
+    UpdateWorldBounds();
+    map_->Physics().Release(body_, velocity, angular_velocity);
+
+    int drop = ++drops_;
+    can_be_picked_up_ = false;
+    map_->Tasks().After(KEY_DROP_PICKUP_COOLDOWN_MS / 1000.0f, [this, drop] {
+        if (drop == drops_) can_be_picked_up_ = true;
+    });
+}
+
+bool Key::CanBePickedUp() const {
+    return can_be_picked_up_;
 }
 
-bool Key::CanBePickedUp() {
-    return SDL_GetTicks() - drop_time_ > KEY_DROP_PICKUP_COOLDOWN_MS;
+bool Key::IsHeld() const {
+    return holder_ != nullptr;
 }
 
 void Key::InitTransform() {
     glm::vec2 previous_pos = glm::vec2(transform->X(), transform->Y());
     transform->ClearParent();
-    transform->ResetAndSetTranslation(glm::vec3(previous_pos, KEY_HEIGHT));
-    transform->Rotate(M_PI / 2, glm::vec3(1, 0, 0));
+    transform->Set(TransformBuilder(glm::vec3(previous_pos, KEY_HEIGHT)).Rotate(M_PI / 2, glm::vec3(1, 0, 0)));
 
-    InitBoundingBox(bounding_box_vertices_);
-    bounding_box_->transform->ClearParent();
+    UpdateWorldBounds();
 }
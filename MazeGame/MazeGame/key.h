@@ -1,25 +1,31 @@
 #pragma once
 #include "game_object.h"
+#include "trigger_system.h"
 
 class Map;
 class Controller;
 
-class Key : public GameObject {
+// Opens the matching door when it's carried into it. Its trigger is only enabled while it's held, and it's a rigid body the rest of
+// the time, so it falls and tumbles wherever it's let go
+class Key final : public GameObject, public TriggerListener {
    public:
     explicit Key(Model* model, Map* map, char id, glm::vec2 pos);
     ~Key() = default;
 
-    void Update() override;
+    void OnTriggerEnter(GameObject* other) override;
     void GoAway();
     void SetHolder(Controller* player);
-    void Drop();
-    bool CanBePickedUp();
+    void Drop(const glm::vec3& velocity, const glm::vec3& angular_velocity);  // Carries on moving the way the hand was
+    bool CanBePickedUp() const;  // Not for a while after it's dropped
+    bool IsHeld() const;
 
    private:
     void InitTransform();
 
     char id_;
     Controller* holder_;
-    int drop_time_ = 0;
-    std::vector<glm::vec3> bounding_box_vertices_;
+    int trigger_;
+    int body_;
+    int drops_ = 0;  // So a cooldown from an earlier drop doesn't end a later one's early
+    bool can_be_picked_up_ = true;
 };
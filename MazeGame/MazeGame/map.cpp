@@ -1,77 +1,335 @@
 #include <vector>
+#include "job_system.h"
 #include "map.h"
 #include "player.h"
+#include "transform_kernels.h"
 
-Map::Map() {
+namespace {
+const uint32_t TRIGGER_BODIES = BROADPHASE_KEY | BROADPHASE_DOOR | BROADPHASE_PLAYER | BROADPHASE_FRACTAL;
+}  // namespace
+
+Map::Map(Arena* arena, int width, int height)
+    : all_elements_(ArenaAllocator<GameObject*>(arena)),
+      static_elements_(ArenaAllocator<uint8_t>(arena)),
+      grid_(arena, glm::vec2(0, 0), 1.0f, width, height),  // One grid cell per map cell
+      grid_objects_(ArenaAllocator<GameObject*>(arena)),
+      dynamic_grid_proxies_(ArenaAllocator<int>(arena)),
+      tree_(arena),
+      tree_proxies_(ArenaAllocator<int>(arena)),
+      triggers_(arena),
+      scheduler_(arena, this),
+      tasks_(arena, this),
+      physics_(arena, this),
+      walls_(ArenaAllocator<Wall*>(arena)),
+      doors_(ArenaAllocator<Door*>(arena)),
+      keys_(ArenaAllocator<Key*>(arena)),
+      spawns_(ArenaAllocator<Spawn*>(arena)),
+      goals_(ArenaAllocator<Goal*>(arena)),
+      fractals_(ArenaAllocator<Fractal*>(arena)),
+      world_transforms_(ArenaAllocator<glm::mat4>(arena)),
+      step_transforms_(ArenaAllocator<glm::mat4>(arena)),
+      previous_step_transforms_(ArenaAllocator<glm::mat4>(arena)),
+      model_bounds_min_(ArenaAllocator<glm::vec3>(arena)),
+      model_bounds_max_(ArenaAllocator<glm::vec3>(arena)),
+      world_bounds_min_(ArenaAllocator<glm::vec3>(arena)),
+      world_bounds_max_(ArenaAllocator<glm::vec3>(arena)) {
+    fractal_ = nullptr;
     player_ = nullptr;
     goal_ = nullptr;
     spawn_ = nullptr;
+    complete_ = false;
 }
 
 Map::~Map() = default;
 
-void Map::Add(GameObject* object) {
-    if (dynamic_cast<Wall*>(object)) {
-        walls_.push_back(dynamic_cast<Wall*>(object));
-    } else if (dynamic_cast<Player*>(object)) {
-        player_ = dynamic_cast<Player*>(object);
-    } else if (dynamic_cast<Door*>(object)) {
-        doors_.push_back(dynamic_cast<Door*>(object));
-    } else if (dynamic_cast<Key*>(object)) {
-        keys_.push_back(dynamic_cast<Key*>(object));
-    } else if (dynamic_cast<Spawn*>(object)) {
-        spawn_ = dynamic_cast<Spawn*>(object);
-    } else if (dynamic_cast<Goal*>(object)) {
-        goal_ = dynamic_cast<Goal*>(object);
-    } else if (dynamic_cast<Fractal*>(object)) {
-        fractal_ = dynamic_cast<Fractal*>(object);
-    }
+void Map::Add(Wall* wall) {
+    walls_.push_back(wall);
+    AddElement(wall, wall->IsSolid() ? BROADPHASE_SOLID : BROADPHASE_SCENERY);
+}
+
+void Map::Add(Door* door) {
+    doors_.push_back(door);
+    AddElement(door, BROADPHASE_SOLID | BROADPHASE_DOOR | BROADPHASE_DYNAMIC);
+}
 
+void Map::Add(Key* key) {
+    keys_.push_back(key);
+    AddElement(key, BROADPHASE_KEY | BROADPHASE_DYNAMIC | BROADPHASE_LOOSE | BROADPHASE_RIGID_BODY);
+}
+
+void Map::Add(Spawn* spawn) {
+    spawns_.push_back(spawn);
+    spawn_ = spawn;
+    AddElement(spawn, 0);
+}
+
+void Map::Add(Goal* goal) {
+    goals_.push_back(goal);
+    goal_ = goal;
+    AddElement(goal, 0);
+}
+
+void Map::Add(Fractal* fractal) {
+    fractals_.push_back(fractal);
+    fractal_ = fractal;
+    AddElement(fractal, BROADPHASE_FRACTAL | BROADPHASE_DYNAMIC | BROADPHASE_LOOSE);
+}
+
+void Map::Add(Player* player) {
+    player_ = player;
+    AddElement(player, BROADPHASE_PLAYER | BROADPHASE_DYNAMIC);
+}
+
+void Map::AddElement(GameObject* object, uint32_t categories) {
+    object->UpdateWorldBounds();  // It was probably placed after its bounds were made
     all_elements_.push_back(object);
+    static_elements_.push_back(!(categories & BROADPHASE_DYNAMIC));
+
+    if (categories & TRIGGER_BODIES) {
+        triggers_.AddBody(object, categories & TRIGGER_BODIES);
+    }
+
+    if ((categories & BROADPHASE_LOOSE) && !object->world_bounds.IsEmpty()) {
+        tree_proxies_.push_back(tree_.CreateProxy(object->world_bounds, categories, object));
+        return;
+    }
+
+    int proxy = grid_.Insert(object->world_bounds, categories);
+    grid_objects_.push_back(object);
+    if (categories & BROADPHASE_DYNAMIC) {
+        dynamic_grid_proxies_.push_back(proxy);
+    }
 }
 
 void Map::Init() {}
 
-void Map::UpdateAll() {
-    for (auto game_object : all_elements_) {
-        game_object->Update();
+void Map::Simulate(float dt) {
+    triggers_.Update();  // Keys, goals, and the controllers only act when something enters or leaves their triggers
+    tasks_.Step(dt);
+    physics_.Step(dt);
+
+    // No object has per-step logic of its own any more, so the scheduler only runs animations, like a door going away. The
+    // player is simulated straight after, every step, since it's what's driven by input and what everything else is judged from
+    if (player_ != nullptr) {
+        scheduler_.Step(dt, player_->transform->WorldPosition(), player_->LookDirection());
+        player_->Simulate(dt);
+    } else {
+        scheduler_.Step(dt, glm::vec3(0), glm::vec3(0, 1, 0));
     }
 }
 
-bool Map::IntersectsAnySolidObjects(GameObject* object) {
-    for (auto element : all_elements_) {
-        if (element->IsSolid() && object->IntersectsWith(*element)) return true;
+void Map::ExtractRenderPackets(std::vector<RenderPacket>& packets, std::vector<glm::mat4>& previous_model_matrices) const {
+    packets.resize(all_elements_.size());
+    previous_model_matrices.resize(all_elements_.size());
+    bool have_steps = step_transforms_.size() == all_elements_.size() && previous_step_transforms_.size() == all_elements_.size() &&
+                      world_transforms_.size() == all_elements_.size();
+
+    size_t count = 0;
+    for (size_t i = 0; i < all_elements_.size(); i++) {
+        RenderPacket& packet = packets[count];
+        if (static_elements_[i] || !all_elements_[i]->ExtractRenderPacket(&packet)) continue;
+
+        // Anything that's moved since the last step (like whatever's attached to the headset or a controller) is following a
+        // pose, so it's drawn where it is now rather than lagging behind
+        bool follows_pose = !have_steps || world_transforms_[i] != step_transforms_[i];
+        previous_model_matrices[count] = follows_pose ? packet.model_matrix : previous_step_transforms_[i];
+        count++;
+    }
+
+    packets.resize(count);
+    previous_model_matrices.resize(count);
+}
+
+void Map::ExtractStaticRenderPackets(std::vector<RenderPacket>& packets) const {
+    packets.clear();
+    RenderPacket packet;
+    for (size_t i = 0; i < all_elements_.size(); i++) {
+        if (static_elements_[i] && all_elements_[i]->ExtractRenderPacket(&packet)) packets.push_back(packet);
+    }
+}
+
+void Map::UpdateTransformsAndBounds() {
+    Transformable::UpdateAllWorldTransforms();
+
+    size_t count = all_elements_.size();
+    world_transforms_.resize(count);
+    model_bounds_min_.resize(count);
+    model_bounds_max_.resize(count);
+    world_bounds_min_.resize(count);
+    world_bounds_max_.resize(count);
+
+    // Every object's bounds are independent of the rest, so each chunk goes from gathering to writing back on its own
+    JobSystem::ParallelFor("Map bounds", static_cast<int>(count), JOB_TRANSFORMS_PER_CHUNK, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            world_transforms_[i] = all_elements_[i]->transform->WorldTransform();
+            model_bounds_min_[i] = all_elements_[i]->model_bounds.Min();
+            model_bounds_max_[i] = all_elements_[i]->model_bounds.Max();
+        }
+
+        TransformKernels::TransformBounds(&world_transforms_[begin], &model_bounds_min_[begin], &model_bounds_max_[begin],
+                                          &world_bounds_min_[begin], &world_bounds_max_[begin], end - begin);
+
+        for (int i = begin; i < end; i++) {
+            if (all_elements_[i]->model_bounds.IsEmpty()) continue;  // Nothing to collide with
+            all_elements_[i]->world_bounds = BoundingBox(world_bounds_min_[i], world_bounds_max_[i]);
+        }
+    });
+
+    for (int proxy : dynamic_grid_proxies_) {  // Static objects never leave the cells they were inserted into
+        grid_.Update(proxy, grid_objects_[proxy]->world_bounds);
+    }
+
+    for (int proxy : tree_proxies_) {
+        const BoundingBox& bounds = tree_.Object(proxy)->world_bounds;
+        tree_.MoveProxy(proxy, bounds, bounds.Center() - tree_.Bounds(proxy).Center());
     }
+}
 
-    return false;
+void Map::SaveStepTransforms() {
+    previous_step_transforms_.swap(step_transforms_);
+    step_transforms_.assign(world_transforms_.begin(), world_transforms_.end());
+    if (previous_step_transforms_.size() != step_transforms_.size()) {
+        previous_step_transforms_ = step_transforms_;  // There's only one step so far, so there's nothing to interpolate from
+    }
 }
 
-Player* Map::IntersectsPlayer(GameObject* object) {
-    if (object->IntersectsWith(*player_)) {
-        return player_;
+uint64_t Map::StateChecksum(uint64_t previous) const {
+    // FNV-1a over the bytes themselves, so any difference at all shows, down to the last bit of a float
+    uint64_t hash = 14695981039346656037ull ^ previous;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+
+    mix(step_transforms_.data(), step_transforms_.size() * sizeof(glm::mat4));
+    if (player_ != nullptr) {
+        glm::vec3 player_position = player_->transform->WorldPosition();
+        mix(&player_position, sizeof(player_position));
+    }
+    for (const Key* key : keys_) {
+        bool state[2] = {key->IsHeld(), key->CanBePickedUp()};
+        mix(state, sizeof(state));
     }
+    for (const Door* door : doors_) {
+        bool going_away = door->IsGoingAway();
+        mix(&going_away, sizeof(going_away));
+    }
+    return hash;
+}
+
+bool Map::IntersectsAnySolidObjects(GameObject* object) {
+    return QueryBroadphase(object->world_bounds, BROADPHASE_SOLID,
+                           [&](GameObject* element) { return element != object && object->IntersectsWith(*element); });
+}
 
-    return nullptr;
+void Map::GatherSolidBounds(const BoundingBox& region, GameObject* ignore, FrameVector<BoundingBox>& solids) {
+    QueryBroadphase(region, BROADPHASE_SOLID, [&](GameObject* element) {
+        if (element != ignore) solids.push_back(element->world_bounds);
+        return false;
+    });
+}
+
+void Map::GatherObjects(const BoundingBox& region, uint32_t category_mask, GameObject* ignore, FrameVector<GameObject*>& objects) {
+    QueryBroadphase(region, category_mask, [&](GameObject* element) {
+        if (element != ignore) objects.push_back(element);
+        return false;
+    });
 }
 
 Player* Map::GetPlayer() {
     return player_;
 }
 
-Key* Map::FirstIntersectedKey(const BoundingBox& object) {
-    for (auto key : keys_) {
-        if (key->IntersectsWith(object)) return key;
-    }
+TriggerSystem& Map::Triggers() {
+    return triggers_;
+}
 
-    return nullptr;
+SimulationScheduler& Map::Scheduler() {
+    return scheduler_;
 }
 
-Door* Map::IntersectsDoorWithId(GameObject* object, char id) {
-    for (auto door : doors_) {
-        if (door->MatchesId(id) && door->IntersectsWith(*object)) return door;
+TaskScheduler& Map::Tasks() {
+    return tasks_;
+}
+
+PhysicsWorld& Map::Physics() {
+    return physics_;
+}
+
+void Map::FindOverlappingPairs(FrameVector<std::pair<GameObject*, GameObject*>>& pairs) {
+    FrameVector<std::pair<int, int>> proxy_pairs;
+    grid_.FindPairs(BROADPHASE_DYNAMIC, proxy_pairs);
+
+    pairs.clear();
+    for (const auto& proxy_pair : proxy_pairs) {
+        pairs.push_back(std::make_pair(grid_objects_[proxy_pair.first], grid_objects_[proxy_pair.second]));
     }
 
-    return nullptr;
+    proxy_pairs.clear();
+    tree_.FindPairs(proxy_pairs);
+    for (const auto& proxy_pair : proxy_pairs) {
+        pairs.push_back(std::make_pair(tree_.Object(proxy_pair.first), tree_.Object(proxy_pair.second)));
+    }
+
+    // Everything in the tree is dynamic, so it's paired with whatever it overlaps in the grid too. Scenery can't be collided with
+    // or trigger anything, so it's left out, which skips the floors and ceilings under everything
+    const uint32_t PAIRED = BROADPHASE_SOLID | TRIGGER_BODIES;
+    for (int proxy : tree_proxies_) {
+        GameObject* object = tree_.Object(proxy);
+        grid_.Query(object->world_bounds, PAIRED, [&](int grid_proxy) {
+            pairs.push_back(std::make_pair(object, grid_objects_[grid_proxy]));
+            return false;
+        });
+    }
+}
+
+bool Map::RayCast(const Ray& ray, uint32_t category_mask, RayHit* hit) {
+    RayCastBatch(&ray, 1, category_mask, hit);
+    return hit->object != nullptr;
+}
+
+bool Map::SegmentCast(const glm::vec3& from, const glm::vec3& to, uint32_t category_mask, RayHit* hit) {
+    return RayCast(Ray{from, to - from, 1.0f}, category_mask, hit);
+}
+
+void Map::RayCastBatch(const Ray* rays, int count, uint32_t category_mask, RayHit* hits) {
+    for (int i = 0; i < count; i++) {
+        const Ray& ray = rays[i];
+        RayHit& hit = hits[i];
+        hit.object = nullptr;
+        hit.distance = ray.max_distance;
+
+        // Each hit test keeps the normal of the nearest hit so far, since the searches only hand back which proxy won. Maze cells
+        // are cubes, so their boxes are already exact, but anything in the tree is tested against its triangles
+        glm::vec3 normal;
+        auto test_object = [&](GameObject* object, bool precise) {
+            float distance;
+            bool hit_object = precise ? object->RayCastMesh(ray.origin, ray.direction, hit.distance, &distance, &normal)
+                                      : object->world_bounds.RayCast(ray.origin, ray.direction, hit.distance, &distance, &normal);
+            if (!hit_object) return -1.0f;
+            if (distance <= hit.distance) {
+                hit.distance = distance;
+                hit.normal = normal;
+            }
+            return distance;
+        };
+
+        // The maze first, so the tree's search is cut off at the first wall
+        int proxy = grid_.RayCast(ray.origin, ray.direction, ray.max_distance, category_mask, nullptr,
+                                  [&](int grid_proxy) { return test_object(grid_objects_[grid_proxy], false); });
+        if (proxy != -1) hit.object = grid_objects_[proxy];
+
+        proxy = tree_.RayCast(ray.origin, ray.direction, hit.distance, category_mask, nullptr,
+                              [&](int tree_proxy) { return test_object(tree_.Object(tree_proxy), true); });
+        if (proxy != DynamicAabbTree::NULL_NODE) hit.object = tree_.Object(proxy);
+
+        if (hit.object == nullptr) continue;
+
+        hit.point = ray.origin + ray.direction * hit.distance;
+        hit.cell = grid_.CellAt(hit.point - hit.normal * 0.001f);  // Nudged inside, so a hit on a cell's edge counts as that cell
+    }
 }
 
 glm::vec3 Map::SpawnPosition() const {
@@ -89,3 +347,11 @@ glm::vec3 Map::GoalPosition() const {
     }
     return goal_->transform->WorldPosition();
 }
+
+void Map::Complete() {
+    complete_ = true;
+}
+
+bool Map::IsComplete() const {
+    return complete_;
+}
@@ -1,41 +1,138 @@
 #pragma once
 #include <detail/type_vec3.hpp>
 #include <vector>
+#include "arena.h"
 #include "door.h"
+#include "dynamic_aabb_tree.h"
 #include "fractal.h"
 #include "game_object.h"
 #include "goal.h"
 #include "key.h"
+#include "physics_world.h"
 #include "player.h"
+#include "simulation_scheduler.h"
 #include "spawn.h"
+#include "task_scheduler.h"
+#include "trigger_system.h"
+#include "uniform_grid.h"
 #include "wall.h"
 
+// What the broadphase and trigger volumes can be asked for. BROADPHASE_DYNAMIC marks objects whose bounds are refreshed every
+// frame, and BROADPHASE_LOOSE ones that can go anywhere, so they're kept in the AABB tree rather than the grid
+typedef enum {
+    BROADPHASE_SOLID = 1 << 0,
+    BROADPHASE_KEY = 1 << 1,
+    BROADPHASE_DOOR = 1 << 2,
+    BROADPHASE_PLAYER = 1 << 3,
+    BROADPHASE_DYNAMIC = 1 << 4,
+    BROADPHASE_LOOSE = 1 << 5,
+    BROADPHASE_FRACTAL = 1 << 6,
+    BROADPHASE_SCENERY = 1 << 7,     // Floors, ceilings, and anything else that's only there to be seen (or pointed at)
+    BROADPHASE_RIGID_BODY = 1 << 8,  // Has a body in the PhysicsWorld
+} BroadphaseCategory;
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float max_distance;  // In multiples of direction's length
+};
+
+struct RayHit {
+    GameObject* object;  // nullptr if the ray didn't hit anything
+    float distance;      // In multiples of the ray's direction's length
+    glm::vec3 point;
+    glm::vec3 normal;  // Of the box face or triangle that was hit, facing back along the ray
+    glm::ivec2 cell;   // The map cell the hit is in
+};
+
 class Map {
    public:
-    Map();
+    // The map's own lists are allocated from the arena, which should be the one its objects live in. The size is in cells
+    Map(Arena* arena, int width, int height);
     ~Map();
 
-    void Add(GameObject* object);
+    // Each kind of object goes in its own list, so per-frame work on them can call their exact type's methods
+    void Add(Wall* wall);
+    void Add(Door* door);
+    void Add(Key* key);
+    void Add(Spawn* spawn);
+    void Add(Goal* goal);
+    void Add(Fractal* fractal);
+    void Add(Player* player);
     void Init();
 
-    void UpdateAll();
+    void Simulate(float dt);  // Sends trigger events, moves loose items, then runs the player and whichever objects are due
+    // Replaces the contents of packets, posed as of the last step, and fills previous_model_matrices (one per packet) with where
+    // each was the step before. Anything following a pose has both set to where it is now, so it isn't blended. Static objects,
+    // which never move, are left out
+    void ExtractRenderPackets(std::vector<RenderPacket>& packets, std::vector<glm::mat4>& previous_model_matrices) const;
+    void ExtractStaticRenderPackets(std::vector<RenderPacket>& packets) const;  // Replaces the contents of packets with the rest
+    void UpdateTransformsAndBounds();  // Brings every world transform and world AABB up to date
+    void SaveStepTransforms();         // Records the transforms UpdateTransformsAndBounds() found as the latest step's
+    // Folds the state of the game as of the latest step (every transform, the player's position, and what each key and door is
+    // doing) into previous, so chaining it each tick gives a checksum of the whole run so far
+    uint64_t StateChecksum(uint64_t previous) const;
     bool IntersectsAnySolidObjects(GameObject* object);
-    Player* IntersectsPlayer(GameObject* object);
+    void GatherSolidBounds(const BoundingBox& region, GameObject* ignore, FrameVector<BoundingBox>& solids);  // Appends to solids
+    // Appends everything in any of the categories whose bounds overlap region to objects
+    void GatherObjects(const BoundingBox& region, uint32_t category_mask, GameObject* ignore, FrameVector<GameObject*>& objects);
     Player* GetPlayer();
-    Key* FirstIntersectedKey(const BoundingBox& object);
-    Door* IntersectsDoorWithId(GameObject* object, char id);
+    TriggerSystem& Triggers();  // Keys, doors, the player and the fractal are its bodies
+    SimulationScheduler& Scheduler();  // Runs animations, and any object with per-step logic but the player
+    TaskScheduler& Tasks();            // For anything that waits, like a dropped key's cooldown
+    PhysicsWorld& Physics();           // Dropped keys fall and tumble in it
+    void FindOverlappingPairs(FrameVector<std::pair<GameObject*, GameObject*>>& pairs);  // Every overlap involving a dynamic object
+
+    // The first object in any of the categories the ray hits, walking the maze's cells in order and checking loose objects through
+    // the tree. Maze cells are hit on their AABBs, ignoring ones the ray starts inside, and objects in the tree on their triangles.
+    // Returns whether anything was hit
+    bool RayCast(const Ray& ray, uint32_t category_mask, RayHit* hit);
+    bool SegmentCast(const glm::vec3& from, const glm::vec3& to, uint32_t category_mask, RayHit* hit);  // hit->distance is in [0, 1]
+    void RayCastBatch(const Ray* rays, int count, uint32_t category_mask, RayHit* hits);  // hits[i] is rays[i]'s, misses included
 
     glm::vec3 SpawnPosition() const;
     glm::vec3 GoalPosition() const;
+    void Complete();  // The player has reached the goal
+    bool IsComplete() const;
 
     Fractal* fractal_;
 
    private:
-    std::vector<GameObject*> all_elements_;
-    std::vector<Wall*> walls_;
-    std::vector<Door*> doors_;
-    std::vector<Key*> keys_;
+    // Calls callback(object) for everything in the grid or the tree in any of the categories whose bounds overlap, until it
+    // returns true
+    template <typename Callback>
+    bool QueryBroadphase(const BoundingBox& bounds, uint32_t category_mask, Callback callback);
+
+    void AddElement(GameObject* object, uint32_t categories);
+
+    ArenaVector<GameObject*> all_elements_;
+    ArenaVector<uint8_t> static_elements_;  // Whether each of all_elements_ stays put for the whole level
+    UniformGrid grid_;
+    ArenaVector<GameObject*> grid_objects_;  // Indexed by grid proxy id
+    ArenaVector<int> dynamic_grid_proxies_;
+    DynamicAabbTree tree_;
+    ArenaVector<int> tree_proxies_;
+    TriggerSystem triggers_;
+    SimulationScheduler scheduler_;
+    TaskScheduler tasks_;
+    PhysicsWorld physics_;
+    ArenaVector<Wall*> walls_;
+    ArenaVector<Door*> doors_;
+    ArenaVector<Key*> keys_;
+    ArenaVector<Spawn*> spawns_;
+    ArenaVector<Goal*> goals_;
+    ArenaVector<Fractal*> fractals_;
+    ArenaVector<glm::mat4> world_transforms_;  // Scratch arrays for UpdateTransformsAndBounds(), indexed like all_elements_
+    ArenaVector<glm::mat4> step_transforms_, previous_step_transforms_;
+    ArenaVector<glm::vec3> model_bounds_min_, model_bounds_max_, world_bounds_min_, world_bounds_max_;
     Spawn* spawn_;
     Goal* goal_;
     Player* player_;
+    bool complete_;
 };
+
+template <typename Callback>
+bool Map::QueryBroadphase(const BoundingBox& bounds, uint32_t category_mask, Callback callback) {
+    if (grid_.Query(bounds, category_mask, [&](int proxy) { return callback(grid_objects_[proxy]); })) return true;
+    return tree_.Query(bounds, category_mask, [&](int proxy) { return callback(tree_.Object(proxy)); });
+}
@@ -1,6 +1,5 @@
 #define _USE_MATH_DEFINES
 
-#include <cctype>
 #include <cmath>
 #include <fstream>
 #include <iostream>
@@ -21,11 +20,10 @@ MapLoader::MapLoader() {}
 
 MapLoader::~MapLoader() {}
 
-Map* MapLoader::LoadMap(const string& filename, GLuint scene_vao) {
-    LoadAssets(scene_vao);
+Map* MapLoader::LoadMap(const string& filename, GLuint scene_vao, Arena* arena) {
+    LoadAssets(scene_vao, arena);
 
     int width, height;
-    Map* map = new Map();
 
     std::fstream file(filename);
     if (file.fail()) {
@@ -34,6 +32,7 @@ Map* MapLoader::LoadMap(const string& filename, GLuint scene_vao) {
     }
 
     file >> width >> height;
+    Map* map = arena->New<Map>(arena, width, height);
 
     string line;
     std::vector<string> lines;
@@ -54,130 +53,124 @@ Map* MapLoader::LoadMap(const string& filename, GLuint scene_vao) {
         exit(1);
     }
 
-    if (!wall_model_ || !door_model_ || !key_model_) {
-        cout << "Models failed to initialize for map. Exiting..." << endl;
-        exit(1);
+    for (Model* model : models_) {
+        if (!model) {
+            cout << "Models failed to initialize for map. Exiting..." << endl;
+            exit(1);
+        }
     }
 
-    bool add_ground = false;
-    GameObject* current_object;
     for (int i = 0; i < width; i++) {
         for (int j = 0; j < height; j++) {
             char current_char = lines[j][i];
-            glm::vec3 base_position = GetPositionForCoordinate(i, j);
-            if (IsKey(current_char)) {
-                current_object = new Key(key_model_, map, current_char, glm::vec2(base_position));
-                // Key transforms itself
-                add_ground = true;
-            } else if (IsDoor(current_char)) {
-                current_object = new Door(door_model_, current_char);
-                current_object->transform->Translate(base_position);
-                add_ground = true;
-            } else {
-                switch (current_char) {
-                    case 'W':
-                        current_object = new Wall(wall_model_);
-                        current_object->transform->Scale(glm::vec3(1, 1, 1.3));
-                        current_object->transform->Translate(base_position);
-                        current_object->SetTextureIndex(FRACTAL);
-                        break;
-                    case 'S':
-                        current_object = new Spawn(start_model_);
-                        printf("Placing spawn marker at %f, %f, %f\n", base_position.x, base_position.y, 0.0f);
-                        current_object->transform->Translate(glm::vec3(base_position.x, base_position.y, 0));
-                        current_object->transform->Scale(0.2f);
-                        add_ground = true;
-                        break;
-                    case 'G':
-                        current_object = new Goal(goal_model_, map);
-                        current_object->transform->Translate(base_position);
-                        current_object->transform->Rotate(0.1, glm::vec3(0, 0, 1));
-                        add_ground = true;
-                        break;
-                    case 'F':
-                        current_object = new Fractal(wall_model_);
-                        current_object->transform->Translate(base_position.x, base_position.y, 0.3);
-                        current_object->transform->Scale(0.3f);
-                        current_object->SetTextureIndex(FRACTAL);
-                        add_ground = true;
-                        break;
-                    case '0':
-                        current_object = GetGround(base_position);
-                        break;
-                    default:
-                        printf("Unrecognized character \'%c\'", current_char);
-                        continue;
-                }
+            const CellDescriptor& cell = CELL_TABLE[current_char];
+            if (cell.kind == CELL_INVALID) {
+                printf("Unrecognized character \'%c\'", current_char);
+                continue;
             }
 
-            current_object->material = GetMaterialForCharacter(current_char);
-            map->Add(current_object);
+            glm::vec3 base_position = GetPositionForCoordinate(i, j);
+            Material material = Material(cell.color_r, cell.color_g, cell.color_b);
+
+            GameObject* current_object = (this->*PLACE_FUNCTIONS[cell.kind])(map, arena, current_char, base_position);
+            current_object->material = material;
+            current_object->SetTextureIndex(cell.texture);
 
-            if (add_ground) {
-                current_object = GetGround(base_position);
-                current_object->material = GetMaterialForCharacter(current_char);
-                map->Add(current_object);
-                add_ground = false;
+            if (cell.needs_ground) {
+                AddGround(map, arena, base_position, FLOOR_HEIGHT)->material = material;
             }
 
-            // Add ceiling
-            current_object = GetGround(base_position);
-            current_object->transform->Translate(glm::vec3(0, 0, 2.3));
-            current_object->material = GetMaterialForCharacter(current_char);
-            map->Add(current_object);
+            AddGround(map, arena, base_position, CEILING_HEIGHT)->material = material;
         }
     }
 
     return map;
 }
 
-Material MapLoader::GetMaterialForCharacter(char c) {
-    switch (std::tolower(c)) {
-        case 'a':
-            return Material(1, 0.9f, 0);
-        case 'b':
-            return Material(0.3f, 0.5f, 0.8f);
-        case 'c':
-            return Material(0.5f, 0.7f, 0.1f);
-        case 'd':
-            return Material(0.1f, 0.2f, 0.1f);
-        case 'e':
-            return Material(0.8f, 0.2f, 0.8f);
-        case 's':
-            return Material(0, 1, 0);
-        case 'g':
-            return Material(1, 1, 0);
-        default:
-            return Material();
-    }
+template <>
+GameObject* MapLoader::Place<CELL_GROUND>(Map* map, Arena* arena, char c, const glm::vec3& base_position) const {
+    return AddGround(map, arena, base_position, FLOOR_HEIGHT);
 }
 
-void MapLoader::LoadAssets(GLuint scene_vao) {
-    wall_model_ = new Model("models/cube.txt", scene_vao);
-    BoundingBox::debug_render_model = wall_model_;
+template <>
+GameObject* MapLoader::Place<CELL_WALL>(Map* map, Arena* arena, char c, const glm::vec3& base_position) const {
+    Wall* wall = arena->New<Wall>(models_[CELL_TABLE[c].model], CELL_TABLE[c].solid);
+    wall->transform->Set(TransformBuilder().Scale(glm::vec3(1, 1, 1.3)).Translate(base_position));
+    map->Add(wall);
+    return wall;
+}
 
-    door_model_ = new Model("models/knot.txt", scene_vao);
-    key_model_ = new Model("models/mjolnir.obj", scene_vao);
-    start_model_ = new Model("models/sphere.txt", scene_vao);
-    goal_model_ = new Model("models/goal_crystal.obj", scene_vao);
+template <>
+GameObject* MapLoader::Place<CELL_DOOR>(Map* map, Arena* arena, char c, const glm::vec3& base_position) const {
+    Door* door = arena->New<Door>(models_[CELL_TABLE[c].model], map, c);
+    door->transform->Set(TransformBuilder(base_position));
+    map->Add(door);
+    return door;
 }
 
-GameObject* MapLoader::GetGround(glm::vec3 base_position) const {
-    GameObject* ground = new Wall(wall_model_, false);
-    ground->transform->Translate(glm::vec3(base_position.x, base_position.y, -0.5));
-    ground->SetTextureIndex(TEX1);
+template <>
+GameObject* MapLoader::Place<CELL_KEY>(Map* map, Arena* arena, char c, const glm::vec3& base_position) const {
+    Key* key = arena->New<Key>(models_[CELL_TABLE[c].model], map, c, glm::vec2(base_position));  // Key transforms itself
+    map->Add(key);
+    return key;
+}
 
-    return ground;
+template <>
+GameObject* MapLoader::Place<CELL_SPAWN>(Map* map, Arena* arena, char c, const glm::vec3& base_position) const {
+    Spawn* spawn = arena->New<Spawn>(models_[CELL_TABLE[c].model]);
+    printf("Placing spawn marker at %f, %f, %f\n", base_position.x, base_position.y, 0.0f);
+    spawn->transform->Set(TransformBuilder(glm::vec3(base_position.x, base_position.y, 0)).Scale(0.2f));
+    map->Add(spawn);
+    return spawn;
 }
 
-glm::vec3 MapLoader::GetPositionForCoordinate(int i, int j) {
-    return glm::vec3(i, j, 0) + glm::vec3(0.5) + glm::vec3(0, 0, GROUND_LEVEL);
+template <>
+GameObject* MapLoader::Place<CELL_GOAL>(Map* map, Arena* arena, char c, const glm::vec3& base_position) const {
+    Goal* goal = arena->New<Goal>(models_[CELL_TABLE[c].model], map);
+    goal->transform->Set(TransformBuilder(base_position).Rotate(0.1, glm::vec3(0, 0, 1)));
+    map->Add(goal);
+    return goal;
+}
+
+template <>
+GameObject* MapLoader::Place<CELL_FRACTAL>(Map* map, Arena* arena, char c, const glm::vec3& base_position) const {
+    Fractal* fractal = arena->New<Fractal>(models_[CELL_TABLE[c].model]);
+    fractal->transform->Set(TransformBuilder(glm::vec3(base_position.x, base_position.y, 0.3)).Scale(0.3f));
+    map->Add(fractal);
+    return fractal;
+}
+
+// Indexed by CellKind. CELL_INVALID is filtered out before lookup
+const MapLoader::PlaceFunction MapLoader::PLACE_FUNCTIONS[NUM_CELL_KINDS] = {
+    nullptr,
+    &MapLoader::Place<CELL_GROUND>,
+    &MapLoader::Place<CELL_WALL>,
+    &MapLoader::Place<CELL_DOOR>,
+    &MapLoader::Place<CELL_KEY>,
+    &MapLoader::Place<CELL_SPAWN>,
+    &MapLoader::Place<CELL_GOAL>,
+    &MapLoader::Place<CELL_FRACTAL>,
+};
+
+void MapLoader::LoadAssets(GLuint scene_vao, Arena* arena) {
+    models_[WALL_MODEL] = arena->New<Model>("models/cube.txt", scene_vao, arena);
+    BoundingBox::debug_render_model = models_[WALL_MODEL];
+
+    models_[DOOR_MODEL] = arena->New<Model>("models/knot.txt", scene_vao, arena);
+    models_[KEY_MODEL] = arena->New<Model>("models/mjolnir.obj", scene_vao, arena);
+    models_[START_MODEL] = arena->New<Model>("models/sphere.txt", scene_vao, arena);
+    models_[GOAL_MODEL] = arena->New<Model>("models/goal_crystal.obj", scene_vao, arena);
 }
 
-bool MapLoader::IsDoor(char c) {
-    return c >= 65 && c <= 69;
+Wall* MapLoader::AddGround(Map* map, Arena* arena, glm::vec3 base_position, float height) const {
+    Wall* ground = arena->New<Wall>(models_[CELL_TABLE['0'].model], CELL_TABLE['0'].solid);
+    ground->transform->Set(TransformBuilder(glm::vec3(base_position.x, base_position.y, height)));
+    ground->SetTextureIndex(CELL_TABLE['0'].texture);
+    map->Add(ground);
+
+    return ground;
 }
 
-bool MapLoader::IsKey(char c) {
-    return c >= 97 && c <= 101;
+glm::vec3 MapLoader::GetPositionForCoordinate(int i, int j) {
+    return glm::vec3(i, j, 0) + glm::vec3(0.5) + glm::vec3(0, 0, GROUND_LEVEL);
 }
@@ -1,6 +1,9 @@
 #pragma once
 #include <vector>
+#include "arena.h"
+#include "cell_types.h"
 #include "game_object.h"
+#include "constants.h"
 #include "glad.h"
 #include "map.h"
 #include "material.h"
@@ -11,20 +14,20 @@ class MapLoader {
     MapLoader();
     ~MapLoader();
 
-    Map* LoadMap(const std::string& filename, GLuint scene_vao);
+    // Everything the map needs, from models to the Map itself, is allocated from the arena. Resetting it unloads the map.
+    Map* LoadMap(const std::string& filename, GLuint scene_vao, Arena* arena);
 
    private:
-    static Material GetMaterialForCharacter(char c);
-    void LoadAssets(GLuint scene_vao);
-    GameObject* GetGround(glm::vec3 base_position) const;
+    // Creates, places, and adds to the map the object for one kind of cell. Specialized for each CellKind in map_loader.cpp
+    template <CellKind kind>
+    GameObject* Place(Map* map, Arena* arena, char c, const glm::vec3& base_position) const;
+    typedef GameObject* (MapLoader::*PlaceFunction)(Map*, Arena*, char, const glm::vec3&) const;
+    static const PlaceFunction PLACE_FUNCTIONS[NUM_CELL_KINDS];
+
+    void LoadAssets(GLuint scene_vao, Arena* arena);
+    Wall* AddGround(Map* map, Arena* arena, glm::vec3 base_position, float height) const;
 
     static glm::vec3 GetPositionForCoordinate(int i, int j);
-    static bool IsDoor(char c);
-    static bool IsKey(char c);
 
-    Model* wall_model_ = nullptr;
-    Model* door_model_ = nullptr;
-    Model* key_model_ = nullptr;
-    Model* start_model_ = nullptr;
-    Model* goal_model_ = nullptr;
+    Model* models_[NUM_CELL_MODELS] = {};
 };
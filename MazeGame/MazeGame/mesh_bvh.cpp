@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "constants.h"
+#include "mesh_bvh.h"
+
+using glm::mat4;
+using glm::vec3;
+
+namespace {
+// Separating axis test between a triangle and a box centered on the origin, both in the box's frame. Follows Akenine-Möller's
+// "Fast 3D Triangle-Box Overlap Testing": the box's faces, the triangle's plane, then each edge crossed with each box axis
+bool TriangleOverlapsBox(const vec3 v[3], const vec3& half_extents) {
+    for (int axis = 0; axis < 3; axis++) {
+        float min = std::min(std::min(v[0][axis], v[1][axis]), v[2][axis]);
+        float max = std::max(std::max(v[0][axis], v[1][axis]), v[2][axis]);
+        if (min > half_extents[axis] || max < -half_extents[axis]) return false;
+    }
+
+    vec3 edges[3] = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+    vec3 normal = glm::cross(edges[0], edges[1]);
+    if (std::abs(glm::dot(normal, v[0])) > glm::dot(half_extents, glm::abs(normal))) return false;
+
+    for (int axis = 0; axis < 3; axis++) {
+        vec3 box_axis(0);
+        box_axis[axis] = 1;
+        for (const vec3& edge : edges) {
+            vec3 separating_axis = glm::cross(box_axis, edge);
+            float p0 = glm::dot(v[0], separating_axis), p1 = glm::dot(v[1], separating_axis), p2 = glm::dot(v[2], separating_axis);
+            float radius = glm::dot(half_extents, glm::abs(separating_axis));
+            if (std::min(std::min(p0, p1), p2) > radius || std::max(std::max(p0, p1), p2) < -radius) return false;
+        }
+    }
+
+    return true;
+}
+
+// From Ericson's Real-Time Collision Detection, 5.1.5, which finds which feature of the triangle is closest by region
+vec3 ClosestPointOnTriangle(const vec3& p, const vec3& a, const vec3& b, const vec3& c) {
+    vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) return a;
+
+    vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+
+    vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// Möller-Trumbore, hitting the triangle from either side
+bool RayHitsTriangle(const vec3& origin, const vec3& direction, const vec3& a, const vec3& b, const vec3& c, float* distance) {
+    vec3 ab = b - a, ac = c - a;
+    vec3 p = glm::cross(direction, ac);
+    float determinant = glm::dot(ab, p);
+    if (determinant == 0) return false;  // Parallel to the triangle
+
+    float inverse_determinant = 1.0f / determinant;
+    vec3 s = origin - a;
+    float u = glm::dot(s, p) * inverse_determinant;
+    if (u < 0 || u > 1) return false;
+
+    vec3 q = glm::cross(s, ab);
+    float v = glm::dot(direction, q) * inverse_determinant;
+    if (v < 0 || u + v > 1) return false;
+
+    *distance = glm::dot(ac, q) * inverse_determinant;
+    return true;
+}
+
+// Where the ray enters the box, or 0 if it starts inside. Unlike BoundingBox::RayCast(), starting inside counts, since the
+// triangles a node holds can be anywhere in it
+bool RayEntersBox(const BoundingBox& box, const vec3& origin, const vec3& direction, float max_distance, float* entry) {
+    float box_entry = 0, box_exit = max_distance;
+    vec3 min = box.Min(), max = box.Max();
+    for (int axis = 0; axis < 3; axis++) {
+        if (direction[axis] == 0) {
+            if (origin[axis] < min[axis] || origin[axis] > max[axis]) return false;
+            continue;
+        }
+
+        float t1 = (min[axis] - origin[axis]) / direction[axis];
+        float t2 = (max[axis] - origin[axis]) / direction[axis];
+        box_entry = std::max(box_entry, std::min(t1, t2));
+        box_exit = std::min(box_exit, std::max(t1, t2));
+        if (box_entry > box_exit) return false;
+    }
+
+    *entry = box_entry;
+    return true;
+}
+}  // namespace
+
+MeshBvh::MeshBvh() : nodes_(nullptr), vertices_(nullptr), num_triangles_(0), num_nodes_(0) {}
+
+void MeshBvh::Build(const float* vertex_data, int num_verts, Arena* arena) {
+    num_triangles_ = num_verts / 3;
+    num_nodes_ = 0;
+    if (num_triangles_ == 0) return;
+
+    BuildState state;
+    state.triangle_bounds.resize(num_triangles_);
+    state.centroids.resize(num_triangles_);
+    state.order.resize(num_triangles_);
+    for (int triangle = 0; triangle < num_triangles_; triangle++) {
+        for (int corner = 0; corner < 3; corner++) {
+            const float* position = vertex_data + (triangle * 3 + corner) * ELEMENTS_PER_VERT + POSITION_OFFSET;
+            state.triangle_bounds[triangle].ExpandToBound(vec3(position[0], position[1], position[2]));
+        }
+        state.centroids[triangle] = state.triangle_bounds[triangle].Center();
+        state.order[triangle] = triangle;
+    }
+
+    nodes_ = arena->NewArray<Node>(2 * num_triangles_ - 1);  // The most a binary tree with a triangle per leaf could need
+    state.node_count = 1;
+    BuildNode(&state, 0, 0, num_triangles_, 0);
+    num_nodes_ = state.node_count;
+
+    // Copied in leaf order, so each leaf's triangles sit next to each other
+    vertices_ = arena->NewArray<vec3>(3 * num_triangles_);
+    for (int i = 0; i < num_triangles_; i++) {
+        for (int corner = 0; corner < 3; corner++) {
+            const float* position = vertex_data + (state.order[i] * 3 + corner) * ELEMENTS_PER_VERT + POSITION_OFFSET;
+            vertices_[i * 3 + corner] = vec3(position[0], position[1], position[2]);
+        }
+    }
+}
+
+void MeshBvh::BuildNode(BuildState* state, int node, int first, int count, int depth) {
+    BoundingBox bounds, centroid_bounds;
+    for (int i = first; i < first + count; i++) {
+        bounds.ExpandToBound(state->triangle_bounds[state->order[i]]);
+        centroid_bounds.ExpandToBound(state->centroids[state->order[i]]);
+    }
+
+    nodes_[node].bounds = bounds;
+    nodes_[node].first = first;
+    nodes_[node].count = count;
+    if (count <= MAX_LEAF_TRIANGLES || depth >= MAX_DEPTH) return;
+
+    // Costs are in triangle tests, with visiting a node costing about as much as one. A leaf tests all of its triangles, and a
+    // split visits both children and then tests each side's triangles as often as a random ray would hit that side
+    const float TRAVERSAL_COST = 1.0f;
+    float best_cost = static_cast<float>(count);
+    int best_axis = -1, best_bin = 0;
+    float parent_area = bounds.SurfaceArea();
+    vec3 centroid_min = centroid_bounds.Min();
+    vec3 centroid_extent = centroid_bounds.Max() - centroid_min;
+
+    for (int axis = 0; axis < 3; axis++) {
+        if (centroid_extent[axis] <= 0) continue;  // Every centroid is level along this axis, so it can't split them
+
+        float bin_scale = NUM_BINS / centroid_extent[axis];
+        BoundingBox bin_bounds[NUM_BINS];
+        int bin_counts[NUM_BINS] = {};
+        for (int i = first; i < first + count; i++) {
+            int triangle = state->order[i];
+            int bin = std::min(NUM_BINS - 1, static_cast<int>((state->centroids[triangle][axis] - centroid_min[axis]) * bin_scale));
+            bin_bounds[bin].ExpandToBound(state->triangle_bounds[triangle]);
+            bin_counts[bin]++;
+        }
+
+        // Sweep from the right to get each split's right side, then from the left to score them
+        float right_areas[NUM_BINS];
+        int right_counts[NUM_BINS];
+        BoundingBox right_bounds;
+        int right_count = 0;
+        for (int bin = NUM_BINS - 1; bin > 0; bin--) {
+            if (bin_counts[bin] > 0) right_bounds.ExpandToBound(bin_bounds[bin]);
+            right_count += bin_counts[bin];
+            right_areas[bin] = right_bounds.IsEmpty() ? 0 : right_bounds.SurfaceArea();
+            right_counts[bin] = right_count;
+        }
+
+        BoundingBox left_bounds;
+        int left_count = 0;
+        for (int bin = 0; bin < NUM_BINS - 1; bin++) {  // Splitting between bin and bin + 1
+            if (bin_counts[bin] > 0) left_bounds.ExpandToBound(bin_bounds[bin]);
+            left_count += bin_counts[bin];
+            if (left_count == 0 || right_counts[bin + 1] == 0) continue;
+
+            float cost = TRAVERSAL_COST +
+                         (left_bounds.SurfaceArea() * left_count + right_areas[bin + 1] * right_counts[bin + 1]) / parent_area;
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = bin;
+            }
+        }
+    }
+
+    if (best_axis == -1) return;  // No split beats testing every triangle here
+
+    float bin_scale = NUM_BINS / centroid_extent[best_axis];
+    int* middle = std::partition(state->order.data() + first, state->order.data() + first + count, [&](int triangle) {
+        int bin = std::min(NUM_BINS - 1, static_cast<int>((state->centroids[triangle][best_axis] - centroid_min[best_axis]) * bin_scale));
+        return bin <= best_bin;
+    });
+    int left_count = static_cast<int>(middle - (state->order.data() + first));
+
+    int left = state->node_count.fetch_add(2);
+    nodes_[node].first = left;
+    nodes_[node].count = 0;
+
+    // The two halves touch disjoint ranges of order and claim their own nodes, so they can be built at the same time
+    if (count >= PARALLEL_BUILD_TRIANGLES && depth < MAX_BUILD_THREAD_DEPTH) {
+        std::thread left_builder(&MeshBvh::BuildNode, this, state, left, first, left_count, depth + 1);
+        BuildNode(state, left + 1, first + left_count, count - left_count, depth + 1);
+        left_builder.join();
+    } else {
+        BuildNode(state, left, first, left_count, depth + 1);
+        BuildNode(state, left + 1, first + left_count, count - left_count, depth + 1);
+    }
+}
+
+bool MeshBvh::Overlaps(const OrientedBoundingBox& box, const mat4& transform) const {
+    BoundingBox model_bounds = box.Bounds().Transformed(glm::inverse(transform));
+
+    return AnyLeafTriangle(model_bounds, [&](const vec3* triangle) {
+        vec3 local[3];  // In the box's frame
+        for (int corner = 0; corner < 3; corner++) {
+            vec3 offset = vec3(transform * glm::vec4(triangle[corner], 1.0f)) - box.center;
+            local[corner] = vec3(glm::dot(offset, box.axes[0]), glm::dot(offset, box.axes[1]), glm::dot(offset, box.axes[2]));
+        }
+        return TriangleOverlapsBox(local, box.half_extents);
+    });
+}
+
+bool MeshBvh::Overlaps(const BoundingSphere& sphere, const mat4& transform) const {
+    vec3 radius(sphere.radius);
+    BoundingBox model_bounds = BoundingBox(sphere.center - radius, sphere.center + radius).Transformed(glm::inverse(transform));
+
+    return AnyLeafTriangle(model_bounds, [&](const vec3* triangle) {
+        vec3 a = vec3(transform * glm::vec4(triangle[0], 1.0f));
+        vec3 b = vec3(transform * glm::vec4(triangle[1], 1.0f));
+        vec3 c = vec3(transform * glm::vec4(triangle[2], 1.0f));
+        vec3 offset = ClosestPointOnTriangle(sphere.center, a, b, c) - sphere.center;
+        return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+    });
+}
+
+bool MeshBvh::RayCast(const vec3& origin, const vec3& direction, float max_distance, const mat4& transform, float* distance,
+                      vec3* normal) const {
+    if (num_nodes_ == 0) return false;
+
+    // Distances along the ray are the same in model space, since the transform is affine
+    mat4 inverse = glm::inverse(transform);
+    vec3 model_origin = vec3(inverse * glm::vec4(origin, 1.0f));
+    vec3 model_direction = glm::mat3(inverse) * direction;
+
+    float nearest = max_distance;
+    int nearest_triangle = -1;
+    int stack[STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        const Node& node = nodes_[stack[--stack_size]];
+        float entry;
+        if (!RayEntersBox(node.bounds, model_origin, model_direction, nearest, &entry)) continue;
+
+        if (node.count > 0) {
+            for (int triangle = node.first; triangle < node.first + node.count; triangle++) {
+                const vec3* corners = vertices_ + triangle * 3;
+                float hit_distance;
+                if (RayHitsTriangle(model_origin, model_direction, corners[0], corners[1], corners[2], &hit_distance) &&
+                    hit_distance >= 0 && hit_distance <= nearest) {
+                    nearest = hit_distance;
+                    nearest_triangle = triangle;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child on top, so it's visited first and can cut the search of the other short
+        float left_entry = max_distance, right_entry = max_distance;
+        bool left_hit = RayEntersBox(nodes_[node.first].bounds, model_origin, model_direction, nearest, &left_entry);
+        bool right_hit = RayEntersBox(nodes_[node.first + 1].bounds, model_origin, model_direction, nearest, &right_entry);
+        if (left_hit && right_hit) {
+            bool left_first = left_entry <= right_entry;
+            stack[stack_size++] = left_first ? node.first + 1 : node.first;
+            stack[stack_size++] = left_first ? node.first : node.first + 1;
+        } else if (left_hit) {
+            stack[stack_size++] = node.first;
+        } else if (right_hit) {
+            stack[stack_size++] = node.first + 1;
+        }
+    }
+
+    if (nearest_triangle == -1) return false;
+
+    const vec3* corners = vertices_ + nearest_triangle * 3;
+    vec3 model_normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+    vec3 world_normal = glm::normalize(glm::transpose(glm::mat3(inverse)) * model_normal);  // Normals go by the inverse transpose
+    *normal = glm::dot(world_normal, direction) > 0 ? -world_normal : world_normal;
+    *distance = nearest;
+    return true;
+}
+
+int MeshBvh::NumTriangles() const {
+    return num_triangles_;
+}
+
+int MeshBvh::NumNodes() const {
+    return num_nodes_;
+}
+
+template <typename Callback>
+bool MeshBvh::AnyLeafTriangle(const BoundingBox& model_bounds, Callback callback) const {
+    if (num_nodes_ == 0) return false;
+
+    int stack[STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        const Node& node = nodes_[stack[--stack_size]];
+        if (!node.bounds.ContainsOrIntersects(model_bounds)) continue;
+
+        if (node.count > 0) {
+            for (int triangle = node.first; triangle < node.first + node.count; triangle++) {
+                if (callback(vertices_ + triangle * 3)) return true;
+            }
+            continue;
+        }
+
+        stack[stack_size++] = node.first;
+        stack[stack_size++] = node.first + 1;
+    }
+
+    return false;
+}
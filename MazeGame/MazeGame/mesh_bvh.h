@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include "arena.h"
+#include "bounding_box.h"
+#include "bounding_sphere.h"
+#include "glm.hpp"
+#include "oriented_bounding_box.h"
+
+/**
+ * Bounding volume hierarchy over one model's triangles, built once when the model loads and kept with its vertex data. Splits are
+ * picked by binning triangle centroids and scoring each bin boundary with the surface area heuristic, and big meshes build
+ * their subtrees on several threads.
+ * Queries take a world-space shape and the instance's world transform, walk the tree in model space, and only test the exact
+ * triangles in world space, so they're right under any rotation or scale. They're the narrowphase, meant to run after the
+ * broadphase boxes have already overlapped.
+ */
+class MeshBvh {
+   public:
+    MeshBvh();
+
+    // vertex_data is the model's interleaved vertex array, with every three vertices making up a triangle
+    void Build(const float* vertex_data, int num_verts, Arena* arena);
+
+    bool Overlaps(const OrientedBoundingBox& box, const glm::mat4& transform) const;
+    bool Overlaps(const BoundingSphere& sphere, const glm::mat4& transform) const;
+
+    // Like BoundingBox::RayCast(), except triangles are hit from either side, and a ray that starts inside the mesh hits it on the
+    // way out. normal is in world space and faces back along the ray
+    bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, const glm::mat4& transform, float* distance,
+                 glm::vec3* normal) const;
+
+    int NumTriangles() const;
+    int NumNodes() const;
+
+   private:
+    static const int MAX_LEAF_TRIANGLES = 4;
+    static const int NUM_BINS = 12;
+    static const int PARALLEL_BUILD_TRIANGLES = 4096;  // Subtrees with fewer than this are built on the thread that got them
+    static const int MAX_BUILD_THREAD_DEPTH = 2;       // So at most 4 threads build at once
+    static const int STACK_SIZE = 64;
+    static const int MAX_DEPTH = STACK_SIZE / 2;  // Deeper nodes are made leaves, so a traversal's stack can't overflow
+
+    struct Node {
+        BoundingBox bounds;
+        int first;  // The left child, with the right one just after it, or for leaves the first triangle
+        int count;  // Triangles in a leaf, or 0 for internal nodes
+    };
+
+    // Scratch for a build, which only lasts until it's done
+    struct BuildState {
+        std::vector<BoundingBox> triangle_bounds;
+        std::vector<glm::vec3> centroids;
+        std::vector<int> order;
+        std::atomic<int> node_count;
+    };
+
+    void BuildNode(BuildState* state, int node, int first, int count, int depth);
+    // Calls callback(corners) for the triangles of each leaf that overlaps model_bounds, until it returns true
+    template <typename Callback>
+    bool AnyLeafTriangle(const BoundingBox& model_bounds, Callback callback) const;
+
+    Node* nodes_;
+    glm::vec3* vertices_;  // Three per triangle, in the order the leaves refer to them
+    int num_triangles_;
+    int num_nodes_;
+};
@@ -1,5 +1,7 @@
 #define _CRT_SECURE_NO_WARNINGS
 
+#include <algorithm>
+#include <cmath>
 #include <detail/type_vec3.hpp>
 #include <fstream>
 #include <iostream>
@@ -11,7 +13,7 @@
 using std::string;
 using std::vector;
 
-Model::Model(const string& file, GLuint vao) {
+Model::Model(const string& file, GLuint vao, Arena* arena) {
     unsigned int dot_position = file.find_last_of('.');
     if (dot_position == string::npos) {
         printf("Given file \"%s\" did not have an extension. Exiting...\n", file.c_str());
@@ -20,24 +22,26 @@ Model::Model(const string& file, GLuint vao) {
 
     string extension = file.substr(dot_position + 1, 3);
     if (extension == "txt") {
-        LoadTxt(file);
+        LoadTxt(file, arena);
     } else if (extension == "obj") {
-        LoadObj(file);
+        LoadObj(file, arena);
     } else {
         printf("Unrecognized file extension \"%s\" for file \"%s\". Exiting...\n", extension.c_str(), file.c_str());
         exit(1);
     }
 
     model_vao_ = vao;
+    ComputeBounds();
+    bvh_.Build(model_, num_verts_, arena);
     ModelManager::RegisterModel(this);
 }
 
-void Model::LoadTxt(const std::string& file) {
+void Model::LoadTxt(const std::string& file, Arena* arena) {
     std::ifstream modelFile;
     modelFile.open(file);
     int num_elements;
     modelFile >> num_elements;
-    model_ = new float[num_elements];
+    model_ = arena->NewArray<float>(num_elements);
 
     for (int i = 0; i < num_elements; i++) {
         modelFile >> model_[i];
@@ -50,7 +54,7 @@ void Model::LoadTxt(const std::string& file) {
 
 // Credit for the basis of this methodology goes to http://www.opengl-tutorial.org/beginners-tutorials/tutorial-7-model-loading/
 // This only supports an obj defining vertex positions, normals, and triangles
-void Model::LoadObj(const std::string& filename) {
+void Model::LoadObj(const std::string& filename, Arena* arena) {
     vector<unsigned int> vertex_indices, normal_indices;
     vector<glm::vec3> temp_vertices;
     vector<glm::vec3> temp_normals;
@@ -106,7 +110,7 @@ void Model::LoadObj(const std::string& filename) {
 
     int num_verts = vertex_indices.size();
     int model_size = num_verts * ELEMENTS_PER_VERT;
-    model_ = new float[model_size];
+    model_ = arena->NewArray<float>(model_size);
     for (int vertex_number = 0; vertex_number < num_verts; vertex_number++) {
         int vertex_index = vertex_indices[vertex_number];
         glm::vec3 vertex = temp_vertices[vertex_index - 1];  // subtract 1 because objs are indexed from 1, not 0
@@ -140,11 +144,31 @@ int Model::NumVerts() const {
     return num_verts_;
 }
 
-std::vector<glm::vec3> Model::Vertices() const {
-    std::vector<glm::vec3> verts;
+const BoundingBox& Model::Bounds() const {
+    return bounds_;
+}
+
+const BoundingSphere& Model::Sphere() const {
+    return sphere_;
+}
+
+const MeshBvh& Model::Bvh() const {
+    return bvh_;
+}
+
+void Model::ComputeBounds() {
+    bounds_ = BoundingBox();
+    for (int i = POSITION_OFFSET; i < NumElements(); i += ATTRIBUTE_STRIDE) {
+        bounds_.ExpandToBound(glm::vec3(model_[i], model_[i + 1], model_[i + 2]));
+    }
+
+    // Centered on the box rather than the true minimal sphere, which is plenty tight for these models
+    float max_distance_squared = 0;
+    glm::vec3 center = bounds_.Center();
     for (int i = POSITION_OFFSET; i < NumElements(); i += ATTRIBUTE_STRIDE) {
-        verts.push_back(glm::vec3(model_[i], model_[i + 1], model_[i + 2]));  // These are positions so w=1 for vec4s
+        glm::vec3 offset = glm::vec3(model_[i], model_[i + 1], model_[i + 2]) - center;
+        max_distance_squared = std::max(max_distance_squared, glm::dot(offset, offset));
     }
 
-    return verts;
+    sphere_ = BoundingSphere{center, std::sqrt(max_distance_squared)};
 }
@@ -2,24 +2,36 @@
 #include <detail/type_vec4.hpp>
 #include <string>
 #include <vector>
+#include "arena.h"
+#include "bounding_box.h"
+#include "bounding_sphere.h"
 #include "glad.h"
+#include "mesh_bvh.h"
 
 class Model {
    public:
-    Model(const std::string& file, GLuint vao);
+    Model(const std::string& file, GLuint vao, Arena* arena);  // The vertex data is allocated from the given arena
 
-    void LoadTxt(const std::string& file);
-    void LoadObj(const std::string& file);
+    void LoadTxt(const std::string& file, Arena* arena);
+    void LoadObj(const std::string& file, Arena* arena);
 
     int NumElements() const;
     int NumVerts() const;
 
-    std::vector<glm::vec3> Vertices() const;
+    // Model-space bounds, computed once at load so objects using this model never have to look at its vertices
+    const BoundingBox& Bounds() const;
+    const BoundingSphere& Sphere() const;
+    const MeshBvh& Bvh() const;  // Over the triangles, for queries that need the model's real shape
 
     float* model_;
     int vbo_vertex_start_index_;
     GLuint model_vao_;
 
    private:
+    void ComputeBounds();
+
     int num_verts_;
+    BoundingBox bounds_;
+    BoundingSphere sphere_;
+    MeshBvh bvh_;
 };
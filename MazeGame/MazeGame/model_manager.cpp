@@ -1,5 +1,6 @@
 #include <algorithm>
 #include "constants.h"
+#include "gl_state.h"
 #include "model_manager.h"
 
 void ModelManager::RegisterModel(Model* model) {
@@ -18,18 +19,26 @@ void ModelManager::InitVBO() {
     }
 
     glGenBuffers(1, &vbo_);               // Create 1 buffer called vbo
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);  // Set the vbo as the active array buffer (Only one buffer can be active at a time)
+    GLState::BindBuffer(GL_ARRAY_BUFFER, vbo_);  // Set the vbo as the active array buffer (Only one buffer can be active at a time)
     glBufferData(GL_ARRAY_BUFFER, NumElements() * sizeof(float), model_data, GL_STATIC_DRAW);  // upload vertices to vbo
+    delete[] model_data;
 }
 
 void ModelManager::Cleanup() {
-    glDeleteBuffers(1, &vbo_);
+    GLState::DeleteBuffer(vbo_);
+    vbo_ = 0;
+    models_.clear();
+    num_verts_ = 0;
 }
 
 int ModelManager::NumElements() {
     return num_verts_ * ELEMENTS_PER_VERT;
 }
 
+GLuint ModelManager::VBO() {
+    return vbo_;
+}
+
 std::vector<Model*> ModelManager::models_;
 int ModelManager::num_verts_;
 GLuint ModelManager::vbo_;
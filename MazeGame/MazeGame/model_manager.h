@@ -8,9 +8,10 @@ class ModelManager {
     static void RegisterModel(Model* model);
 
     static void InitVBO();
-    static void Cleanup();
+    static void Cleanup();  // Deletes the VBO and forgets every registered model, ready for the next level's models
 
     static int NumElements();
+    static GLuint VBO();  // Every registered model's vertices, one after another
 
    private:
     static std::vector<Model*> models_;
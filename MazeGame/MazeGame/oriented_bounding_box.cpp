@@ -0,0 +1,77 @@
+#include <cmath>
+#include "constants.h"
+#include "oriented_bounding_box.h"
+
+using glm::vec3;
+
+OrientedBoundingBox::OrientedBoundingBox(const BoundingBox& model_bounds, const glm::mat4& transform) {
+    center = vec3(transform * glm::vec4(model_bounds.Center(), 1.0f));
+    vec3 model_half_extents = model_bounds.HalfExtents();
+
+    for (int i = 0; i < 3; i++) {
+        vec3 column = vec3(transform[i]);
+        float length = glm::length(column);
+        if (length > ABSOLUTE_TOLERANCE) {
+            axes[i] = column / length;
+            half_extents[i] = model_half_extents[i] * length;
+        } else {  // Scaled down to nothing along this axis, so any axis will do
+            axes[i] = vec3(0);
+            axes[i][i] = 1;
+            half_extents[i] = 0;
+        }
+    }
+}
+
+OrientedBoundingBox::OrientedBoundingBox(const BoundingBox& world_bounds) : OrientedBoundingBox(world_bounds, glm::mat4()) {}
+
+// Separating axis test over the 15 candidate axes, following Ericson's Real-Time Collision Detection, 4.4.1
+bool OrientedBoundingBox::Intersects(const OrientedBoundingBox& other) const {
+    float rotation[3][3], abs_rotation[3][3];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            rotation[i][j] = glm::dot(axes[i], other.axes[j]);
+            abs_rotation[i][j] = std::abs(rotation[i][j]) + ABSOLUTE_TOLERANCE;  // Keeps near-parallel edge pairs from a false negative
+        }
+    }
+
+    vec3 offset = other.center - center;
+    vec3 t = vec3(glm::dot(offset, axes[0]), glm::dot(offset, axes[1]), glm::dot(offset, axes[2]));
+    const vec3& a = half_extents;
+    const vec3& b = other.half_extents;
+
+    // This box's face normals
+    for (int i = 0; i < 3; i++) {
+        float radius_b = b[0] * abs_rotation[i][0] + b[1] * abs_rotation[i][1] + b[2] * abs_rotation[i][2];
+        if (std::abs(t[i]) > a[i] + radius_b) return false;
+    }
+
+    // The other box's face normals
+    for (int j = 0; j < 3; j++) {
+        float radius_a = a[0] * abs_rotation[0][j] + a[1] * abs_rotation[1][j] + a[2] * abs_rotation[2][j];
+        float distance = t[0] * rotation[0][j] + t[1] * rotation[1][j] + t[2] * rotation[2][j];
+        if (std::abs(distance) > radius_a + b[j]) return false;
+    }
+
+    // Cross products of each pair of edges
+    for (int i = 0; i < 3; i++) {
+        int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+        for (int j = 0; j < 3; j++) {
+            int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+            float radius_a = a[i1] * abs_rotation[i2][j] + a[i2] * abs_rotation[i1][j];
+            float radius_b = b[j1] * abs_rotation[i][j2] + b[j2] * abs_rotation[i][j1];
+            float distance = t[i2] * rotation[i1][j] - t[i1] * rotation[i2][j];
+            if (std::abs(distance) > radius_a + radius_b) return false;
+        }
+    }
+
+    return true;
+}
+
+bool OrientedBoundingBox::Intersects(const BoundingBox& other) const {
+    return Intersects(OrientedBoundingBox(other));
+}
+
+BoundingBox OrientedBoundingBox::Bounds() const {
+    vec3 extent = glm::abs(axes[0]) * half_extents.x + glm::abs(axes[1]) * half_extents.y + glm::abs(axes[2]) * half_extents.z;
+    return BoundingBox(center - extent, center + extent);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "bounding_box.h"
+#include "glm.hpp"
+
+/**
+ * A box with its own orthonormal axes. Built from a model-space BoundingBox and the owner's world transform, so it stays tight
+ * around rotated objects where the world-space BoundingBox doesn't. Intersection uses the separating axis test.
+ */
+class OrientedBoundingBox {
+   public:
+    OrientedBoundingBox(const BoundingBox& model_bounds, const glm::mat4& transform);
+    explicit OrientedBoundingBox(const BoundingBox& world_bounds);
+
+    bool Intersects(const OrientedBoundingBox& other) const;
+    bool Intersects(const BoundingBox& other) const;
+
+    BoundingBox Bounds() const;  // The world-space axis-aligned box around this one
+
+    glm::vec3 center;
+    glm::vec3 axes[3];  // Unit length
+    glm::vec3 half_extents;
+};
@@ -0,0 +1,256 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "frame_allocator.h"
+#include "overlap_kernels.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define OVERLAP_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_SSE
+#define TARGET_AVX2
+#else
+#define TARGET_SSE __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+static_assert(BoundsSoA::LANES == 8, "The kernels write one byte of mask per group of boxes");
+
+namespace {
+
+// The six coordinate arrays, fetched once per call rather than once per group
+struct Columns {
+    const float *min_x, *min_y, *min_z, *max_x, *max_y, *max_z;
+
+    explicit Columns(const BoundsSoA& boxes)
+        : min_x(boxes.MinX()), min_y(boxes.MinY()), min_z(boxes.MinZ()), max_x(boxes.MaxX()), max_y(boxes.MaxY()), max_z(boxes.MaxZ()) {}
+};
+
+//// Scalar kernel. This is also the reference result for the SIMD versions ////
+
+void OverlapScalar(const BoundsSoA& boxes, const float* query_min, const float* query_max, uint8_t* group_masks) {
+    Columns columns(boxes);
+
+    int count = boxes.PaddedSize();
+    for (int group = 0; group < count; group += BoundsSoA::LANES) {
+        uint8_t mask = 0;
+        for (int lane = 0; lane < BoundsSoA::LANES; lane++) {
+            int i = group + lane;
+            bool overlaps = columns.min_x[i] <= query_max[0] && query_min[0] <= columns.max_x[i] && columns.min_y[i] <= query_max[1] &&
+                            query_min[1] <= columns.max_y[i] && columns.min_z[i] <= query_max[2] && query_min[2] <= columns.max_z[i];
+            if (overlaps) mask |= 1 << lane;
+        }
+        group_masks[group / BoundsSoA::LANES] = mask;
+    }
+}
+
+#ifdef OVERLAP_KERNELS_X86
+
+//// SSE kernel: four boxes per comparison, two comparisons per group ////
+
+TARGET_SSE inline int OverlapFourSse(const Columns& columns, int i, const __m128* query_min, const __m128* query_max) {
+    __m128 overlaps = _mm_cmple_ps(_mm_loadu_ps(columns.min_x + i), query_max[0]);
+    overlaps = _mm_and_ps(overlaps, _mm_cmple_ps(query_min[0], _mm_loadu_ps(columns.max_x + i)));
+    overlaps = _mm_and_ps(overlaps, _mm_cmple_ps(_mm_loadu_ps(columns.min_y + i), query_max[1]));
+    overlaps = _mm_and_ps(overlaps, _mm_cmple_ps(query_min[1], _mm_loadu_ps(columns.max_y + i)));
+    overlaps = _mm_and_ps(overlaps, _mm_cmple_ps(_mm_loadu_ps(columns.min_z + i), query_max[2]));
+    overlaps = _mm_and_ps(overlaps, _mm_cmple_ps(query_min[2], _mm_loadu_ps(columns.max_z + i)));
+    return _mm_movemask_ps(overlaps);
+}
+
+TARGET_SSE void OverlapSse(const BoundsSoA& boxes, const float* query_min, const float* query_max, uint8_t* group_masks) {
+    __m128 query_min_splat[3], query_max_splat[3];
+    for (int axis = 0; axis < 3; axis++) {
+        query_min_splat[axis] = _mm_set1_ps(query_min[axis]);
+        query_max_splat[axis] = _mm_set1_ps(query_max[axis]);
+    }
+    Columns columns(boxes);
+
+    int count = boxes.PaddedSize();
+    for (int group = 0; group < count; group += BoundsSoA::LANES) {
+        int low = OverlapFourSse(columns, group, query_min_splat, query_max_splat);
+        int high = OverlapFourSse(columns, group + 4, query_min_splat, query_max_splat);
+        group_masks[group / BoundsSoA::LANES] = static_cast<uint8_t>(low | (high << 4));
+    }
+}
+
+//// AVX2 kernel: eight boxes per comparison, sixteen per iteration so the two groups' loads overlap ////
+
+TARGET_AVX2 inline int OverlapEightAvx2(const Columns& columns, int i, const __m256* query_min, const __m256* query_max) {
+    __m256 overlaps = _mm256_cmp_ps(_mm256_loadu_ps(columns.min_x + i), query_max[0], _CMP_LE_OQ);
+    overlaps = _mm256_and_ps(overlaps, _mm256_cmp_ps(query_min[0], _mm256_loadu_ps(columns.max_x + i), _CMP_LE_OQ));
+    overlaps = _mm256_and_ps(overlaps, _mm256_cmp_ps(_mm256_loadu_ps(columns.min_y + i), query_max[1], _CMP_LE_OQ));
+    overlaps = _mm256_and_ps(overlaps, _mm256_cmp_ps(query_min[1], _mm256_loadu_ps(columns.max_y + i), _CMP_LE_OQ));
+    overlaps = _mm256_and_ps(overlaps, _mm256_cmp_ps(_mm256_loadu_ps(columns.min_z + i), query_max[2], _CMP_LE_OQ));
+    overlaps = _mm256_and_ps(overlaps, _mm256_cmp_ps(query_min[2], _mm256_loadu_ps(columns.max_z + i), _CMP_LE_OQ));
+    return _mm256_movemask_ps(overlaps);
+}
+
+TARGET_AVX2 void OverlapAvx2(const BoundsSoA& boxes, const float* query_min, const float* query_max, uint8_t* group_masks) {
+    __m256 query_min_splat[3], query_max_splat[3];
+    for (int axis = 0; axis < 3; axis++) {
+        query_min_splat[axis] = _mm256_set1_ps(query_min[axis]);
+        query_max_splat[axis] = _mm256_set1_ps(query_max[axis]);
+    }
+    Columns columns(boxes);
+
+    int count = boxes.PaddedSize();
+    int group = 0;
+    for (; group + 2 * BoundsSoA::LANES <= count; group += 2 * BoundsSoA::LANES) {
+        int first = OverlapEightAvx2(columns, group, query_min_splat, query_max_splat);
+        int second = OverlapEightAvx2(columns, group + BoundsSoA::LANES, query_min_splat, query_max_splat);
+        group_masks[group / BoundsSoA::LANES] = static_cast<uint8_t>(first);
+        group_masks[group / BoundsSoA::LANES + 1] = static_cast<uint8_t>(second);
+    }
+
+    if (group < count) {
+        group_masks[group / BoundsSoA::LANES] = static_cast<uint8_t>(OverlapEightAvx2(columns, group, query_min_splat, query_max_splat));
+    }
+}
+
+#endif  // OVERLAP_KERNELS_X86
+
+inline int CountTrailingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+double MillisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+}  // namespace
+
+void OverlapKernels::Init() {
+    if (!Use(TransformKernels::AVX2) && !Use(TransformKernels::SSE)) {
+        Use(TransformKernels::SCALAR);
+    }
+
+    printf("Overlap kernels: using %s\n", TransformKernels::Name(active_));
+}
+
+bool OverlapKernels::Use(TransformKernels::Implementation implementation) {
+    if (!TransformKernels::IsSupported(implementation)) return false;
+
+    switch (implementation) {
+#ifdef OVERLAP_KERNELS_X86
+        case TransformKernels::AVX2:
+            overlap_ = OverlapAvx2;
+            break;
+        case TransformKernels::SSE:
+            overlap_ = OverlapSse;
+            break;
+#endif
+        default:
+            overlap_ = OverlapScalar;
+            break;
+    }
+
+    active_ = implementation;
+    return true;
+}
+
+TransformKernels::Implementation OverlapKernels::Active() {
+    return active_;
+}
+
+size_t OverlapKernels::MaskWords(const BoundsSoA& boxes) {
+    return (boxes.PaddedSize() + 31) / 32;
+}
+
+void OverlapKernels::Overlap(const BoundingBox& query, const BoundsSoA& boxes, uint32_t* masks) {
+    size_t words = MaskWords(boxes);
+    if (words == 0) return;
+
+    masks[words - 1] = 0;  // The kernel may only fill part of the last word
+    glm::vec3 query_min = query.Min(), query_max = query.Max();
+    // x86 is little-endian, so the byte for group g lands in bits 8g to 8g + 7 of the words
+    overlap_(boxes, &query_min.x, &query_max.x, reinterpret_cast<uint8_t*>(masks));
+}
+
+int OverlapKernels::CompactOverlaps(const BoundingBox& query, const BoundsSoA& boxes, int* indices) {
+    const size_t MAX_WORDS_ON_STACK = 128;  // 4096 boxes
+    uint32_t stack_masks[MAX_WORDS_ON_STACK];
+
+    size_t words = MaskWords(boxes);
+    uint32_t* masks = stack_masks;
+    if (words > MAX_WORDS_ON_STACK) {
+        masks = static_cast<uint32_t*>(FrameAllocator::Allocate(words * sizeof(uint32_t), alignof(uint32_t)));
+    }
+    Overlap(query, boxes, masks);
+
+    int count = 0;
+    for (size_t word = 0; word < words; word++) {
+        for (uint32_t bits = masks[word]; bits != 0; bits &= bits - 1) {  // Clears the lowest set bit each time
+            indices[count++] = static_cast<int>(word * 32) + CountTrailingZeros(bits);
+        }
+    }
+
+    return count;
+}
+
+void OverlapKernels::RunBenchmark() {
+    const int grid_size = 64;
+    const int iterations = 2000;
+
+    // A map-sized field of unit boxes, queried with a player-sized box that walks across it
+    Arena arena;
+    BoundsSoA boxes(&arena);
+    std::vector<BoundingBox> box_list;
+    for (int y = 0; y < grid_size; y++) {
+        for (int x = 0; x < grid_size; x++) {
+            BoundingBox box(glm::vec3(x, y, 0), glm::vec3(x + 1, y + 1, 1));
+            boxes.Add(box);
+            box_list.push_back(box);
+        }
+    }
+
+    std::vector<int> expected(boxes.Size()), indices(boxes.Size());
+    int expected_total = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        float offset = (iteration % grid_size) + 0.5f;
+        BoundingBox query(glm::vec3(offset - 0.15f, offset - 0.15f, 0.25f), glm::vec3(offset + 0.15f, offset + 0.15f, 0.75f));
+        int count = 0;
+        for (size_t i = 0; i < box_list.size(); i++) {
+            if (box_list[i].ContainsOrIntersects(query)) expected[count++] = static_cast<int>(i);
+        }
+        expected_total += count;
+    }
+    double baseline_time = MillisecondsSince(start);
+
+    printf("Overlap kernel benchmark: %d boxes x %d queries\n", boxes.Size(), iterations);
+    printf("  %-10s %8.3f ms\n", "BoundingBox", baseline_time);
+
+    TransformKernels::Implementation previous = active_;
+    for (TransformKernels::Implementation implementation : {TransformKernels::SCALAR, TransformKernels::SSE, TransformKernels::AVX2}) {
+        if (!Use(implementation)) {
+            printf("  %-10s not supported on this CPU\n", TransformKernels::Name(implementation));
+            continue;
+        }
+
+        int total = 0;
+        start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            float offset = (iteration % grid_size) + 0.5f;
+            BoundingBox query(glm::vec3(offset - 0.15f, offset - 0.15f, 0.25f), glm::vec3(offset + 0.15f, offset + 0.15f, 0.75f));
+            total += CompactOverlaps(query, boxes, indices.data());
+        }
+        double time = MillisecondsSince(start);
+
+        printf("  %-10s %8.3f ms  (%s)\n", TransformKernels::Name(implementation), time, total == expected_total ? "matches" : "MISMATCH");
+    }
+
+    Use(previous);
+}
+
+TransformKernels::Implementation OverlapKernels::active_ = TransformKernels::SCALAR;
+OverlapKernels::OverlapFunction OverlapKernels::overlap_ = OverlapScalar;
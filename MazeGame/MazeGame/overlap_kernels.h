@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "bounding_box.h"
+#include "bounds_soa.h"
+#include "transform_kernels.h"
+
+/**
+ * Tests one box against every box in a BoundsSoA: eight per instruction with AVX2, four with SSE. Like TransformKernels,
+ * Init() picks the widest implementation the CPU supports. Touching boxes count as overlapping, like
+ * BoundingBox::ContainsOrIntersects.
+ */
+class OverlapKernels {
+   public:
+    static void Init();
+    static bool Use(TransformKernels::Implementation implementation);  // Returns false (and changes nothing) if the CPU can't run it
+    static TransformKernels::Implementation Active();
+
+    static size_t MaskWords(const BoundsSoA& boxes);  // How many words Overlap() writes
+
+    // Sets bit i % 32 of masks[i / 32] if box i overlaps query, and clears it if not. Padding boxes always come back clear
+    static void Overlap(const BoundingBox& query, const BoundsSoA& boxes, uint32_t* masks);
+
+    // Writes the indices of the boxes that overlap query in increasing order, and returns how many there are. indices needs room
+    // for boxes.Size() of them
+    static int CompactOverlaps(const BoundingBox& query, const BoundsSoA& boxes, int* indices);
+
+    // Times each supported implementation against a BoundingBox::ContainsOrIntersects loop and prints the results
+    static void RunBenchmark();
+
+   private:
+    // Writes one byte per group of BoundsSoA::LANES boxes, bit i set if box i of the group overlaps
+    typedef void (*OverlapFunction)(const BoundsSoA& boxes, const float* query_min, const float* query_max, uint8_t* group_masks);
+
+    static TransformKernels::Implementation active_;
+    static OverlapFunction overlap_;
+};
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "constants.h"
+#include "game_object.h"
+#include "job_system.h"
+#include "map.h"
+#include "physics_world.h"
+
+namespace {
+bool ByObject(const std::pair<const GameObject*, int>& a, const std::pair<const GameObject*, int>& b) {
+    return std::less<const GameObject*>()(a.first, b.first);
+}
+
+// Corners of a box, in the same order as BoundingBox::GetBoxVertices()
+void BoxCorners(const glm::vec3& center, const glm::mat3& axes, const glm::vec3& half_extents, glm::vec3 corners[8]) {
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 sign((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+        corners[i] = center + axes * (sign * half_extents);
+    }
+}
+}  // namespace
+
+PhysicsWorld::PhysicsWorld(Arena* arena, Map* map)
+    : map_(map),
+      bodies_(ArenaAllocator<Body>(arena)),
+      bodies_by_object_(ArenaAllocator<std::pair<const GameObject*, int>>(arena)),
+      substep_(SIMULATION_STEP / PHYSICS_SUBSTEPS) {}
+
+int PhysicsWorld::AddBody(GameObject* object, float mass) {
+    Body body;
+    body.object = object;
+    body.state = BODY_ASLEEP;
+    body.velocity = body.angular_velocity = glm::vec3(0);
+    body.local_center = object->model_bounds.Center();
+    body.still_time = 0;
+    body.island = 0;
+    ReadTransform(body);
+
+    // A solid box's inertia, from the box the contacts use
+    glm::vec3 size_squared = 4.0f * body.half_extents * body.half_extents;
+    glm::vec3 inertia = mass / 12.0f * glm::vec3(size_squared.y + size_squared.z, size_squared.x + size_squared.z,
+                                                  size_squared.x + size_squared.y);
+    body.inverse_mass = 1.0f / mass;
+    body.inverse_inertia = 1.0f / glm::max(inertia, glm::vec3(ABSOLUTE_TOLERANCE));
+
+    int id = static_cast<int>(bodies_.size());
+    bodies_.push_back(body);
+
+    auto entry = std::make_pair(static_cast<const GameObject*>(object), id);
+    bodies_by_object_.insert(std::upper_bound(bodies_by_object_.begin(), bodies_by_object_.end(), entry, ByObject), entry);
+    return id;
+}
+
+void PhysicsWorld::Hold(int body) {
+    bodies_[body].state = BODY_HELD;
+    bodies_[body].velocity = bodies_[body].angular_velocity = glm::vec3(0);
+}
+
+void PhysicsWorld::Release(int body, const glm::vec3& velocity, const glm::vec3& angular_velocity) {
+    Body& released = bodies_[body];
+    ReadTransform(released);
+    released.velocity = velocity;
+    released.angular_velocity = angular_velocity;
+    released.state = BODY_AWAKE;
+    released.still_time = 0;
+}
+
+BodyState PhysicsWorld::State(int body) const {
+    return bodies_[body].state;
+}
+
+int PhysicsWorld::AwakeBodies() const {
+    int awake = 0;
+    for (const Body& body : bodies_) {
+        if (body.state == BODY_AWAKE) awake++;
+    }
+    return awake;
+}
+
+void PhysicsWorld::Step(float dt) {
+    // Bodies are only ever written back if they were awake at some point in the step, so a world that's all asleep costs one pass
+    // over the states
+    FrameVector<int> moved;
+    for (int i = 0; i < static_cast<int>(bodies_.size()); i++) {
+        if (bodies_[i].state == BODY_AWAKE) moved.push_back(i);
+    }
+    if (moved.empty()) return;
+
+    // Always the same number of substeps and iterations, so the cost is bounded by how many bodies are awake
+    substep_ = dt / PHYSICS_SUBSTEPS;
+    FrameVector<Contact> contacts;
+    for (int substep = 0; substep < PHYSICS_SUBSTEPS; substep++) {
+        // Bodies only affect each other through contacts, so everything either side of the solver is split across threads
+        JobSystem::ParallelFor("Physics forces", static_cast<int>(bodies_.size()), JOB_BODIES_PER_CHUNK, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                Body& body = bodies_[i];
+                if (body.state != BODY_AWAKE) continue;
+                body.velocity.z -= PHYSICS_GRAVITY * substep_;
+                UpdateInertia(body);
+            }
+        });
+
+        contacts.clear();
+        FindContacts(contacts);
+        for (Contact& contact : contacts) PrepareContact(contact);
+        for (int iteration = 0; iteration < PHYSICS_ITERATIONS; iteration++) {
+            for (Contact& contact : contacts) SolveContact(contact);
+        }
+
+        JobSystem::ParallelFor("Physics integration", static_cast<int>(bodies_.size()), JOB_BODIES_PER_CHUNK, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                Body& body = bodies_[i];
+                if (body.state != BODY_AWAKE) continue;
+
+                body.position += body.velocity * substep_;
+                glm::quat spin(0, body.angular_velocity.x, body.angular_velocity.y, body.angular_velocity.z);
+                body.orientation = glm::normalize(body.orientation + (spin * body.orientation) * (0.5f * substep_));
+            }
+        });
+    }
+
+    UpdateSleep(dt, contacts);
+
+    for (int i : moved) {
+        if (bodies_[i].state == BODY_ASLEEP) WriteTransform(bodies_[i]);  // Fell asleep this step
+    }
+    for (const Body& body : bodies_) {
+        if (body.state == BODY_AWAKE) WriteTransform(body);  // Including any woken partway through
+    }
+}
+
+void PhysicsWorld::ReadTransform(Body& body) {
+    glm::mat4 world = body.object->transform->WorldTransform();
+    glm::mat3 columns(world);
+    body.scale = glm::vec3(glm::length(columns[0]), glm::length(columns[1]), glm::length(columns[2]));
+    glm::mat3 rotation(columns[0] / body.scale.x, columns[1] / body.scale.y, columns[2] / body.scale.z);
+
+    body.orientation = glm::normalize(glm::quat_cast(rotation));
+    body.position = glm::vec3(world * glm::vec4(body.local_center, 1));
+    body.half_extents = body.object->model_bounds.HalfExtents() * body.scale;
+}
+
+void PhysicsWorld::UpdateInertia(Body& body) {
+    glm::mat3 rotation = glm::mat3_cast(body.orientation);
+    glm::mat3 scaled(rotation[0] * body.inverse_inertia.x, rotation[1] * body.inverse_inertia.y, rotation[2] * body.inverse_inertia.z);
+    body.world_inverse_inertia = scaled * glm::transpose(rotation);
+}
+
+void PhysicsWorld::WriteTransform(const Body& body) {
+    TransformBuilder transform;
+    transform.translation = body.position - body.orientation * (body.scale * body.local_center);
+    transform.rotation = body.orientation;
+    transform.scale = body.scale;
+
+    body.object->transform->Set(transform);
+    body.object->UpdateWorldBounds();  // The broadphase and triggers see it where it landed this step, not the last
+}
+
+void PhysicsWorld::Wake(int body) {
+    if (bodies_[body].state != BODY_ASLEEP) return;
+
+    bodies_[body].state = BODY_AWAKE;
+    bodies_[body].still_time = 0;
+    UpdateInertia(bodies_[body]);  // It missed this substep's update, and the contacts it's about to be in need it
+}
+
+int PhysicsWorld::FindBody(const GameObject* object) const {
+    auto entry = std::make_pair(object, 0);
+    auto found = std::lower_bound(bodies_by_object_.begin(), bodies_by_object_.end(), entry, ByObject);
+    return found != bodies_by_object_.end() && found->first == object ? found->second : -1;
+}
+
+void PhysicsWorld::FindContacts(FrameVector<Contact>& contacts) {
+    FrameVector<BoundingBox> solids;
+    FrameVector<GameObject*> neighbours;
+    for (int i = 0; i < static_cast<int>(bodies_.size()); i++) {
+        if (bodies_[i].state != BODY_AWAKE) continue;
+
+        glm::vec3 center = bodies_[i].position;
+        glm::mat3 axes = glm::mat3_cast(bodies_[i].orientation);
+        glm::vec3 half_extents = bodies_[i].half_extents;
+
+        glm::vec3 corners[8];
+        BoxCorners(center, axes, half_extents, corners);
+        BoundingBox region(corners, 8);
+        region = BoundingBox(region.Min() - glm::vec3(PHYSICS_CONTACT_MARGIN), region.Max() + glm::vec3(PHYSICS_CONTACT_MARGIN));
+
+        // The floor cubes aren't solid, since the player walks on GROUND_LEVEL instead, so the ground is a plane of its own
+        for (const glm::vec3& corner : corners) {
+            float depth = GROUND_LEVEL - corner.z;
+            if (depth > -PHYSICS_CONTACT_MARGIN) {
+                Contact contact;
+                contact.a = i;
+                contact.b = -1;
+                contact.normal = glm::vec3(0, 0, 1);
+                contact.point = corner;
+                contact.depth = depth;
+                contacts.push_back(contact);
+            }
+        }
+
+        solids.clear();
+        map_->GatherSolidBounds(region, bodies_[i].object, solids);
+        for (const BoundingBox& solid : solids) {
+            AddBoxContacts(i, -1, solid.Center(), glm::mat3(), solid.HalfExtents(), contacts);
+        }
+
+        neighbours.clear();
+        map_->GatherObjects(region, BROADPHASE_RIGID_BODY, bodies_[i].object, neighbours);
+        for (GameObject* neighbour : neighbours) {
+            int j = FindBody(neighbour);
+            if (j < 0 || bodies_[j].state == BODY_HELD) continue;
+            if (bodies_[j].state == BODY_AWAKE && j < i) continue;  // The pair was already done from j's side
+
+            size_t first_contact = contacts.size();
+            glm::mat3 other_axes = glm::mat3_cast(bodies_[j].orientation);
+            AddBoxContacts(i, j, bodies_[j].position, other_axes, bodies_[j].half_extents, contacts);
+            AddBoxContacts(j, i, center, axes, half_extents, contacts);
+
+            // Anything awake touching a sleeping body wakes it. The contact puts them in the same island, so they sleep again
+            // together. Waking on broadphase overlap alone would have neighbours that never touch waking each other forever
+            if (contacts.size() != first_contact) Wake(j);
+        }
+    }
+}
+
+void PhysicsWorld::AddBoxContacts(int a, int b, const glm::vec3& center, const glm::mat3& axes, const glm::vec3& half_extents,
+                                  FrameVector<Contact>& contacts) {
+    // Each of a's corners that's inside b's box (or within the margin of it) pushes out through the face it's least deep behind.
+    // Edges crossing without either box's corners inside are missed, which a key resting or tumbling against a wall rarely needs
+    glm::vec3 corners[8];
+    BoxCorners(bodies_[a].position, glm::mat3_cast(bodies_[a].orientation), bodies_[a].half_extents, corners);
+    glm::mat3 to_local = glm::transpose(axes);
+    for (const glm::vec3& corner : corners) {
+        glm::vec3 local = to_local * (corner - center);
+        glm::vec3 inside = half_extents - glm::abs(local);  // Per axis, how far in from the nearer face
+        if (std::min(std::min(inside.x, inside.y), inside.z) <= -PHYSICS_CONTACT_MARGIN) continue;
+
+        int axis = inside.x < inside.y ? (inside.x < inside.z ? 0 : 2) : (inside.y < inside.z ? 1 : 2);
+        Contact contact;
+        contact.a = a;
+        contact.b = b;
+        contact.normal = axes[axis] * (local[axis] < 0 ? -1.0f : 1.0f);
+        contact.point = corner;
+        contact.depth = inside[axis];
+        contacts.push_back(contact);
+    }
+}
+
+void PhysicsWorld::PrepareContact(Contact& contact) const {
+    glm::vec3 helper = std::abs(contact.normal.z) < 0.9f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+    contact.tangents[0] = glm::normalize(glm::cross(contact.normal, helper));
+    contact.tangents[1] = glm::cross(contact.normal, contact.tangents[0]);
+    contact.normal_impulse = contact.tangent_impulses[0] = contact.tangent_impulses[1] = 0;
+
+    // The bodies only turn between substeps, so these hold for every iteration
+    contact.normal_mass = InverseMassAlong(contact.a, contact.point, contact.normal) +
+                          InverseMassAlong(contact.b, contact.point, contact.normal);
+    for (int t = 0; t < 2; t++) {
+        contact.tangent_masses[t] = InverseMassAlong(contact.a, contact.point, contact.tangents[t]) +
+                                    InverseMassAlong(contact.b, contact.point, contact.tangents[t]);
+    }
+
+    glm::vec3 relative = VelocityAt(contact.a, contact.point) - VelocityAt(contact.b, contact.point);
+    float approach = glm::dot(relative, contact.normal);
+    contact.bounce = approach < -PHYSICS_RESTITUTION_THRESHOLD ? -PHYSICS_RESTITUTION * approach : 0.0f;
+}
+
+void PhysicsWorld::SolveContact(Contact& contact) {
+    glm::vec3 relative = VelocityAt(contact.a, contact.point) - VelocityAt(contact.b, contact.point);
+    float normal_speed = glm::dot(relative, contact.normal);
+
+    // Still apart, it can close the gap this substep but no more. Once touching, it has to bounce or back out of any overlap past
+    // the slop, a fraction at a time so a deep overlap doesn't launch it
+    float target;
+    if (contact.depth < 0) {
+        target = contact.depth / substep_;
+    } else {
+        target = std::max(contact.bounce, PHYSICS_BAUMGARTE * std::max(contact.depth - PHYSICS_PENETRATION_SLOP, 0.0f) / substep_);
+    }
+
+    float previous = contact.normal_impulse;
+    contact.normal_impulse = std::max(previous + (target - normal_speed) / contact.normal_mass, 0.0f);
+    ApplyImpulse(contact.a, contact.b, contact.point, (contact.normal_impulse - previous) * contact.normal);
+
+    // Coulomb friction along two tangents, bounded by how hard the contact is pushing
+    float limit = PHYSICS_FRICTION * contact.normal_impulse;
+    for (int t = 0; t < 2; t++) {
+        relative = VelocityAt(contact.a, contact.point) - VelocityAt(contact.b, contact.point);
+        previous = contact.tangent_impulses[t];
+        float impulse = previous - glm::dot(relative, contact.tangents[t]) / contact.tangent_masses[t];
+        contact.tangent_impulses[t] = glm::clamp(impulse, -limit, limit);
+        ApplyImpulse(contact.a, contact.b, contact.point, (contact.tangent_impulses[t] - previous) * contact.tangents[t]);
+    }
+}
+
+void PhysicsWorld::ApplyImpulse(int a, int b, const glm::vec3& point, const glm::vec3& impulse) {
+    Body& first = bodies_[a];
+    first.velocity += first.inverse_mass * impulse;
+    first.angular_velocity += first.world_inverse_inertia * glm::cross(point - first.position, impulse);
+
+    if (b < 0) return;
+    Body& second = bodies_[b];
+    second.velocity -= second.inverse_mass * impulse;
+    second.angular_velocity -= second.world_inverse_inertia * glm::cross(point - second.position, impulse);
+}
+
+glm::vec3 PhysicsWorld::VelocityAt(int body, const glm::vec3& point) const {
+    if (body < 0) return glm::vec3(0);  // The maze doesn't move
+    const Body& moving = bodies_[body];
+    return moving.velocity + glm::cross(moving.angular_velocity, point - moving.position);
+}
+
+float PhysicsWorld::InverseMassAlong(int body, const glm::vec3& point, const glm::vec3& direction) const {
+    if (body < 0) return 0;  // Immovable
+    glm::vec3 lever = glm::cross(point - bodies_[body].position, direction);
+    return bodies_[body].inverse_mass + glm::dot(lever, bodies_[body].world_inverse_inertia * lever);
+}
+
+void PhysicsWorld::UpdateSleep(float dt, const FrameVector<Contact>& contacts) {
+    for (int i = 0; i < static_cast<int>(bodies_.size()); i++) {
+        Body& body = bodies_[i];
+        body.island = i;
+        if (body.state != BODY_AWAKE) continue;
+
+        bool still = glm::length(body.velocity) < PHYSICS_SLEEP_LINEAR_SPEED &&
+                     glm::length(body.angular_velocity) < PHYSICS_SLEEP_ANGULAR_SPEED;
+        body.still_time = still ? body.still_time + dt : 0.0f;
+    }
+
+    // Bodies touching each other form an island. The maze and the ground don't join islands, since they never move
+    for (const Contact& contact : contacts) {
+        if (contact.b < 0 || bodies_[contact.a].state != BODY_AWAKE || bodies_[contact.b].state != BODY_AWAKE) continue;
+        int first = FindIsland(contact.a), second = FindIsland(contact.b);
+        if (first != second) bodies_[std::max(first, second)].island = std::min(first, second);
+    }
+
+    // An island sleeps once every body in it has been still long enough, all at once, so none are left to be knocked by the rest
+    FrameVector<float> island_still_time(bodies_.size(), PHYSICS_SLEEP_DELAY);
+    for (int i = 0; i < static_cast<int>(bodies_.size()); i++) {
+        if (bodies_[i].state != BODY_AWAKE) continue;
+        int island = FindIsland(i);
+        island_still_time[island] = std::min(island_still_time[island], bodies_[i].still_time);
+    }
+    for (int i = 0; i < static_cast<int>(bodies_.size()); i++) {
+        Body& body = bodies_[i];
+        if (body.state != BODY_AWAKE || island_still_time[FindIsland(i)] < PHYSICS_SLEEP_DELAY) continue;
+
+        body.state = BODY_ASLEEP;
+        body.velocity = body.angular_velocity = glm::vec3(0);
+    }
+}
+
+int PhysicsWorld::FindIsland(int body) {
+    while (bodies_[body].island != body) {
+        bodies_[body].island = bodies_[bodies_[body].island].island;  // Path halving
+        body = bodies_[body].island;
+    }
+    return body;
+}
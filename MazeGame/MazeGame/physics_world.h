@@ -0,0 +1,90 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#include <gtc/quaternion.hpp>
+#include <utility>
+#include "arena.h"
+#include "frame_allocator.h"
+#include "glm.hpp"
+
+class GameObject;
+class Map;
+
+typedef enum {
+    BODY_AWAKE,
+    BODY_ASLEEP,  // Not moved or tested at all until something awake runs into it
+    BODY_HELD,    // Moved by something else, like a hand, and left out of the simulation
+} BodyState;
+
+/**
+ * Rigid bodies for loose items, like dropped keys. Each body is its object's oriented box. Bodies fall onto the ground, land on
+ * and slide along the maze's solids, and knock into each other. Pairs come from the map's broadphase, and contacts are resolved
+ * with sequential impulses over a fixed number of substeps and iterations, so a step's cost only grows with the bodies that are
+ * actually moving.
+ * Bodies that have been still for a while go to sleep, a whole island of touching bodies at a time so a stack doesn't doze off
+ * from the bottom up. Sleeping bodies cost nothing until something awake touches them.
+ */
+class PhysicsWorld {
+   public:
+    PhysicsWorld(Arena* arena, Map* map);
+
+    int AddBody(GameObject* object, float mass);  // Asleep, wherever the object is now. Returns its id, starting from 0
+    void Hold(int body);                          // Something else is moving it now
+    // Takes over from whatever was moving it, starting from where its object is now, awake and moving at these velocities
+    void Release(int body, const glm::vec3& velocity, const glm::vec3& angular_velocity);
+
+    void Step(float dt);  // Moves every awake body, then writes them back to their objects' transforms
+
+    BodyState State(int body) const;
+    int AwakeBodies() const;
+
+   private:
+    struct Body {
+        GameObject* object;
+        BodyState state;
+        glm::vec3 position;  // Of the center of its box
+        glm::quat orientation;
+        glm::vec3 velocity, angular_velocity;
+        glm::vec3 half_extents;  // With the object's scale applied
+        glm::vec3 local_center;  // Of the model-space box, which the object's transform is built around
+        glm::vec3 scale;
+        float inverse_mass;
+        glm::vec3 inverse_inertia;        // Diagonal, in the body's own frame
+        glm::mat3 world_inverse_inertia;  // Rotated into the world, as of the start of the substep
+        float still_time;                 // How long it's been slow enough to sleep
+        int island;                       // Union-find parent, only valid during Step()
+    };
+
+    struct Contact {
+        int a, b;          // b is -1 for the ground and the maze's solids
+        glm::vec3 normal;  // Pointing from b towards a
+        glm::vec3 point;
+        float depth;  // Negative while they're still apart, inside the contact margin
+        glm::vec3 tangents[2];
+        float normal_mass, tangent_masses[2];  // Inverses of the effective mass along each direction
+        float normal_impulse, tangent_impulses[2];
+        float bounce;  // Separating speed the restitution asks for
+    };
+
+    void ReadTransform(Body& body);
+    void UpdateInertia(Body& body);
+    void WriteTransform(const Body& body);
+    void Wake(int body);
+    int FindBody(const GameObject* object) const;
+
+    void FindContacts(FrameVector<Contact>& contacts);
+    void AddBoxContacts(int a, int b, const glm::vec3& center, const glm::mat3& axes, const glm::vec3& half_extents,
+                        FrameVector<Contact>& contacts);
+    void PrepareContact(Contact& contact) const;
+    void SolveContact(Contact& contact);
+    void ApplyImpulse(int a, int b, const glm::vec3& point, const glm::vec3& impulse);
+    glm::vec3 VelocityAt(int body, const glm::vec3& point) const;
+    float InverseMassAlong(int body, const glm::vec3& point, const glm::vec3& direction) const;
+
+    void UpdateSleep(float dt, const FrameVector<Contact>& contacts);
+    int FindIsland(int body);
+
+    Map* map_;
+    ArenaVector<Body> bodies_;
+    ArenaVector<std::pair<const GameObject*, int>> bodies_by_object_;  // Sorted, for turning broadphase results into bodies
+    float substep_;
+};
@@ -1,8 +1,8 @@
 #define GLM_FORCE_RADIANS
 #define NOMINMAX
 
-#include <SDL.h>
 #include <algorithm>
+#include <cmath>
 #include "constants.h"
 #include "map.h"
 #include "player.h"
@@ -21,15 +21,7 @@ Player::Player(VRCamera* camera, Map* map) : GameObject() {
     }
 
     float num = 0.15f;
-    box_ = std::vector<glm::vec3>(8);
-    box_[0] = glm::vec3(-num, -num, -PLAYER_HALF_HEIGHT);
-    box_[1] = glm::vec3(num, -num, -PLAYER_HALF_HEIGHT);
-    box_[2] = glm::vec3(num, num, -PLAYER_HALF_HEIGHT);
-    box_[3] = glm::vec3(-num, num, -PLAYER_HALF_HEIGHT);
-    box_[4] = glm::vec3(-num, -num, PLAYER_HALF_HEIGHT);
-    box_[5] = glm::vec3(num, -num, PLAYER_HALF_HEIGHT);
-    box_[6] = glm::vec3(num, num, PLAYER_HALF_HEIGHT);
-    box_[7] = glm::vec3(-num, num, PLAYER_HALF_HEIGHT);
+    model_bounds = BoundingBox(glm::vec3(-num, -num, -PLAYER_HALF_HEIGHT), glm::vec3(num, num, PLAYER_HALF_HEIGHT));
 
     glm::vec3 start_position = map_->SpawnPosition();
     camera->SetPosition(start_position);
@@ -37,63 +29,100 @@ Player::Player(VRCamera* camera, Map* map) : GameObject() {
     transform->SetInheritsRotation(false);
 
     camera->MakeChildOfHeadset(transform);
-    RegenerateBoundingBox();
+    UpdateWorldBounds();
 
     held_key_ = nullptr;
 }
 
-void Player::Update() {
-    float move_speed = CAMERA_MOVE_SPEED;
+void Player::Simulate(float dt) {
+    float move_speed = CAMERA_MOVE_SPEED * dt / REFERENCE_STEP;
 
     //// Player movement ////
-    const Uint8* key_state = SDL_GetKeyboardState(NULL);
+    forward_velocity += keyboard_forward_ * move_speed;
+    right_velocity += keyboard_right_ * move_speed;
 
-    if (key_state[SDL_SCANCODE_W]) {
-        forward_velocity += move_speed;  // movement forward
-    } else if (key_state[SDL_SCANCODE_S]) {
-        forward_velocity -= move_speed;
-    }
-    if (key_state[SDL_SCANCODE_D]) {
-        right_velocity += move_speed;
-    } else if (key_state[SDL_SCANCODE_A]) {
-        right_velocity -= move_speed;
-    }
+    forward_velocity += thumbstick_forward_ * VR_MOVE_SPEED_FACTOR * move_speed;
+    right_velocity += thumbstick_right_ * VR_MOVE_SPEED_FACTOR * move_speed;
+
+    // Clamp the velocities
+    float max_move_speed = MAX_MOVE_SPEED * dt / REFERENCE_STEP;
+    forward_velocity = std::max(std::min(forward_velocity, max_move_speed), -max_move_speed);
+    right_velocity = std::max(std::min(right_velocity, max_move_speed), -max_move_speed);
 
-    Move(forward_velocity, right_velocity, 1.0);
+    Move(forward_velocity, right_velocity);
 
     forward_velocity = 0;
     right_velocity = 0;
-    // printf("Player bounds: min: %f, %f, %f, max:: %f, %f, %f\n", bounding_box_->Min().x, bounding_box_->Min().y, bounding_box_->Min().z,
-    //       bounding_box_->Max().x, bounding_box_->Max().y, bounding_box_->Max().z);
+    // printf("Player bounds: min: %f, %f, %f, max:: %f, %f, %f\n", world_bounds.Min().x, world_bounds.Min().y, world_bounds.Min().z,
+    //       world_bounds.Max().x, world_bounds.Max().y, world_bounds.Max().z);
     // printf("Player z: %f\n", transform->Z());
 
     // Render the player's bounding box
-    // bounding_box_->Render();
+    // world_bounds.Render();
 }
 
-void Player::Move(float forward_velocity, float right_velocity, float speed_factor) {
-    forward_velocity *= speed_factor;
-    right_velocity *= speed_factor;
+void Player::SetThumbstickInput(float forward, float right) {
+    thumbstick_forward_ = forward;
+    thumbstick_right_ = right;
+}
 
-    // Clamp the velocities
-    forward_velocity = std::max(std::min(forward_velocity, MAX_MOVE_SPEED), -MAX_MOVE_SPEED);
-    right_velocity = std::max(std::min(right_velocity, MAX_MOVE_SPEED), -MAX_MOVE_SPEED);
+void Player::SetKeyboardInput(float forward, float right) {
+    keyboard_forward_ = forward;
+    keyboard_right_ = right;
+}
 
-    camera_->Translate(right_velocity, 0, forward_velocity);
+glm::vec3 Player::LookDirection() {
+    return camera_->GetNormalizedLookPosition();
+}
 
-    RegenerateBoundingBox();
+void Player::Move(float forward_velocity, float right_velocity) {
+    glm::vec3 displacement = camera_->HorizontalDisplacement(right_velocity, forward_velocity);
+    if (displacement == glm::vec3(0)) return;
 
-    if (map_->IntersectsAnySolidObjects(this)) {
-        camera_->Translate(-right_velocity, 0, -forward_velocity);  // Undo the movement
-        RegenerateBoundingBox();
+    // One query over everything the whole move could reach, so even a fast move can't skip past a thin wall
+    UpdateWorldBounds();
+    BoundingBox swept = world_bounds;
+    swept.ExpandToBound(world_bounds.Translated(displacement));
+    FrameVector<BoundingBox> solids;
+    map_->GatherSolidBounds(swept, this, solids);
 
-        stuck_in_object = true;
-    } else {
-        stuck_in_object = false;
-    }
+    glm::vec3 moved = SlideAgainst(world_bounds, displacement, solids);
+    camera_->Translate(moved);
+    UpdateWorldBounds();
+
+    stuck_in_object = moved != displacement;
 }
 
-void Player::RegenerateBoundingBox() {
-    InitBoundingBox(box_);
-    bounding_box_->transform->ClearParent();
+glm::vec3 Player::SlideAgainst(BoundingBox bounds, glm::vec3 displacement, const FrameVector<BoundingBox>& solids) {
+    glm::vec3 moved(0);
+    for (int i = 0; i < MAX_SLIDE_ITERATIONS; i++) {
+        float time_of_impact = 1.0f;
+        glm::vec3 normal(0);
+        for (const BoundingBox& solid : solids) {
+            float time;
+            glm::vec3 hit_normal;
+            if (bounds.SweepAgainst(displacement, solid, &time, &hit_normal) && time < time_of_impact) {
+                time_of_impact = time;
+                normal = hit_normal;
+            }
+        }
+
+        if (time_of_impact >= 1.0f) {  // Nothing in the way of the rest of it
+            moved += displacement;
+            break;
+        }
+
+        // Stop just short of the hit, then carry on with whatever of the move runs along the surface
+        float approach_speed = std::abs(glm::dot(displacement, normal));
+        float time = std::max(time_of_impact - PLAYER_COLLISION_SKIN / approach_speed, 0.0f);
+        glm::vec3 step = displacement * time;
+        moved += step;
+        bounds = bounds.Translated(step);
+
+        displacement *= 1.0f - time;
+        displacement -= normal * glm::dot(displacement, normal);
+        if (displacement == glm::vec3(0)) break;
+    }
+
+    return moved;
 }
@@ -1,24 +1,31 @@
 #pragma once
 #include <vector>
+#include "frame_allocator.h"
 #include "game_object.h"
 #include "key.h"
 #include "vr_camera.h"
 
-class Player : public GameObject {
+class Player final : public GameObject {
    public:
     Player(VRCamera* camera, Map* map);
 
-    void Update() override;
-    void Move(float forward_velocity, float right_velocity, float speed_factor);
+    void Simulate(float dt) override;
+    void SetThumbstickInput(float forward, float right);  // Held until it's set again, each axis in [-1, 1]
+    void SetKeyboardInput(float forward, float right);    // Likewise. Sampled on the main thread, which owns SDL's key state
+    glm::vec3 LookDirection();  // Horizontal, along where the headset's facing
 
    private:
-    void RegenerateBoundingBox();
+    void Move(float forward_velocity, float right_velocity);
+
+    // How far a box can actually go along displacement before it hits the solids, sliding along whatever it hits
+    static glm::vec3 SlideAgainst(BoundingBox bounds, glm::vec3 displacement, const FrameVector<BoundingBox>& solids);
 
     VRCamera* camera_;
-    std::vector<glm::vec3> box_;
     Key* held_key_;
 
     float vertical_velocity = 0.0f, forward_velocity = 0.0f, right_velocity = 0.0f;
+    float thumbstick_forward_ = 0.0f, thumbstick_right_ = 0.0f;
+    float keyboard_forward_ = 0.0f, keyboard_right_ = 0.0f;
     bool on_ground = true;
     bool stuck_in_object = false;
 };
@@ -1,5 +1,6 @@
 // Credit for the foundations of this code goes to Valve Corporation
 // https://github.com/ValveSoftware/openvr/blob/master/samples/hellovr_opengl/hellovr_opengl_main.cpp
+#include "gl_state.h"
 #include "render_model.h"
 #include "shader_manager.h"
 
@@ -17,11 +18,11 @@ RenderModel::~RenderModel() {
 bool RenderModel::Init(const vr::RenderModel_t& vrModel, const vr::RenderModel_TextureMap_t& vrDiffuseTexture) {
     // create and bind a VAO to hold state for this model
     glGenVertexArrays(1, &gl_vert_array_);
-    glBindVertexArray(gl_vert_array_);
+    GLState::BindVertexArray(gl_vert_array_);
 
     // Populate a vertex buffer
     glGenBuffers(1, &gl_vert_buffer_);
-    glBindBuffer(GL_ARRAY_BUFFER, gl_vert_buffer_);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, gl_vert_buffer_);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vr::RenderModel_Vertex_t) * vrModel.unVertexCount, vrModel.rVertexData, GL_STATIC_DRAW);
 
     // Identify the components in the vertex buffer
@@ -35,14 +36,14 @@ bool RenderModel::Init(const vr::RenderModel_t& vrModel, const vr::RenderModel_T
 
     // Create and populate the index buffer
     glGenBuffers(1, &gl_index_buffer_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl_index_buffer_);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl_index_buffer_);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * vrModel.unTriangleCount * 3, vrModel.rIndexData, GL_STATIC_DRAW);
 
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
 
     // create and populate the texture
     glGenTextures(1, &gl_texture_);
-    glBindTexture(GL_TEXTURE_2D, gl_texture_);
+    GLState::BindTexture(0, GL_TEXTURE_2D, gl_texture_);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, vrDiffuseTexture.unWidth, vrDiffuseTexture.unHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
                  vrDiffuseTexture.rubTextureMapData);
@@ -59,7 +60,7 @@ bool RenderModel::Init(const vr::RenderModel_t& vrModel, const vr::RenderModel_T
     glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &fLargest);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, fLargest);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::BindTexture(0, GL_TEXTURE_2D, 0);
 
     vertex_count_ = vrModel.unTriangleCount * 3;
 
@@ -68,9 +69,9 @@ bool RenderModel::Init(const vr::RenderModel_t& vrModel, const vr::RenderModel_T
 
 void RenderModel::Cleanup() {
     if (gl_vert_buffer_) {
-        glDeleteBuffers(1, &gl_index_buffer_);
-        glDeleteVertexArrays(1, &gl_vert_array_);
-        glDeleteBuffers(1, &gl_vert_buffer_);
+        GLState::DeleteBuffer(gl_index_buffer_);
+        GLState::DeleteVertexArray(gl_vert_array_);
+        GLState::DeleteBuffer(gl_vert_buffer_);
         gl_index_buffer_ = 0;
         gl_vert_array_ = 0;
         gl_vert_buffer_ = 0;
@@ -78,14 +79,9 @@ void RenderModel::Cleanup() {
 }
 
 void RenderModel::Draw() {
-    glUseProgram(ShaderManager::RenderModel_Shader);
-    glBindVertexArray(gl_vert_array_);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gl_texture_);
+    GLState::UseProgram(ShaderManager::RenderModel_Shader);
+    GLState::BindVertexArray(gl_vert_array_);
+    GLState::BindTexture(0, GL_TEXTURE_2D, gl_texture_);
 
     glDrawElements(GL_TRIANGLES, vertex_count_, GL_UNSIGNED_SHORT, 0);
-
-    glBindVertexArray(0);
-    glUseProgram(0);
 }
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include "constants.h"
+#include "render_queue.h"
+
+namespace {
+// Key layout, from the least significant bit up. Each field is clamped to its width
+const int DEPTH_BITS = 20;
+const int MESH_BITS = 24;
+const int TEXTURE_BITS = 8;
+const int PROGRAM_BITS = 8;
+const int PASS_BITS = 4;
+
+const int MESH_SHIFT = DEPTH_BITS;
+const int TEXTURE_SHIFT = MESH_SHIFT + MESH_BITS;
+const int PROGRAM_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+const int PASS_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+
+const uint64_t STATE_MASK = ((uint64_t(1) << (PROGRAM_BITS + TEXTURE_BITS)) - 1) << TEXTURE_SHIFT;  // What changing costs a GL call
+
+uint64_t Field(uint64_t value, int bits, int shift) {
+    uint64_t max = (uint64_t(1) << bits) - 1;
+    return std::min(value, max) << shift;
+}
+}  // namespace
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, uint32_t program, int texture, uint32_t first_vertex, float depth) {
+    uint64_t depth_bucket = depth > 0 ? static_cast<uint64_t>(depth / RENDER_DEPTH_BUCKET) : 0;  // Behind the eye still sorts first
+    return Field(pass, PASS_BITS, PASS_SHIFT) | Field(program, PROGRAM_BITS, PROGRAM_SHIFT) |
+           Field(static_cast<uint64_t>(texture + 1), TEXTURE_BITS, TEXTURE_SHIFT) | Field(first_vertex, MESH_BITS, MESH_SHIFT) |
+           Field(depth_bucket, DEPTH_BITS, 0);
+}
+
+void RenderQueue::Clear() {
+    entries_.clear();
+}
+
+void RenderQueue::Push(uint64_t key, uint32_t payload) {
+    entries_.push_back(Entry{key, payload});
+}
+
+void RenderQueue::Sort() {
+    stats_.draws = static_cast<int>(entries_.size());
+    stats_.unsorted_state_changes = StateChanges(entries_);
+
+    // Every byte's histogram in one pass over the keys, so bytes that are the same in every key can be skipped without looking again
+    size_t counts[8][256] = {};
+    for (const Entry& entry : entries_) {
+        for (int byte = 0; byte < 8; byte++) {
+            counts[byte][(entry.key >> (8 * byte)) & 0xFF]++;
+        }
+    }
+
+    scratch_.resize(entries_.size());
+    for (int byte = 0; byte < 8; byte++) {
+        if (entries_.empty() || counts[byte][(entries_[0].key >> (8 * byte)) & 0xFF] == entries_.size()) continue;
+
+        size_t offsets[256];
+        size_t offset = 0;
+        for (int value = 0; value < 256; value++) {
+            offsets[value] = offset;
+            offset += counts[byte][value];
+        }
+
+        for (const Entry& entry : entries_) {  // Stable, so the order from the less significant bytes is kept
+            scratch_[offsets[(entry.key >> (8 * byte)) & 0xFF]++] = entry;
+        }
+        entries_.swap(scratch_);
+    }
+
+    stats_.sorted_state_changes = StateChanges(entries_);
+}
+
+const std::vector<RenderQueue::Entry>& RenderQueue::Entries() const {
+    return entries_;
+}
+
+const RenderQueue::Stats& RenderQueue::LastStats() const {
+    return stats_;
+}
+
+int RenderQueue::StateChanges(const std::vector<Entry>& entries) {
+    int changes = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (i == 0 || (entries[i].key & STATE_MASK) != (entries[i - 1].key & STATE_MASK)) changes++;
+    }
+    return changes;
+}
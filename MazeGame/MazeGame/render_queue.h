@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+typedef enum {
+    RENDER_PASS_OPAQUE = 0,
+    RENDER_PASS_TRANSPARENT = 1,  // After everything opaque. Nothing uses it yet
+} RenderPass;
+
+/**
+ * Orders a frame's draws so the ones sharing state go together. Each draw is a 64-bit key, which packs (from the most
+ * significant bits down) the pass, program, texture, mesh range and a depth bucket, plus a payload saying what to draw, usually
+ * an index into the caller's packets. Sorting the keys groups draws by the most expensive state first, and front to back within
+ * a mesh so early depth testing throws away as much as it can.
+ * The sort is an LSD radix sort over the key's bytes, skipping any byte every key has the same value in, so it's linear in the
+ * number of draws and reuses its buffers from frame to frame.
+ */
+class RenderQueue {
+   public:
+    struct Entry {
+        uint64_t key;
+        uint32_t payload;
+    };
+
+    // How many times the program or texture would change drawing the queue in the order it was built, and in sorted order
+    struct Stats {
+        int draws;
+        int unsorted_state_changes;
+        int sorted_state_changes;
+    };
+
+    // Fields that don't fit are clamped. Texture ids start from -1, for untextured. depth is how far in front of the eye it is
+    static uint64_t MakeKey(RenderPass pass, uint32_t program, int texture, uint32_t first_vertex, float depth);
+
+    void Clear();
+    void Push(uint64_t key, uint32_t payload);
+    void Sort();  // Also fills in LastStats()
+
+    const std::vector<Entry>& Entries() const;
+    const Stats& LastStats() const;
+
+   private:
+    static int StateChanges(const std::vector<Entry>& entries);
+
+    std::vector<Entry> entries_;
+    std::vector<Entry> scratch_;  // Where each radix pass scatters to, before swapping with entries_
+    Stats stats_ = {0, 0, 0};
+};
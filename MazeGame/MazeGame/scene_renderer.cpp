@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <gtc/type_ptr.hpp>
+#include <tuple>
+#include "constants.h"
+#include "gl_state.h"
+#include "job_system.h"
+#include "model_manager.h"
+#include "scene_renderer.h"
+#include "shader_manager.h"
+
+namespace {
+// Each plane is a sum or difference of the matrix's last row and one of the others. The near plane is OpenGL's, which is never
+// tighter than the [0, 1] depth range OpenVR's projections may use, so nothing that should be drawn is culled
+void FrustumPlanes(const glm::mat4& world_to_clip, glm::vec4 planes[6]) {
+    glm::vec4 rows[4];
+    for (int row = 0; row < 4; row++) {
+        rows[row] = glm::vec4(world_to_clip[0][row], world_to_clip[1][row], world_to_clip[2][row], world_to_clip[3][row]);
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        planes[2 * axis] = rows[3] + rows[axis];
+        planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+    for (int plane = 0; plane < 6; plane++) {
+        planes[plane] /= glm::length(glm::vec3(planes[plane]));  // So plugging a point in gives its distance from the plane
+    }
+}
+
+bool InFrustum(const glm::vec4 planes[6], const BoundingSphere& sphere) {
+    for (int plane = 0; plane < 6; plane++) {
+        if (glm::dot(glm::vec3(planes[plane]), sphere.center) + planes[plane].w < -sphere.radius) return false;
+    }
+    return true;
+}
+}  // namespace
+
+void SceneRenderer::Cull(const std::vector<RenderPacket>& packets, const glm::mat4& world_to_clip, std::vector<uint8_t>& visible) {
+    glm::vec4 planes[6];
+    FrustumPlanes(world_to_clip, planes);
+
+    visible.resize(packets.size());
+    JobSystem::ParallelFor("Frustum culling", static_cast<int>(packets.size()), JOB_PACKETS_PER_CHUNK, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            visible[i] = InFrustum(planes, packets[i].bounds.Transformed(packets[i].model_matrix));
+        }
+    });
+}
+
+void SceneRenderer::Draw(const std::vector<RenderPacket>& packets, const std::vector<uint8_t>& visible, const glm::mat4& world_to_clip) {
+    queue_.Clear();
+    for (size_t i = 0; i < packets.size(); i++) {
+        if (!visible[i]) continue;
+
+        const RenderPacket& packet = packets[i];
+        glm::vec3 center = glm::vec3(packet.model_matrix * glm::vec4(packet.bounds.center, 1));
+        float depth = (world_to_clip * glm::vec4(center, 1)).w;  // Clip space w is the distance in front of the eye
+        queue_.Push(RenderQueue::MakeKey(RENDER_PASS_OPAQUE, ShaderManager::Textured_Shader, packet.texture, packet.first_vertex, depth),
+                    static_cast<uint32_t>(i));
+    }
+    queue_.Sort();
+
+    GLState::UseProgram(ShaderManager::Textured_Shader);
+
+    bool first = true;
+    TEXTURE texture = UNTEXTURED;
+    glm::vec3 color;
+    for (const RenderQueue::Entry& entry : queue_.Entries()) {
+        const RenderPacket& packet = packets[entry.payload];
+        glUniformMatrix4fv(ShaderManager::Attributes.model, 1, GL_FALSE, glm::value_ptr(packet.model_matrix));  // pass model matrix to shader
+        if (first || packet.texture != texture) {
+            glUniform1i(ShaderManager::Attributes.texID, packet.texture);  // Set which texture to use
+        }
+        if (packet.texture == UNTEXTURED && (first || texture != UNTEXTURED || packet.color != color)) {
+            glUniform3fv(ShaderManager::Attributes.color, 1, glm::value_ptr(packet.color));  // Update the color, if necessary
+            color = packet.color;
+        }
+        texture = packet.texture;
+        first = false;
+
+        glDrawArrays(GL_TRIANGLES, packet.first_vertex, packet.vertex_count);
+    }
+}
+
+const RenderQueue::Stats& SceneRenderer::QueueStats() {
+    return queue_.LastStats();
+}
+
+void SceneRenderer::SetStaticPackets(const std::vector<RenderPacket>& packets) {
+    Cleanup();
+    if (packets.empty()) return;
+
+    struct Instance {
+        const RenderPacket* packet;
+        BoundingSphere bounds;                       // In world space
+        std::tuple<GLint, GLsizei, int, int> batch;  // The mesh and the tile it's in
+    };
+    std::vector<Instance> sorted(packets.size());
+    for (size_t i = 0; i < packets.size(); i++) {
+        BoundingSphere bounds = packets[i].bounds.Transformed(packets[i].model_matrix);
+        int tile_x = static_cast<int>(std::floor(bounds.center.x / INSTANCE_TILE_CELLS));
+        int tile_y = static_cast<int>(std::floor(bounds.center.y / INSTANCE_TILE_CELLS));
+        sorted[i] = Instance{&packets[i], bounds, std::make_tuple(packets[i].first_vertex, packets[i].vertex_count, tile_x, tile_y)};
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Instance& a, const Instance& b) { return a.batch < b.batch; });
+
+    // Every instance of a batch is next to the rest in the buffer, so a batch is just a range of it
+    std::vector<InstanceData> instances;
+    instances.reserve(sorted.size());
+    for (size_t first = 0, last; first < sorted.size(); first = last) {
+        glm::vec3 bounds_min = sorted[first].bounds.center - glm::vec3(sorted[first].bounds.radius);
+        glm::vec3 bounds_max = sorted[first].bounds.center + glm::vec3(sorted[first].bounds.radius);
+        for (last = first; last < sorted.size() && sorted[last].batch == sorted[first].batch; last++) {
+            const RenderPacket& packet = *sorted[last].packet;
+            instances.push_back(InstanceData{packet.model_matrix, packet.color, packet.texture});
+            bounds_min = glm::min(bounds_min, sorted[last].bounds.center - glm::vec3(sorted[last].bounds.radius));
+            bounds_max = glm::max(bounds_max, sorted[last].bounds.center + glm::vec3(sorted[last].bounds.radius));
+        }
+
+        const RenderPacket& packet = *sorted[first].packet;
+        BoundingSphere bounds{(bounds_min + bounds_max) * 0.5f, glm::length(bounds_max - bounds_min) * 0.5f};
+        batches_.push_back(
+            Batch{packet.first_vertex, packet.vertex_count, static_cast<GLint>(first), static_cast<GLsizei>(last - first), bounds});
+    }
+
+    glGenVertexArrays(1, &instance_vao_);
+    GLState::BindVertexArray(instance_vao_);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, ModelManager::VBO());
+    ShaderManager::InitShaderAttributes();  // The same per-vertex layout as the scene's VAO
+
+    glGenBuffers(1, &instance_vbo_);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData), instances.data(), GL_STATIC_DRAW);
+    for (int column = 0; column < 4; column++) {
+        glEnableVertexAttribArray(ShaderManager::Attributes.instanceModel + column);
+        glVertexAttribDivisor(ShaderManager::Attributes.instanceModel + column, 1);
+    }
+    glEnableVertexAttribArray(ShaderManager::Attributes.instanceColor);
+    glVertexAttribDivisor(ShaderManager::Attributes.instanceColor, 1);
+    glEnableVertexAttribArray(ShaderManager::Attributes.instanceTexID);
+    glVertexAttribDivisor(ShaderManager::Attributes.instanceTexID, 1);
+    GLState::BindVertexArray(0);
+
+    printf("Instancing %zu static objects in %zu batches\n", instances.size(), batches_.size());
+}
+
+void SceneRenderer::DrawStatic(const glm::mat4& world_to_clip) {
+    if (batches_.empty()) return;
+
+    glm::vec4 planes[6];
+    FrustumPlanes(world_to_clip, planes);
+
+    GLState::UseProgram(ShaderManager::Textured_Shader);
+    glUniform1i(ShaderManager::Attributes.instanced, GL_TRUE);
+    GLState::BindVertexArray(instance_vao_);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+
+    const GLsizei stride = sizeof(InstanceData);
+    for (const Batch& batch : batches_) {
+        if (!InFrustum(planes, batch.bounds)) continue;
+
+        // There's no base instance before OpenGL 4.2, so the instance attributes are pointed at the batch's part of the buffer
+        const char* base = reinterpret_cast<const char*>(static_cast<size_t>(batch.first_instance) * sizeof(InstanceData));
+        for (int column = 0; column < 4; column++) {
+            glVertexAttribPointer(ShaderManager::Attributes.instanceModel + column, 4, GL_FLOAT, GL_FALSE, stride,
+                                  base + offsetof(InstanceData, model_matrix) + column * sizeof(glm::vec4));
+        }
+        glVertexAttribPointer(ShaderManager::Attributes.instanceColor, 3, GL_FLOAT, GL_FALSE, stride, base + offsetof(InstanceData, color));
+        glVertexAttribIPointer(ShaderManager::Attributes.instanceTexID, 1, GL_INT, stride, base + offsetof(InstanceData, texture));
+
+        glDrawArraysInstanced(GL_TRIANGLES, batch.first_vertex, batch.vertex_count, batch.instance_count);
+    }
+
+    glUniform1i(ShaderManager::Attributes.instanced, GL_FALSE);
+}
+
+void SceneRenderer::Cleanup() {
+    if (instance_vao_ != 0) GLState::DeleteVertexArray(instance_vao_);
+    if (instance_vbo_ != 0) GLState::DeleteBuffer(instance_vbo_);
+    instance_vao_ = instance_vbo_ = 0;
+    batches_.clear();
+}
+
+std::vector<SceneRenderer::Batch> SceneRenderer::batches_;
+GLuint SceneRenderer::instance_vao_;
+GLuint SceneRenderer::instance_vbo_;
+RenderQueue SceneRenderer::queue_;
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "bounding_sphere.h"
+#include "glad.h"
+#include "glm.hpp"
+#include "render_queue.h"
+#include "texture_manager.h"
+
+// Everything needed to draw one object, copied out of the simulation once per frame
+struct RenderPacket {
+    glm::mat4 model_matrix;
+    glm::vec3 color;  // Only used when untextured
+    TEXTURE texture;
+    GLint first_vertex;  // Range of the shared VBO holding the mesh
+    GLsizei vertex_count;
+    BoundingSphere bounds;  // Around the mesh, in model space
+};
+
+/**
+ * Draws render packets with the textured shader. This is the whole per-eye cost of the scene, so it only reads packets and
+ * never touches game state. Packets are culled against each eye's frustum first, on the job system, so the GL thread only
+ * spends its time on ones that can be seen. What's left goes through a RenderQueue, so draws sharing a texture are made together,
+ * front to back, and uniforms are only set when they change.
+ * Static objects, which are most of the maze, are drawn instanced instead. They're grouped into batches by mesh and tile of the
+ * map, and each batch that's in view is a single draw call reading its model matrices, colors, and textures from an instance
+ * buffer that's only uploaded when the static objects change, so instances in one batch can use different textures.
+ */
+class SceneRenderer {
+   public:
+    // Sets visible[i] to whether packets[i]'s bounds are at least partly inside the frustum of world_to_clip
+    static void Cull(const std::vector<RenderPacket>& packets, const glm::mat4& world_to_clip, std::vector<uint8_t>& visible);
+    // Draws the visible packets, sorted by the state they need and then by depth from world_to_clip's eye
+    static void Draw(const std::vector<RenderPacket>& packets, const std::vector<uint8_t>& visible, const glm::mat4& world_to_clip);
+    static const RenderQueue::Stats& QueueStats();  // From the last Draw()
+
+    // Replaces the static batches with these packets. Needs the level's models in ModelManager's VBO
+    static void SetStaticPackets(const std::vector<RenderPacket>& packets);
+    static void DrawStatic(const glm::mat4& world_to_clip);  // Leaves its own VAO bound
+    static void Cleanup();                                   // Deletes the static batches' buffers
+
+   private:
+    // Per instance, as the textured shader's instance attributes read it
+    struct InstanceData {
+        glm::mat4 model_matrix;
+        glm::vec3 color;
+        GLint texture;
+    };
+
+    struct Batch {
+        GLint first_vertex;
+        GLsizei vertex_count;
+        GLint first_instance;
+        GLsizei instance_count;
+        BoundingSphere bounds;  // Around every instance, in world space
+    };
+
+    static std::vector<Batch> batches_;
+    static GLuint instance_vao_;
+    static GLuint instance_vbo_;
+    static RenderQueue queue_;  // Kept so its buffers are reused every frame
+};
@@ -1,6 +1,7 @@
 #include <fstream>
 #include <sstream>
 #include "constants.h"
+#include "gl_state.h"
 #include "shader_manager.h"
 
 int ShaderManager::InitShaders() {
@@ -8,13 +9,11 @@ int ShaderManager::InitShaders() {
     CompanionWindow_Shader = CompileShaderProgram("companionWindow-Vertex.glsl", "companionWindow-Fragment.glsl");
     RenderModel_Shader = CompileShaderProgram("renderModel-Vertex.glsl", "renderModel-Fragment.glsl");
 
-    InitShaderAttributes();
-
     return Textured_Shader;
 }
 
 void ShaderManager::Cleanup() {
-    glDeleteProgram(Textured_Shader);
+    GLState::DeleteProgram(Textured_Shader);
 }
 
 // Tell OpenGL how to set fragment shader input
@@ -40,10 +39,7 @@ void ShaderManager::InitShaderAttributes() {
     GLint uniProj = glGetUniformLocation(Textured_Shader, "proj");
     GLint uniModel = glGetUniformLocation(Textured_Shader, "model");
     GLint uniShaderMode = glGetUniformLocation(Textured_Shader, "shaderMode");
-
-    glUseProgram(Textured_Shader);
-    glUniform1i(uniShaderMode, 0);
-    glUseProgram(0);
+    GLint uniInstanced = glGetUniformLocation(Textured_Shader, "instanced");
 
     Attributes.position = posAttrib;
     Attributes.normals = normAttrib;
@@ -54,6 +50,10 @@ void ShaderManager::InitShaderAttributes() {
     Attributes.projection = uniProj;
     Attributes.model = uniModel;
     Attributes.shaderMode = uniShaderMode;
+    Attributes.instanced = uniInstanced;
+    Attributes.instanceModel = glGetAttribLocation(Textured_Shader, "instanceModel");  // The first of its four columns
+    Attributes.instanceColor = glGetAttribLocation(Textured_Shader, "instanceColor");
+    Attributes.instanceTexID = glGetAttribLocation(Textured_Shader, "instanceTexID");
 }
 
 GLuint ShaderManager::CompileShaderProgram(const std::string& vertex_shader_file, const std::string& fragment_shader_file) {
@@ -12,11 +12,16 @@ typedef struct {
     GLint color;
     GLint texID;
     GLint shaderMode;
+    GLint instanced;  // Whether to read the model matrix, color and texture from the instance attributes below
+    GLint instanceModel;
+    GLint instanceColor;
+    GLint instanceTexID;
 } ShaderAttributes;
 
 class ShaderManager {
    public:
     static int InitShaders();
+    static void InitShaderAttributes();  // Points the bound VAO at the bound VBO, so it has to be redone whenever the VBO is rebuilt
     static void Cleanup();
 
     static GLuint Textured_Shader;
@@ -25,7 +30,6 @@ class ShaderManager {
     static ShaderAttributes Attributes;
 
    private:
-    static void InitShaderAttributes();
     static GLuint CompileShaderProgram(const std::string& vertex_shader_file, const std::string& fragment_shader_file);
     static char* ReadShaderSource(const char* shaderFile);
     static void VerifyShaderCompiled(GLuint shader);
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cmath>
+#include "constants.h"
+#include "game_object.h"
+#include "map.h"
+#include "simulation_scheduler.h"
+
+SimulationScheduler::SimulationScheduler(Arena* arena, Map* map)
+    : map_(map),
+      entries_(ArenaAllocator<Entry>(arena)),
+      added_(ArenaAllocator<Entry>(arena)),
+      stepping_(false),
+      step_(0),
+      cursor_(0),
+      ticks_last_step_(0) {}
+
+void SimulationScheduler::Add(GameObject* object) {
+    // Each one waits a different number of steps for its first tick, so objects added together don't stay in step with each other
+    uint64_t phase = entries_.size() % LOD_MAX_INTERVAL;
+    Insert(Entry{object, step_, step_ + 1 + phase, 0, 1, nullptr, false});
+}
+
+void SimulationScheduler::Add(GameObject* object, std::function<bool(float)> step) {
+    Insert(Entry{object, step_, step_ + 1, 0, 1, std::move(step), false});
+}
+
+void SimulationScheduler::Wake(GameObject* object) {
+    auto wake = [&](Entry& entry) {
+        if (entry.object != object) return;
+
+        entry.awake_until_step = step_ + 1 + static_cast<uint64_t>(LOD_WAKE_DURATION / SIMULATION_STEP);
+        entry.next_tick_step = std::min(entry.next_tick_step, step_ + 1);
+        entry.interval = 1;
+    };
+
+    for (Entry& entry : entries_) wake(entry);
+    for (Entry& entry : added_) wake(entry);
+}
+
+void SimulationScheduler::Step(float dt, const glm::vec3& viewer_position, const glm::vec3& viewer_forward) {
+    step_++;
+    ticks_last_step_ = 0;
+    stepping_ = true;
+
+    int budget = LOD_TICK_BUDGET;
+    size_t count = entries_.size();
+    size_t first_deferred = count;
+    for (size_t n = 0; n < count; n++) {
+        size_t i = (cursor_ + n) % count;
+        Entry& entry = entries_[i];
+        if (entry.finished || entry.next_tick_step > step_) continue;
+
+        // Full rate ticks always happen. Only the ones that can stand to wait count against the budget
+        if (entry.interval > 1) {
+            if (budget == 0) {
+                if (first_deferred == count) first_deferred = i;
+                continue;
+            }
+            budget--;
+        }
+
+        Tick(entry, dt, viewer_position, viewer_forward);
+    }
+    stepping_ = false;
+
+    if (first_deferred != count) cursor_ = first_deferred;
+
+    // Finished animations are dropped, keeping the order of the rest so the budget stays fair
+    auto end = std::remove_if(entries_.begin(), entries_.end(), [](const Entry& entry) { return entry.finished; });
+    if (end != entries_.end()) {
+        entries_.erase(end, entries_.end());
+        cursor_ = 0;
+    }
+    for (Entry& entry : added_) entries_.push_back(std::move(entry));
+    added_.clear();
+}
+
+int SimulationScheduler::TicksLastStep() const {
+    return ticks_last_step_;
+}
+
+void SimulationScheduler::Insert(Entry entry) {
+    if (stepping_) {
+        added_.push_back(std::move(entry));
+    } else {
+        entries_.push_back(std::move(entry));
+    }
+}
+
+void SimulationScheduler::Tick(Entry& entry, float dt, const glm::vec3& viewer_position, const glm::vec3& viewer_forward) {
+    float elapsed = dt * static_cast<float>(step_ - entry.last_tick_step);  // Covers every step since it last ran
+    if (entry.step) {
+        entry.finished = !entry.step(elapsed);
+    } else {
+        entry.object->Simulate(elapsed);
+    }
+
+    entry.last_tick_step = step_;
+    entry.interval = ChooseInterval(entry, viewer_position, viewer_forward);
+    entry.next_tick_step = step_ + entry.interval;
+    ticks_last_step_++;
+}
+
+int SimulationScheduler::ChooseInterval(const Entry& entry, const glm::vec3& viewer_position, const glm::vec3& viewer_forward) {
+    if (step_ < entry.awake_until_step) return 1;
+
+    float distance = glm::length(entry.object->world_bounds.Center() - viewer_position);
+    int interval = distance < LOD_NEAR_DISTANCE ? 1 : (distance < LOD_FAR_DISTANCE ? 2 : 4);
+    if (!InView(entry.object, viewer_position, viewer_forward)) interval *= 2;
+
+    return std::min(interval, LOD_MAX_INTERVAL);
+}
+
+bool SimulationScheduler::InView(GameObject* object, const glm::vec3& viewer_position, const glm::vec3& viewer_forward) {
+    glm::vec3 to_object = object->world_bounds.Center() - viewer_position;
+    float distance = glm::length(to_object);
+    if (distance < ABSOLUTE_TOLERANCE) return true;
+    if (glm::dot(to_object / distance, viewer_forward) < LOD_VIEW_COSINE) return false;
+
+    // Hidden if a wall or anything else solid is in the way. Solid objects block the line to themselves, which still counts
+    RayHit hit;
+    return !map_->SegmentCast(viewer_position, object->world_bounds.Center(), BROADPHASE_SOLID, &hit) || hit.object == object;
+}
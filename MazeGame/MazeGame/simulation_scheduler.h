@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "arena.h"
+#include "glm.hpp"
+
+class GameObject;
+class Map;
+
+/**
+ * Level of detail for game logic. Each object it's given ticks every step while it's near the player, in view, or was just
+ * interacted with, and every 2nd, 4th, or 8th step the further away and more hidden it is, with dt covering every step it skipped.
+ * Objects start out of phase with each other and there's a budget on reduced-rate ticks per step, so they're spread across
+ * steps rather than landing together, and a step costs about the same however many objects the maze has.
+ */
+class SimulationScheduler {
+   public:
+    SimulationScheduler(Arena* arena, Map* map);  // The map is used for line of sight
+
+    void Add(GameObject* object);  // Runs its Simulate() for as long as the level lasts
+    // Runs step(dt) on object's schedule instead, starting next step, until it returns false. For animations, which only need
+    // ticking while they play
+    void Add(GameObject* object, std::function<bool(float)> step);
+    void Wake(GameObject* object);  // Runs it every step for a while, starting with this one
+
+    // Runs the game logic of every object that's due, given where the viewer is and which way they're facing
+    void Step(float dt, const glm::vec3& viewer_position, const glm::vec3& viewer_forward);
+
+    int TicksLastStep() const;
+
+   private:
+    struct Entry {
+        GameObject* object;
+        uint64_t last_tick_step;
+        uint64_t next_tick_step;
+        uint64_t awake_until_step;        // Runs at full rate until this step
+        int interval;                     // In steps, chosen each time it ticks
+        std::function<bool(float)> step;  // Empty for objects that just Simulate()
+        bool finished;
+    };
+
+    void Insert(Entry entry);
+    void Tick(Entry& entry, float dt, const glm::vec3& viewer_position, const glm::vec3& viewer_forward);
+
+    int ChooseInterval(const Entry& entry, const glm::vec3& viewer_position, const glm::vec3& viewer_forward);
+    bool InView(GameObject* object, const glm::vec3& viewer_position, const glm::vec3& viewer_forward);
+
+    Map* map_;
+    ArenaVector<Entry> entries_;
+    ArenaVector<Entry> added_;  // Entries added in the middle of a Step(), which join the rest once it's done
+    bool stepping_;
+    uint64_t step_;
+    size_t cursor_;  // Where the next step starts looking, so entries left over by the budget go first
+    int ticks_last_step_;
+};
@@ -0,0 +1,169 @@
+#include <chrono>
+#include "constants.h"
+#include "frame_allocator.h"
+#include "player.h"
+#include "simulation_thread.h"
+
+void RenderSnapshot::Interpolate(float interpolation, std::vector<RenderPacket>& out) const {
+    out = packets;  // Reuses out's storage once it's big enough
+
+    for (size_t i = 0; i < out.size(); i++) {
+        const glm::mat4& previous = previous_model_matrices[i];
+        const glm::mat4& current = packets[i].model_matrix;
+        if (previous == current) continue;
+
+        for (int column = 0; column < 4; column++) {  // A plain blend is close enough over a single step
+            out[i].model_matrix[column] = glm::mix(previous[column], current[column], interpolation);
+        }
+    }
+}
+
+SimulationThread::SimulationThread()
+    : map_(nullptr), camera_(nullptr), input_manager_(nullptr), running_(false), last_counter_(0), accumulator_(0), checksum_(0) {}
+
+SimulationThread::~SimulationThread() {
+    Stop();
+}
+
+void SimulationThread::Start(Map* map, VRCamera* camera, VRInputManager* input_manager) {
+    Stop();
+
+    map_ = map;
+    camera_ = camera;
+    input_manager_ = input_manager;
+    last_counter_ = SDL_GetPerformanceCounter();  // Time spent stopped (like loading a level) shouldn't count as simulation time
+    accumulator_ = 0;
+    checksum_ = 0;
+    PublishSnapshot(last_counter_);
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop() {
+    if (!thread_.joinable()) return;
+
+    running_.store(false, std::memory_order_release);
+    thread_.join();
+    recorder_.Close();
+}
+
+bool SimulationThread::Record(const std::string& path, const std::string& map_file) {
+    return recorder_.Open(path, map_file);
+}
+
+bool SimulationThread::Replay(Map* map, VRCamera* camera, VRInputManager* input_manager, InputPlayback* playback) {
+    Stop();
+
+    map_ = map;
+    camera_ = camera;
+    input_manager_ = input_manager;
+    checksum_ = 0;
+
+    auto start_time = std::chrono::steady_clock::now();
+    int64_t tick = 0, step = 0;
+    int steps;
+    uint64_t recorded_checksum;
+    bool complete = false;
+    while (playback->Read(&tick_input_, &steps, &recorded_checksum)) {
+        RunTick(tick_input_, steps);
+        FrameAllocator::Reset();
+
+        if (checksum_ != recorded_checksum) {  // Before anything else, so a diverging run that ends the level is still caught
+            printf("Diverged at tick %lld (steps %lld to %lld): recorded checksum %016llx, replayed %016llx\n",
+                   static_cast<long long>(tick), static_cast<long long>(step), static_cast<long long>(step + steps),
+                   static_cast<unsigned long long>(recorded_checksum), static_cast<unsigned long long>(checksum_));
+            return false;
+        }
+        if (map_->IsComplete() && !complete) {
+            printf("Reached the goal at tick %lld\n", static_cast<long long>(tick));
+            complete = true;
+        }
+        tick++;
+        step += steps;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+    printf("Replayed %lld ticks (%lld steps) in %lld ms. Every checksum matched\n", static_cast<long long>(tick),
+           static_cast<long long>(step), static_cast<long long>(elapsed.count()));
+    if (!complete) printf("The goal was never reached\n");
+    return true;
+}
+
+FrameInput& SimulationThread::NextInput() {
+    return input_.WriteBuffer();
+}
+
+void SimulationThread::PublishInput() {
+    input_.Publish();
+}
+
+const RenderSnapshot& SimulationThread::LatestSnapshot() {
+    snapshots_.Consume();  // If nothing new has been published, the last snapshot is still the latest
+    return snapshots_.ReadBuffer();
+}
+
+void SimulationThread::Run() {
+    while (running_.load(std::memory_order_acquire)) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        float frame_time = static_cast<float>(now - last_counter_) / SDL_GetPerformanceFrequency();
+        if (frame_time > MAX_FRAME_TIME) frame_time = MAX_FRAME_TIME;
+        last_counter_ = now;
+
+        accumulator_ += frame_time;
+        if (accumulator_ < SIMULATION_STEP) {  // Sleep rather than spin, so the render thread and compositor keep the cores
+            std::this_thread::sleep_for(std::chrono::duration<float>(SIMULATION_STEP - accumulator_));
+            continue;
+        }
+
+        int steps = 0;
+        while (accumulator_ >= SIMULATION_STEP) {
+            steps++;
+            accumulator_ -= SIMULATION_STEP;
+        }
+
+        GatherInput(&tick_input_);
+        RunTick(tick_input_, steps);
+        if (recorder_.IsOpen()) recorder_.Write(tick_input_, steps, checksum_);
+
+        PublishSnapshot(now - static_cast<Uint64>(accumulator_ * SDL_GetPerformanceFrequency()));
+        FrameAllocator::Reset();  // This thread's scratch memory only lasts a tick
+    }
+}
+
+void SimulationThread::GatherInput(TickInput* input) {
+    input_.Consume();  // If the main thread hasn't published since the last tick, its last input still holds
+    const FrameInput& frame_input = input_.ReadBuffer();
+
+    input->hmd_pose = frame_input.hmd_pose;
+    input->hmd_pose_valid = frame_input.hmd_pose_valid;
+    input->keyboard_forward = frame_input.keyboard_forward;
+    input->keyboard_right = frame_input.keyboard_right;
+    input_manager_->PollInput(input);
+}
+
+void SimulationThread::RunTick(const TickInput& input, int steps) {
+    // Nothing but the input and the number of steps decides how a tick goes, so a recorded one plays back the same
+    if (input.hmd_pose_valid) camera_->SetCurrentPose(input.hmd_pose);
+    map_->GetPlayer()->SetKeyboardInput(input.keyboard_forward, input.keyboard_right);
+    input_manager_->ApplyInput(input);
+
+    for (int step = 0; step < steps; step++) {
+        map_->Simulate(SIMULATION_STEP);
+        map_->UpdateTransformsAndBounds();  // So the next step collides against where things are now
+        map_->SaveStepTransforms();
+    }
+    checksum_ = map_->StateChecksum(checksum_);
+}
+
+void SimulationThread::PublishSnapshot(Uint64 step_counter) {
+    RenderSnapshot& snapshot = snapshots_.WriteBuffer();
+    map_->ExtractRenderPackets(snapshot.packets, snapshot.previous_model_matrices);
+    snapshot.tracking_center = camera_->TrackingCenterTransform();
+    input_manager_->ExtractControllers(snapshot.hands);
+    snapshot.shader_mode = input_manager_->ShaderMode();
+    snapshot.level_complete = map_->IsComplete();
+    snapshot.step_counter = step_counter;
+
+    snapshots_.Publish();
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "controller.h"
+#include "input_recording.h"
+#include "glm.hpp"
+#include "map.h"
+#include "scene_renderer.h"
+#include "triple_buffer.h"
+#include "vr_camera.h"
+#include "vr_input_manager.h"
+
+// Input that only the main thread can read, passed to the simulation thread once per frame
+struct FrameInput {
+    glm::mat4 hmd_pose;
+    bool hmd_pose_valid = false;
+    float keyboard_forward = 0.0f, keyboard_right = 0.0f;  // Each in [-1, 1]
+};
+
+// Everything the render thread needs for a frame, published by the simulation thread after each tick
+struct RenderSnapshot {
+    std::vector<RenderPacket> packets;               // Posed as of the latest step
+    std::vector<glm::mat4> previous_model_matrices;  // One per packet, as of the step before
+    glm::mat4 tracking_center;
+    ControllerSnapshot hands[2];
+    int shader_mode = 0;
+    bool level_complete = false;  // The player has reached the goal, so the game should end
+    Uint64 step_counter = 0;  // The performance counter reading the latest step stands for
+
+    // Replaces the contents of out with the packets, each interpolation of the way from the previous step's pose to the latest
+    void Interpolate(float interpolation, std::vector<RenderPacket>& out) const;
+};
+
+/**
+ * Handles input and runs the fixed simulation steps on a thread of its own. After each tick it publishes a RenderSnapshot
+ * through a triple buffer, so the render thread draws one tick while the next is simulated and neither ever waits on the other.
+ * While it's running, this thread owns the map, the camera's transforms and the input manager's hands. The main thread has to
+ * Stop() it before touching any of them, like when it loads a level.
+ */
+class SimulationThread {
+   public:
+    SimulationThread();
+    ~SimulationThread();  // Stops the thread if it's still running
+
+    // Publishes a snapshot of the map as it is, so there's something to draw straight away, then starts ticking
+    void Start(Map* map, VRCamera* camera, VRInputManager* input_manager);
+    void Stop();  // Waits for the tick in progress to finish, and ends any recording. Does nothing if the thread isn't running
+    bool Record(const std::string& path, const std::string& map_file);  // Records the ticks from the next Start() until Stop()
+
+    // Plays a recording's ticks back on the calling thread, as fast as they'll go, rather than starting the thread. Reports the first
+    // tick whose checksum doesn't match the recorded one and stops there, and when the goal was reached. Returns whether every tick
+    // matched
+    bool Replay(Map* map, VRCamera* camera, VRInputManager* input_manager, InputPlayback* playback);
+
+    // Main thread only. Fill in NextInput(), then PublishInput()
+    FrameInput& NextInput();
+    void PublishInput();
+    const RenderSnapshot& LatestSnapshot();  // Valid until the next call
+
+   private:
+    void Run();
+    void GatherInput(TickInput* input);  // From the main thread and OpenVR
+    void RunTick(const TickInput& input, int steps);
+    void PublishSnapshot(Uint64 step_counter);
+
+    Map* map_;
+    VRCamera* camera_;
+    VRInputManager* input_manager_;
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+    TripleBuffer<FrameInput> input_;
+    TripleBuffer<RenderSnapshot> snapshots_;
+
+    Uint64 last_counter_;
+    float accumulator_;  // Time not yet simulated, always less than one SIMULATION_STEP after a tick
+    TickInput tick_input_;
+    uint64_t checksum_;  // Of the state after every tick so far
+    InputRecorder recorder_;
+};
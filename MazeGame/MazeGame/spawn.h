@@ -1,7 +1,7 @@
 #pragma once
 #include "game_object.h"
 
-class Spawn : public GameObject {
+class Spawn final : public GameObject {
    public:
     Spawn(Model* model) : GameObject(model) {}
     ~Spawn() = default;
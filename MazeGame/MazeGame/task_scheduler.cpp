@@ -0,0 +1,70 @@
+#include <algorithm>
+#include "game_object.h"
+#include "map.h"
+#include "task_scheduler.h"
+
+TaskScheduler::TaskScheduler(Arena* arena, Map* map)
+    : arena_(arena),
+      map_(map),
+      next_step_(ArenaAllocator<Task>(arena)),
+      running_(ArenaAllocator<Task>(arena)),
+      timers_(ArenaAllocator<Timer>(arena)),
+      time_(0),
+      timer_count_(0) {}
+
+void TaskScheduler::NextStep(Task task) {
+    next_step_.push_back(std::move(task));
+}
+
+void TaskScheduler::After(float seconds, Task task) {
+    timers_.push_back(Timer{time_ + seconds, timer_count_++, std::move(task)});
+    std::push_heap(timers_.begin(), timers_.end(), DueLater);
+}
+
+void TaskScheduler::WhenTriggered(GameObject* object, uint32_t category_mask, std::function<void(GameObject*)> task) {
+    TriggerTask* listener = arena_->New<TriggerTask>(&map_->Triggers(), std::move(task));
+    listener->trigger = map_->Triggers().AddTrigger(object, category_mask, listener);
+}
+
+void TaskScheduler::Animate(GameObject* object, std::function<bool(float)> step, Task done) {
+    map_->Scheduler().Add(object, [step, done](float dt) {
+        if (step(dt)) return true;
+
+        done();
+        return false;
+    });
+}
+
+void TaskScheduler::Step(float dt) {
+    time_ += dt;
+
+    running_.swap(next_step_);
+    for (Task& task : running_) {
+        task();
+    }
+    running_.clear();
+
+    // Popped before it runs, so a task can schedule more timers
+    while (!timers_.empty() && timers_.front().due_time <= time_) {
+        std::pop_heap(timers_.begin(), timers_.end(), DueLater);
+        Task task = std::move(timers_.back().task);
+        timers_.pop_back();
+        task();
+    }
+}
+
+bool TaskScheduler::DueLater(const Timer& a, const Timer& b) {
+    if (a.due_time != b.due_time) return a.due_time > b.due_time;
+    return a.sequence > b.sequence;
+}
+
+TaskScheduler::TriggerTask::TriggerTask(TriggerSystem* triggers, std::function<void(GameObject*)> task)
+    : trigger(-1), triggers_(triggers), task_(std::move(task)), fired_(false) {}
+
+void TaskScheduler::TriggerTask::OnTriggerEnter(GameObject* other) {
+    if (fired_) return;  // Several things can enter in the same update
+    fired_ = true;
+
+    triggers_->SetTriggerEnabled(trigger, false);  // Disabled triggers are skipped, so it costs nothing from here on
+    task_(other);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include "arena.h"
+#include "trigger_system.h"
+
+class GameObject;
+class Map;
+
+/**
+ * Gameplay sequences written as tasks that wait for something, rather than state every object checks each step. A task waiting
+ * on time sits in a heap ordered by when it's due, and one waiting on a trigger or an animation is only looked at once that
+ * happens, so anything that's waiting costs nothing per step.
+ * The game builds as C++14, so there are no coroutines to suspend. Each wait takes the task to run when it's over instead, and a
+ * sequence is a chain of them.
+ */
+class TaskScheduler {
+   public:
+    typedef std::function<void()> Task;
+
+    TaskScheduler(Arena* arena, Map* map);
+
+    void NextStep(Task task);
+    void After(float seconds, Task task);  // In simulation time, so it's as repeatable as the steps are
+    // Runs task(other) the first time something in any of the categories overlaps object, then turns the trigger off
+    void WhenTriggered(GameObject* object, uint32_t category_mask, std::function<void(GameObject*)> task);
+    // Calls step(dt) on the object's SimulationScheduler schedule until it returns false, then runs done
+    void Animate(GameObject* object, std::function<bool(float)> step, Task done);
+
+    void Step(float dt);  // Runs whatever's due. Tasks this schedules for the next step wait for the next call
+
+   private:
+    struct Timer {
+        double due_time;
+        uint64_t sequence;  // Breaks ties, so timers due together run in the order they were made
+        Task task;
+    };
+
+    // A trigger that runs its task once
+    class TriggerTask : public TriggerListener {
+       public:
+        TriggerTask(TriggerSystem* triggers, std::function<void(GameObject*)> task);
+
+        void OnTriggerEnter(GameObject* other) override;
+
+        int trigger;
+
+       private:
+        TriggerSystem* triggers_;
+        std::function<void(GameObject*)> task_;
+        bool fired_;
+    };
+
+    static bool DueLater(const Timer& a, const Timer& b);  // Heap order, with the earliest on top
+
+    Arena* arena_;
+    Map* map_;
+    ArenaVector<Task> next_step_, running_;
+    ArenaVector<Timer> timers_;
+    double time_;
+    uint64_t timer_count_;
+};
@@ -1,5 +1,6 @@
 #include <SDL.h>
 #include <cstdio>
+#include "gl_state.h"
 #include "glad.h"
 #include "shader_manager.h"
 #include "texture_manager.h"
@@ -13,22 +14,20 @@ void TextureManager::InitTextures() {
 
     // Allocate fractal ramp
     InitTexture(&fractal, "fractal.bmp");
-}
 
-void TextureManager::Update() {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tex0);
+    // Which unit each sampler reads. The program keeps these, so they're only set once
+    GLState::UseProgram(ShaderManager::Textured_Shader);
     glUniform1i(glGetUniformLocation(ShaderManager::Textured_Shader, "tex0"), 0);
-
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, tex1);
     glUniform1i(glGetUniformLocation(ShaderManager::Textured_Shader, "tex1"), 1);
-
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, fractal);
     glUniform1i(glGetUniformLocation(ShaderManager::Textured_Shader, "fractal"), 2);
 }
 
+void TextureManager::Update() {
+    GLState::BindTexture(0, GL_TEXTURE_2D, tex0);
+    GLState::BindTexture(1, GL_TEXTURE_2D, tex1);
+    GLState::BindTexture(2, GL_TEXTURE_2D, fractal);
+}
+
 void TextureManager::InitTexture(GLuint* tex_location, const char* file) {
     SDL_Surface* surface = SDL_LoadBMP(file);
     if (surface == NULL) {  // If it failed, print the error
@@ -37,8 +36,7 @@ void TextureManager::InitTexture(GLuint* tex_location, const char* file) {
     }
     glGenTextures(1, tex_location);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, *tex_location);
+    GLState::BindTexture(0, GL_TEXTURE_2D, *tex_location);
 
     // What to do outside 0-1 range
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -5,6 +5,7 @@ in vec3 vertNormal;
 in vec3 pos;
 in vec3 lightDir;
 in vec2 texcoord;
+flat in int TexID;
 
 out vec4 outColor;
 
@@ -14,7 +15,6 @@ uniform sampler2D tex1;
 // Fractal ramp
 uniform sampler2D fractal;
 
-uniform int texID;
 uniform int shaderMode;
 
 const float ambient = .25;
@@ -43,13 +43,13 @@ void main() {
   }
 
   vec3 color;
-  if (texID == -1)
+  if (TexID == -1)
     color = Color;
-  else if (texID == 0)
+  else if (TexID == 0)
     color = texture(tex0, texcoord).rgb;
-  else if (texID == 1)
+  else if (TexID == 1)
     color = texture(tex1, texcoord).rgb;
-  else if (texID == 2) {
+  else if (TexID == 2) {
     // http://nuclear.mutantstargoat.com/articles/sdr_fract/
     vec2 z, c;
 
@@ -81,7 +81,7 @@ void main() {
   float spec = max(dot(reflectDir,lightDir),0.0);
   if (dot(-lightDir,normal) <= 0.0) spec = 0; //No highlight if we are not facing the light
   float specFactor = 0.7;
-  if (texID > -1) specFactor = 0.1;
+  if (TexID > -1) specFactor = 0.1;
   vec3 specC = specFactor*vec3(1.0,1.0,1.0)*pow(spec,4);
   vec3 oColor = ambC+diffuseC+specC;
   float lightIntensity = length(oColor);
@@ -8,23 +8,33 @@ const vec3 inLightDir = normalize(vec3(-1,1,-1));
 in vec3 inNormal;
 in vec2 inTexcoord;
 
+// Per instance, for batches of static objects drawn in one call. Otherwise the uniforms below are used
+in mat4 instanceModel;
+in vec3 instanceColor;
+in int instanceTexID;
+
 out vec3 Color;
 out vec3 vertNormal;
 out vec3 pos;
 out vec3 lightDir;
 out vec2 texcoord;
+flat out int TexID;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 uniform vec3 inColor;
+uniform int texID;
+uniform bool instanced;
 
 void main() {
-   Color = inColor;
-   gl_Position = proj * view * model * vec4(position,1.0);
-   pos = (view * model * vec4(position,1.0)).xyz;
+   mat4 modelMatrix = instanced ? instanceModel : model;
+   Color = instanced ? instanceColor : inColor;
+   TexID = instanced ? instanceTexID : texID;
+   gl_Position = proj * view * modelMatrix * vec4(position,1.0);
+   pos = (view * modelMatrix * vec4(position,1.0)).xyz;
    lightDir = (view * vec4(inLightDir,0.0)).xyz; //It's a vector!
-   vec4 norm4 = transpose(inverse(view*model)) * vec4(inNormal,0.0);
+   vec4 norm4 = transpose(inverse(view*modelMatrix)) * vec4(inNormal,0.0);
    vertNormal = normalize(norm4.xyz);
    texcoord = inTexcoord;
 }
\ No newline at end of file
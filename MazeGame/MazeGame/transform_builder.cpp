@@ -0,0 +1,49 @@
+#include <cmath>
+#include <cstdio>
+#include "constants.h"
+#include "transform_builder.h"
+
+TransformBuilder::TransformBuilder() : TransformBuilder(glm::vec3(0)) {}
+
+TransformBuilder::TransformBuilder(const glm::vec3& translation) : translation(translation), rotation(), scale(glm::vec3(1)) {}
+
+TransformBuilder& TransformBuilder::Translate(float x, float y, float z) {
+    return Translate(glm::vec3(x, y, z));
+}
+
+TransformBuilder& TransformBuilder::Translate(const glm::vec3& translate_by) {
+    translation += rotation * (scale * translate_by);  // Local-space translation, like glm::translate on the composed matrix
+    return *this;
+}
+
+TransformBuilder& TransformBuilder::Rotate(float radians, const glm::vec3& around) {
+    if (!HasUniformScale()) {
+        printf("Warning: TransformBuilder can't rotate after a non-uniform scale. The shear will be ignored\n");
+    }
+
+    rotation = glm::normalize(rotation * glm::angleAxis(radians, glm::normalize(around)));
+    return *this;
+}
+
+TransformBuilder& TransformBuilder::Scale(const glm::vec3& scale) {
+    this->scale *= scale;
+    return *this;
+}
+
+TransformBuilder& TransformBuilder::Scale(float scale) {
+    return Scale(glm::vec3(scale, scale, scale));
+}
+
+glm::mat4 TransformBuilder::Matrix() const {
+    glm::mat4 matrix = glm::mat4_cast(rotation);  // T * R * S, built directly instead of through two matrix products
+    matrix[0] *= scale.x;
+    matrix[1] *= scale.y;
+    matrix[2] *= scale.z;
+    matrix[3] = glm::vec4(translation, 1.0f);
+
+    return matrix;
+}
+
+bool TransformBuilder::HasUniformScale() const {
+    return std::abs(scale.x - scale.y) < ABSOLUTE_TOLERANCE && std::abs(scale.x - scale.z) < ABSOLUTE_TOLERANCE;
+}
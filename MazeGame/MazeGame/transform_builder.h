@@ -0,0 +1,34 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#include <gtc/quaternion.hpp>
+#include "gtc/matrix_transform.hpp"
+
+/**
+ * Accumulates a local transform as translation, rotation, and scale components so that a whole sequence of edits can be committed
+ * to a Transformable with a single matrix build and a single world transform recalculation.
+ *
+ * Edits compose the same way the matching Transformable calls do (each one is applied in the current local space), so
+ * builder.Scale(s).Translate(t) gives the same matrix as calling transform->Scale(s) and then transform->Translate(t).
+ * Known limitation: rotating after a non-uniform scale would introduce shear, which TRS components can't represent.
+ */
+class TransformBuilder {
+   public:
+    TransformBuilder();
+    explicit TransformBuilder(const glm::vec3& translation);
+
+    TransformBuilder& Translate(float x, float y, float z);
+    TransformBuilder& Translate(const glm::vec3& translate_by);
+    TransformBuilder& Rotate(float radians, const glm::vec3& around);
+    TransformBuilder& Scale(const glm::vec3& scale);
+    TransformBuilder& Scale(float scale);
+
+    glm::mat4 Matrix() const;
+
+    glm::vec3 translation;
+    glm::quat rotation;
+    glm::vec3 scale;
+
+   private:
+    bool HasUniformScale() const;
+};
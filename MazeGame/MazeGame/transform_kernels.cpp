@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "gtc/matrix_transform.hpp"
+#include "transform_kernels.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define TRANSFORM_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_SSE
+#define TARGET_AVX2
+#else
+#include <cpuid.h>
+#define TARGET_SSE __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+using glm::mat4;
+using glm::vec3;
+
+namespace {
+
+//// Scalar kernels. These are also the reference results for the SIMD versions ////
+
+void ComposeScalar(const mat4* parent_world, const mat4* local, mat4* world, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        world[i] = parent_world[i] * local[i];
+    }
+}
+
+void BoundsScalar(const mat4* world, const vec3* local_min, const vec3* local_max, vec3* world_min, vec3* world_max, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const mat4& m = world[i];
+        vec3 center = (local_min[i] + local_max[i]) * 0.5f;
+        vec3 extent = (local_max[i] - local_min[i]) * 0.5f;
+
+        vec3 world_center = vec3(m * glm::vec4(center, 1.0f));
+        vec3 world_extent = glm::abs(vec3(m[0])) * extent.x + glm::abs(vec3(m[1])) * extent.y + glm::abs(vec3(m[2])) * extent.z;
+
+        world_min[i] = world_center - world_extent;
+        world_max[i] = world_center + world_extent;
+    }
+}
+
+void ExtractScalar(const mat4* world, vec3* translation, vec3* scale, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        translation[i] = vec3(world[i][3]);
+        scale[i] = vec3(glm::length(vec3(world[i][0])), glm::length(vec3(world[i][1])), glm::length(vec3(world[i][2])));
+    }
+}
+
+#ifdef TRANSFORM_KERNELS_X86
+
+//// SSE kernels: one matrix per iteration ////
+
+TARGET_SSE inline void StoreVec3(vec3& destination, __m128 value) {
+    float temp[4];
+    _mm_storeu_ps(temp, value);
+    destination = vec3(temp[0], temp[1], temp[2]);
+}
+
+TARGET_SSE void ComposeSse(const mat4* parent_world, const mat4* local, mat4* world, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const float* p = &parent_world[i][0][0];
+        const float* l = &local[i][0][0];
+        float* w = &world[i][0][0];
+
+        __m128 p0 = _mm_loadu_ps(p), p1 = _mm_loadu_ps(p + 4), p2 = _mm_loadu_ps(p + 8), p3 = _mm_loadu_ps(p + 12);
+        for (int column = 0; column < 16; column += 4) {
+            __m128 result = _mm_mul_ps(p0, _mm_set1_ps(l[column]));
+            result = _mm_add_ps(result, _mm_mul_ps(p1, _mm_set1_ps(l[column + 1])));
+            result = _mm_add_ps(result, _mm_mul_ps(p2, _mm_set1_ps(l[column + 2])));
+            result = _mm_add_ps(result, _mm_mul_ps(p3, _mm_set1_ps(l[column + 3])));
+            _mm_storeu_ps(w + column, result);
+        }
+    }
+}
+
+TARGET_SSE void BoundsSse(const mat4* world, const vec3* local_min, const vec3* local_max, vec3* world_min, vec3* world_max, size_t count) {
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    for (size_t i = 0; i < count; i++) {
+        const float* m = &world[i][0][0];
+        __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+
+        __m128 box_min = _mm_setr_ps(local_min[i].x, local_min[i].y, local_min[i].z, 0);
+        __m128 box_max = _mm_setr_ps(local_max[i].x, local_max[i].y, local_max[i].z, 0);
+        __m128 center = _mm_mul_ps(_mm_add_ps(box_min, box_max), half);
+        __m128 extent = _mm_mul_ps(_mm_sub_ps(box_max, box_min), half);
+
+        __m128 world_center = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0))));
+        world_center = _mm_add_ps(world_center, _mm_mul_ps(c1, _mm_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1))));
+        world_center = _mm_add_ps(world_center, _mm_mul_ps(c2, _mm_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2))));
+
+        __m128 world_extent = _mm_mul_ps(_mm_and_ps(c0, abs_mask), _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0)));
+        world_extent =
+            _mm_add_ps(world_extent, _mm_mul_ps(_mm_and_ps(c1, abs_mask), _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1))));
+        world_extent =
+            _mm_add_ps(world_extent, _mm_mul_ps(_mm_and_ps(c2, abs_mask), _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2))));
+
+        StoreVec3(world_min[i], _mm_sub_ps(world_center, world_extent));
+        StoreVec3(world_max[i], _mm_add_ps(world_center, world_extent));
+    }
+}
+
+TARGET_SSE void ExtractSse(const mat4* world, vec3* translation, vec3* scale, size_t count) {
+    const __m128 zero = _mm_setzero_ps();
+
+    for (size_t i = 0; i < count; i++) {
+        const float* m = &world[i][0][0];
+        __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8);
+
+        // Transpose the upper 3x3 so that one multiply-add sums the squares of all three columns at once
+        __m128 t0 = _mm_unpacklo_ps(c0, c1), t1 = _mm_unpackhi_ps(c0, c1);
+        __m128 t2 = _mm_unpacklo_ps(c2, zero), t3 = _mm_unpackhi_ps(c2, zero);
+        __m128 row_x = _mm_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m128 row_y = _mm_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m128 row_z = _mm_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+
+        __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(row_x, row_x), _mm_mul_ps(row_y, row_y)), _mm_mul_ps(row_z, row_z));
+        StoreVec3(scale[i], _mm_sqrt_ps(length_squared));
+        translation[i] = vec3(world[i][3]);
+    }
+}
+
+//// AVX2 kernels: bounds and extract do two matrices per iteration, one in each 128-bit lane, with the leftover handled by SSE ////
+
+TARGET_AVX2 inline __m256 LoadPair(const float* low, const float* high) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+TARGET_AVX2 inline __m256 BroadcastColumn(const float* column) {
+    __m128 value = _mm_loadu_ps(column);
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(value), value, 1);
+}
+
+TARGET_AVX2 inline void StorePair(vec3& low, vec3& high, __m256 value) {
+    float temp[8];
+    _mm256_storeu_ps(temp, value);
+    low = vec3(temp[0], temp[1], temp[2]);
+    high = vec3(temp[4], temp[5], temp[6]);
+}
+
+// One matrix per iteration, since each lane works on a different pair of columns of the same result
+TARGET_AVX2 void ComposeAvx2(const mat4* parent_world, const mat4* local, mat4* world, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const float* p = &parent_world[i][0][0];
+        const float* l = &local[i][0][0];
+        float* w = &world[i][0][0];
+
+        // Both lanes hold the parent; each lane computes a different column of the result
+        __m256 p0 = BroadcastColumn(p), p1 = BroadcastColumn(p + 4), p2 = BroadcastColumn(p + 8), p3 = BroadcastColumn(p + 12);
+        for (int column = 0; column < 16; column += 8) {
+            __m256 local_columns = _mm256_loadu_ps(l + column);
+            __m256 result = _mm256_mul_ps(p0, _mm256_permute_ps(local_columns, 0x00));
+            result = _mm256_fmadd_ps(p1, _mm256_permute_ps(local_columns, 0x55), result);
+            result = _mm256_fmadd_ps(p2, _mm256_permute_ps(local_columns, 0xAA), result);
+            result = _mm256_fmadd_ps(p3, _mm256_permute_ps(local_columns, 0xFF), result);
+            _mm256_storeu_ps(w + column, result);
+        }
+    }
+}
+
+TARGET_AVX2 void BoundsAvx2(const mat4* world, const vec3* local_min, const vec3* local_max, vec3* world_min, vec3* world_max,
+                            size_t count) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        const float* a = &world[i][0][0];
+        const float* b = &world[i + 1][0][0];
+        __m256 c0 = LoadPair(a, b), c1 = LoadPair(a + 4, b + 4), c2 = LoadPair(a + 8, b + 8), c3 = LoadPair(a + 12, b + 12);
+
+        const vec3 &min_a = local_min[i], &min_b = local_min[i + 1], &max_a = local_max[i], &max_b = local_max[i + 1];
+        __m256 box_min = _mm256_setr_ps(min_a.x, min_a.y, min_a.z, 0, min_b.x, min_b.y, min_b.z, 0);
+        __m256 box_max = _mm256_setr_ps(max_a.x, max_a.y, max_a.z, 0, max_b.x, max_b.y, max_b.z, 0);
+        __m256 center = _mm256_mul_ps(_mm256_add_ps(box_min, box_max), half);
+        __m256 extent = _mm256_mul_ps(_mm256_sub_ps(box_max, box_min), half);
+
+        __m256 world_center = _mm256_fmadd_ps(c0, _mm256_permute_ps(center, 0x00), c3);
+        world_center = _mm256_fmadd_ps(c1, _mm256_permute_ps(center, 0x55), world_center);
+        world_center = _mm256_fmadd_ps(c2, _mm256_permute_ps(center, 0xAA), world_center);
+
+        __m256 world_extent = _mm256_mul_ps(_mm256_and_ps(c0, abs_mask), _mm256_permute_ps(extent, 0x00));
+        world_extent = _mm256_fmadd_ps(_mm256_and_ps(c1, abs_mask), _mm256_permute_ps(extent, 0x55), world_extent);
+        world_extent = _mm256_fmadd_ps(_mm256_and_ps(c2, abs_mask), _mm256_permute_ps(extent, 0xAA), world_extent);
+
+        StorePair(world_min[i], world_min[i + 1], _mm256_sub_ps(world_center, world_extent));
+        StorePair(world_max[i], world_max[i + 1], _mm256_add_ps(world_center, world_extent));
+    }
+
+    BoundsSse(world + i, local_min + i, local_max + i, world_min + i, world_max + i, count - i);
+}
+
+TARGET_AVX2 void ExtractAvx2(const mat4* world, vec3* translation, vec3* scale, size_t count) {
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        const float* a = &world[i][0][0];
+        const float* b = &world[i + 1][0][0];
+        __m256 c0 = LoadPair(a, b), c1 = LoadPair(a + 4, b + 4), c2 = LoadPair(a + 8, b + 8);
+
+        __m256 t0 = _mm256_unpacklo_ps(c0, c1), t1 = _mm256_unpackhi_ps(c0, c1);
+        __m256 t2 = _mm256_unpacklo_ps(c2, zero), t3 = _mm256_unpackhi_ps(c2, zero);
+        __m256 row_x = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 row_y = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 row_z = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+
+        __m256 length_squared = _mm256_fmadd_ps(row_z, row_z, _mm256_fmadd_ps(row_y, row_y, _mm256_mul_ps(row_x, row_x)));
+        StorePair(scale[i], scale[i + 1], _mm256_sqrt_ps(length_squared));
+        translation[i] = vec3(world[i][3]);
+        translation[i + 1] = vec3(world[i + 1][3]);
+    }
+
+    ExtractSse(world + i, translation + i, scale + i, count - i);
+}
+
+bool CpuSupportsSse() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+bool CpuSupportsAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    bool has_fma = (info[2] & (1 << 12)) != 0;
+    bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    bool has_avx = (info[2] & (1 << 28)) != 0;
+    if (!has_fma || !has_osxsave || !has_avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;  // The OS has to save the YMM registers for us
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif  // TRANSFORM_KERNELS_X86
+
+//// Benchmark helpers ////
+
+double MillisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+float MaxDifference(const std::vector<vec3>& a, const std::vector<vec3>& b) {
+    float difference = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        vec3 delta = glm::abs(a[i] - b[i]);
+        difference = std::max(difference, std::max(delta.x, std::max(delta.y, delta.z)));
+    }
+    return difference;
+}
+
+}  // namespace
+
+void TransformKernels::Init() {
+    if (!Use(AVX2) && !Use(SSE)) {
+        Use(SCALAR);
+    }
+
+    printf("Transform kernels: using %s\n", Name(active_));
+}
+
+bool TransformKernels::Use(Implementation implementation) {
+    if (!IsSupported(implementation)) return false;
+
+    switch (implementation) {
+#ifdef TRANSFORM_KERNELS_X86
+        case AVX2:
+            compose_ = ComposeAvx2;
+            bounds_ = BoundsAvx2;
+            extract_ = ExtractAvx2;
+            break;
+        case SSE:
+            compose_ = ComposeSse;
+            bounds_ = BoundsSse;
+            extract_ = ExtractSse;
+            break;
+#endif
+        default:
+            compose_ = ComposeScalar;
+            bounds_ = BoundsScalar;
+            extract_ = ExtractScalar;
+            break;
+    }
+
+    active_ = implementation;
+    return true;
+}
+
+bool TransformKernels::IsSupported(Implementation implementation) {
+    switch (implementation) {
+#ifdef TRANSFORM_KERNELS_X86
+        case AVX2:
+            return CpuSupportsAvx2();
+        case SSE:
+            return CpuSupportsSse();
+#endif
+        case SCALAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+TransformKernels::Implementation TransformKernels::Active() {
+    return active_;
+}
+
+const char* TransformKernels::Name(Implementation implementation) {
+    switch (implementation) {
+        case AVX2:
+            return "AVX2";
+        case SSE:
+            return "SSE";
+        default:
+            return "scalar";
+    }
+}
+
+void TransformKernels::ComposeWorldTransforms(const mat4* parent_world, const mat4* local, mat4* world, size_t count) {
+    compose_(parent_world, local, world, count);
+}
+
+void TransformKernels::TransformBounds(const mat4* world, const vec3* local_min, const vec3* local_max, vec3* world_min, vec3* world_max,
+                                       size_t count) {
+    bounds_(world, local_min, local_max, world_min, world_max, count);
+}
+
+void TransformKernels::ExtractTranslationAndScale(const mat4* world, vec3* translation, vec3* scale, size_t count) {
+    extract_(world, translation, scale, count);
+}
+
+void TransformKernels::RunBenchmark() {
+    const size_t count = 4096;
+    const int iterations = 200;
+
+    // Roughly what a map looks like: a spread of rotated, scaled objects, each with a unit cube as its model-space box
+    std::vector<mat4> parents(count), locals(count), worlds(count);
+    std::vector<vec3> local_min(count, vec3(-0.5f)), local_max(count, vec3(0.5f));
+    for (size_t i = 0; i < count; i++) {
+        parents[i] = glm::rotate(glm::translate(mat4(), vec3(i % 64, i / 64, 0.5f)), 0.01f * i, vec3(0, 0, 1));
+        locals[i] = glm::scale(glm::rotate(mat4(), 0.02f * i, vec3(1, 1, 0)), vec3(1.0f + (i % 3) * 0.1f));
+    }
+
+    // Baseline: what the per-node code does today. One glm product per node, eight transformed corners per box (like
+    // GameObject::InitBoundingBox), and Transformable::GetScale()'s column lengths
+    std::vector<vec3> expected_min(count), expected_max(count), expected_translation(count), expected_scale(count);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        for (size_t i = 0; i < count; i++) {
+            worlds[i] = parents[i] * locals[i];
+        }
+    }
+    double compose_time = MillisecondsSince(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        for (size_t i = 0; i < count; i++) {
+            vec3 box_min = vec3(INFINITY), box_max = vec3(-INFINITY);
+            for (int corner = 0; corner < 8; corner++) {
+                vec3 local_corner = vec3(corner & 1 ? local_max[i].x : local_min[i].x, corner & 2 ? local_max[i].y : local_min[i].y,
+                                         corner & 4 ? local_max[i].z : local_min[i].z);
+                vec3 world_corner = vec3(worlds[i] * glm::vec4(local_corner, 1.0f));
+                box_min = glm::min(box_min, world_corner);
+                box_max = glm::max(box_max, world_corner);
+            }
+            expected_min[i] = box_min;
+            expected_max[i] = box_max;
+        }
+    }
+    double bounds_time = MillisecondsSince(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        for (size_t i = 0; i < count; i++) {
+            expected_translation[i] = vec3(worlds[i][3]);
+            expected_scale[i] = vec3(glm::length(vec3(worlds[i][0])), glm::length(vec3(worlds[i][1])), glm::length(vec3(worlds[i][2])));
+        }
+    }
+    double extract_time = MillisecondsSince(start);
+
+    printf("Transform kernel benchmark: %zu transforms x %d iterations\n", count, iterations);
+    printf("  %-10s compose %8.3f ms  bounds %8.3f ms  extract %8.3f ms\n", "glm", compose_time, bounds_time, extract_time);
+
+    Implementation previous = active_;
+    std::vector<mat4> kernel_worlds(count);
+    std::vector<vec3> world_min(count), world_max(count), translation(count), scale(count);
+    for (Implementation implementation : {SCALAR, SSE, AVX2}) {
+        if (!Use(implementation)) {
+            printf("  %-10s not supported on this CPU\n", Name(implementation));
+            continue;
+        }
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            ComposeWorldTransforms(parents.data(), locals.data(), kernel_worlds.data(), count);
+        }
+        compose_time = MillisecondsSince(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            TransformBounds(kernel_worlds.data(), local_min.data(), local_max.data(), world_min.data(), world_max.data(), count);
+        }
+        bounds_time = MillisecondsSince(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            ExtractTranslationAndScale(kernel_worlds.data(), translation.data(), scale.data(), count);
+        }
+        extract_time = MillisecondsSince(start);
+
+        float error = std::max(std::max(MaxDifference(world_min, expected_min), MaxDifference(world_max, expected_max)),
+                               std::max(MaxDifference(translation, expected_translation), MaxDifference(scale, expected_scale)));
+        printf("  %-10s compose %8.3f ms  bounds %8.3f ms  extract %8.3f ms  (max error %g)\n", Name(implementation), compose_time,
+               bounds_time, extract_time, error);
+    }
+
+    Use(previous);
+}
+
+TransformKernels::Implementation TransformKernels::active_ = TransformKernels::SCALAR;
+TransformKernels::ComposeFunction TransformKernels::compose_ = ComposeScalar;
+TransformKernels::BoundsFunction TransformKernels::bounds_ = BoundsScalar;
+TransformKernels::ExtractFunction TransformKernels::extract_ = ExtractScalar;
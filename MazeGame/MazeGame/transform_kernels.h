@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include "glm.hpp"
+
+/**
+ * Batch kernels used by the once-per-frame transform and bounds pass. Every kernel has a scalar version plus SSE and AVX2
+ * versions, and Init() picks the widest one the CPU supports at runtime. Input and output arrays must not overlap.
+ */
+class TransformKernels {
+   public:
+    typedef enum { SCALAR = 0, SSE = 1, AVX2 = 2 } Implementation;
+
+    static void Init();
+    static bool Use(Implementation implementation);  // Returns false (and changes nothing) if the CPU can't run it
+    static bool IsSupported(Implementation implementation);
+    static Implementation Active();
+    static const char* Name(Implementation implementation);
+
+    // world[i] = parent_world[i] * local[i]
+    static void ComposeWorldTransforms(const glm::mat4* parent_world, const glm::mat4* local, glm::mat4* world, size_t count);
+
+    // Transforms model-space boxes by their world matrices with the center/extent method, giving world-space AABBs
+    static void TransformBounds(const glm::mat4* world, const glm::vec3* local_min, const glm::vec3* local_max, glm::vec3* world_min,
+                                glm::vec3* world_max, size_t count);
+
+    // Same results as Transformable::WorldPosition() and Transformable::GetScale()
+    static void ExtractTranslationAndScale(const glm::mat4* world, glm::vec3* translation, glm::vec3* scale, size_t count);
+
+    // Times each supported implementation against the per-node glm code and prints the results
+    static void RunBenchmark();
+
+   private:
+    typedef void (*ComposeFunction)(const glm::mat4*, const glm::mat4*, glm::mat4*, size_t);
+    typedef void (*BoundsFunction)(const glm::mat4*, const glm::vec3*, const glm::vec3*, glm::vec3*, glm::vec3*, size_t);
+    typedef void (*ExtractFunction)(const glm::mat4*, glm::vec3*, glm::vec3*, size_t);
+
+    static Implementation active_;
+    static ComposeFunction compose_;
+    static BoundsFunction bounds_;
+    static ExtractFunction extract_;
+};
@@ -1,19 +1,38 @@
 #include <memory>
+#include "constants.h"
+#include "job_system.h"
+#include "transform_kernels.h"
 #include "transformable.h"
 
+namespace {
+// Scratch space for UpdateAllWorldTransforms(), kept between frames so the pass doesn't allocate
+std::vector<std::vector<Transformable*>> dirty_levels;
+std::vector<glm::mat4> parent_transforms, local_transforms, world_transforms;
+std::vector<glm::vec3> parent_positions, parent_scales;
+}  // namespace
+
 Transformable::Transformable(bool inherits_rotation) : inherits_rotation_(inherits_rotation) {
     children_ = std::unordered_set<std::shared_ptr<Transformable>>();
     parent_ = std::weak_ptr<Transformable>();
     local_transform_ = glm::mat4();
     world_transform_ = glm::mat4();
+    world_transform_dirty_ = true;
     Reset();
+
+    registry_index_ = registry_.size();
+    registry_.push_back(this);
 }
 
 Transformable::Transformable(const glm::vec3& position, bool inherits_rotation) : Transformable(inherits_rotation) {
     Translate(position);
 }
 
-Transformable::~Transformable() = default;
+Transformable::~Transformable() {
+    Transformable* moved = registry_.back();  // Swap-remove so unregistering is constant time
+    registry_[registry_index_] = moved;
+    moved->registry_index_ = registry_index_;
+    registry_.pop_back();
+}
 
 void Transformable::Reset() {
     ClearChildren();
@@ -23,12 +42,12 @@ void Transformable::Reset() {
 
 void Transformable::ResetLocalTransform() {
     local_transform_ = glm::mat4();
-    RecalculateWorldTransform();
+    InvalidateWorldTransform();
 }
 
 void Transformable::Rotate(float radians, const glm::vec3& around) {
     local_transform_ = glm::rotate(local_transform_, radians, around);
-    RecalculateWorldTransform();
+    InvalidateWorldTransform();
 }
 
 void Transformable::Translate(float x, float y, float z) {
@@ -37,12 +56,12 @@ void Transformable::Translate(float x, float y, float z) {
 
 void Transformable::Translate(const glm::vec3& translate_by) {
     local_transform_ = glm::translate(local_transform_, translate_by);
-    RecalculateWorldTransform();
+    InvalidateWorldTransform();
 }
 
 void Transformable::Scale(const glm::vec3& scale) {
     local_transform_ = glm::scale(local_transform_, scale);
-    RecalculateWorldTransform();
+    InvalidateWorldTransform();
 }
 
 void Transformable::Scale(float scale) {
@@ -51,21 +70,25 @@ void Transformable::Scale(float scale) {
 
 void Transformable::ApplyMatrix(const glm::mat4 matrix) {
     local_transform_ = matrix * local_transform_;
-    RecalculateWorldTransform();
+    InvalidateWorldTransform();
 }
 
 void Transformable::ResetAndSetTranslation(const glm::vec3& translation) {
-    ResetLocalTransform();
-    Translate(translation);
+    Set(TransformBuilder(translation));
 }
 
 void Transformable::Set(const glm::mat4 new_local_transform) {
     local_transform_ = new_local_transform;
-    RecalculateWorldTransform();
+    InvalidateWorldTransform();
+}
+
+void Transformable::Set(const TransformBuilder& new_local_transform) {
+    Set(new_local_transform.Matrix());
 }
 
 void Transformable::SetInheritsRotation(bool inherits_rotation) {
     inherits_rotation_ = inherits_rotation;
+    InvalidateWorldTransform();
 }
 
 void Transformable::AddChild(std::shared_ptr<Transformable> child) {
@@ -83,8 +106,8 @@ void Transformable::RemoveChild(std::shared_ptr<Transformable> child) {
 }
 
 void Transformable::ClearChildren() {
-    for (auto child : children_) {
-        RemoveChild(child);
+    while (!children_.empty()) {  // RemoveChild erases from children_, so don't iterate over it
+        RemoveChild(*children_.begin());
     }
 }
 
@@ -97,7 +120,12 @@ void Transformable::SetParent(std::shared_ptr<Transformable> parent) {
     if (!parent->HasChild(shared_from_this())) {
         parent->AddChild(shared_from_this());
     }
-    RecalculateWorldTransform();
+    InvalidateWorldTransform();
+}
+
+void Transformable::SetParent(std::shared_ptr<Transformable> parent, const TransformBuilder& new_local_transform) {
+    local_transform_ = new_local_transform.Matrix();  // SetParent recalculates the world transform, so don't do it twice
+    SetParent(parent);
 }
 
 void Transformable::ClearParent() {
@@ -106,7 +134,7 @@ void Transformable::ClearParent() {
     if (former_parent && former_parent->HasChild(shared_from_this())) {
         former_parent->RemoveChild(shared_from_this());
     }
-    RecalculateWorldTransform();
+    InvalidateWorldTransform();
 }
 
 bool Transformable::HasChild(std::shared_ptr<Transformable> child) const {
@@ -117,18 +145,10 @@ bool Transformable::IsParent(std::shared_ptr<Transformable> parent) const {
     return parent_.lock() == parent;
 }
 
-void Transformable::RecalculateWorldTransform() {
-    if (parent_.expired()) {
-        world_transform_ = local_transform_;
-    } else {
-        if (inherits_rotation_) {
-            world_transform_ = parent_.lock()->world_transform_ * local_transform_;
-        } else {
-            auto parent_transform = glm::translate(glm::mat4(), parent_.lock()->WorldPosition());
-            parent_transform = glm::scale(parent_transform, parent_.lock()->GetScale());
-            world_transform_ = parent_transform * local_transform_;
-        }
-    }
+void Transformable::InvalidateWorldTransform() {
+    if (world_transform_dirty_) return;  // Everything below a dirty transform is already dirty
+
+    world_transform_dirty_ = true;
     NotifyChildrenOfUpdate();
 }
 
@@ -146,7 +166,67 @@ void Transformable::NotifyChildOfUpdate(std::shared_ptr<Transformable> child) {
         exit(1);
     }
 
-    child->RecalculateWorldTransform();
+    child->InvalidateWorldTransform();
+}
+
+void Transformable::UpdateAllWorldTransforms() {
+    for (auto& level : dirty_levels) {
+        level.clear();
+    }
+
+    for (Transformable* transformable : registry_) {
+        if (!transformable->world_transform_dirty_) continue;
+
+        size_t depth = transformable->Depth();
+        if (depth >= dirty_levels.size()) dirty_levels.resize(depth + 1);
+        dirty_levels[depth].push_back(transformable);
+    }
+
+    // A dirty transform's parent is either clean or one level up, so it's always up to date by the time its level is composed
+    for (const auto& level : dirty_levels) {
+        size_t count = level.size();
+        if (count == 0) continue;
+
+        parent_transforms.resize(count);
+        local_transforms.resize(count);
+        world_transforms.resize(count);
+        parent_positions.resize(count);
+        parent_scales.resize(count);
+
+        // Nodes in a level only read the level above, so its chunks can be composed independently
+        JobSystem::ParallelFor("World transforms", static_cast<int>(count), JOB_TRANSFORMS_PER_CHUNK, [&](int begin, int end) {
+            bool any_without_rotation = false;
+            for (int i = begin; i < end; i++) {
+                auto parent = level[i]->parent_.lock();
+                parent_transforms[i] = parent ? parent->world_transform_ : glm::mat4();
+                local_transforms[i] = level[i]->local_transform_;
+                any_without_rotation |= parent && !level[i]->inherits_rotation_;
+            }
+
+            if (any_without_rotation) {  // These only inherit the parent's position and scale, so rebuild their parent matrices
+                TransformKernels::ExtractTranslationAndScale(&parent_transforms[begin], &parent_positions[begin], &parent_scales[begin],
+                                                             end - begin);
+
+                for (int i = begin; i < end; i++) {
+                    if (level[i]->inherits_rotation_) continue;
+
+                    parent_transforms[i] = glm::mat4();
+                    parent_transforms[i][0][0] = parent_scales[i].x;
+                    parent_transforms[i][1][1] = parent_scales[i].y;
+                    parent_transforms[i][2][2] = parent_scales[i].z;
+                    parent_transforms[i][3] = glm::vec4(parent_positions[i], 1.0f);
+                }
+            }
+
+            TransformKernels::ComposeWorldTransforms(&parent_transforms[begin], &local_transforms[begin], &world_transforms[begin],
+                                                     end - begin);
+
+            for (int i = begin; i < end; i++) {
+                level[i]->world_transform_ = world_transforms[i];
+                level[i]->world_transform_dirty_ = false;
+            }
+        });
+    }
 }
 
 glm::mat4 Transformable::LocalTransform() const {
@@ -154,24 +234,24 @@ glm::mat4 Transformable::LocalTransform() const {
 }
 
 glm::mat4 Transformable::WorldTransform() const {
-    return world_transform_;
+    return CurrentWorldTransform();
 }
 
 float Transformable::X() const {
-    return world_transform_[3][0];  // Only translations (stored in the last column of the matrix) will come through if the
-                                    // Transformable is interpreted as a position. GLM stores such that the first index is the first column
+    return CurrentWorldTransform()[3][0];  // Only translations (stored in the last column of the matrix) will come through if the
+                                           // Transformable is interpreted as a position. GLM stores such that the first index is the first column
 }
 
 float Transformable::Y() const {
-    return world_transform_[3][1];
+    return CurrentWorldTransform()[3][1];
 }
 
 float Transformable::Z() const {
-    return world_transform_[3][2];
+    return CurrentWorldTransform()[3][2];
 }
 
 glm::vec3 Transformable::WorldPosition() const {
-    return glm::vec3(world_transform_[3]);
+    return glm::vec3(CurrentWorldTransform()[3]);
 }
 
 glm::vec3 Transformable::LocalPosition() const {
@@ -179,10 +259,47 @@ glm::vec3 Transformable::LocalPosition() const {
 }
 
 glm::vec3 Transformable::GetScale() const {
+    const glm::mat4& world_transform = CurrentWorldTransform();
     glm::vec3 scale;
-    scale.x = glm::length(glm::vec3(world_transform_[0]));
-    scale.y = glm::length(glm::vec3(world_transform_[1]));
-    scale.z = glm::length(glm::vec3(world_transform_[2]));
+    scale.x = glm::length(glm::vec3(world_transform[0]));
+    scale.y = glm::length(glm::vec3(world_transform[1]));
+    scale.z = glm::length(glm::vec3(world_transform[2]));
 
     return scale;
 }
+
+const glm::mat4& Transformable::CurrentWorldTransform() const {
+    if (world_transform_dirty_) {
+        UpdateWorldTransform();
+    }
+
+    return world_transform_;
+}
+
+void Transformable::UpdateWorldTransform() const {
+    auto parent = parent_.lock();
+    if (!parent) {
+        world_transform_ = local_transform_;
+    } else {
+        if (inherits_rotation_) {
+            world_transform_ = parent->CurrentWorldTransform() * local_transform_;
+        } else {
+            auto parent_transform = glm::translate(glm::mat4(), parent->WorldPosition());
+            parent_transform = glm::scale(parent_transform, parent->GetScale());
+            world_transform_ = parent_transform * local_transform_;
+        }
+    }
+
+    world_transform_dirty_ = false;
+}
+
+size_t Transformable::Depth() const {
+    size_t depth = 0;
+    for (auto parent = parent_.lock(); parent; parent = parent->parent_.lock()) {
+        depth++;
+    }
+
+    return depth;
+}
+
+std::vector<Transformable*> Transformable::registry_;
@@ -2,12 +2,20 @@
 
 #define GLM_FORCE_RADIANS
 #include <unordered_set>
+#include <vector>
 #include "gtc/matrix_transform.hpp"
+#include "transform_builder.h"
 
+/**
+ * World transforms are calculated lazily. Edits only mark this Transformable and its descendants dirty, and dirty world transforms
+ * are brought up to date either when they're read or all at once by UpdateAllWorldTransforms().
+ */
 class Transformable : public std::enable_shared_from_this<Transformable> {
    public:
     explicit Transformable(bool inherits_rotation = true);
     Transformable(const glm::vec3& position, bool inherits_rotation = true);
+    Transformable(const Transformable&) = delete;  // Every Transformable is registered by address for the batch update
+    Transformable& operator=(const Transformable&) = delete;
     virtual ~Transformable();
 
     void Rotate(float radians, const glm::vec3& around);
@@ -18,6 +26,7 @@ class Transformable : public std::enable_shared_from_this<Transformable> {
     void ApplyMatrix(const glm::mat4 matrix);
     void ResetAndSetTranslation(const glm::vec3& translation);
     void Set(const glm::mat4 new_local_transform);
+    void Set(const TransformBuilder& new_local_transform);  // Commits a whole batch of edits with one world recalculation
 
     void SetInheritsRotation(bool inherits_rotation);
 
@@ -25,15 +34,18 @@ class Transformable : public std::enable_shared_from_this<Transformable> {
     void RemoveChild(std::shared_ptr<Transformable> child);
     void ClearChildren();
     void SetParent(std::shared_ptr<Transformable> parent);
+    void SetParent(std::shared_ptr<Transformable> parent, const TransformBuilder& new_local_transform);
     void ClearParent();
     bool HasChild(std::shared_ptr<Transformable> child) const;
     bool IsParent(std::shared_ptr<Transformable> parent) const;
 
-    void RecalculateWorldTransform();
+    void InvalidateWorldTransform();
 
     void NotifyChildrenOfUpdate();
     static void NotifyChildOfUpdate(std::shared_ptr<Transformable> child);
 
+    static void UpdateAllWorldTransforms();  // Composes every dirty world transform with the batch kernels, one hierarchy level at a time
+
     glm::mat4 LocalTransform() const;
     glm::mat4 WorldTransform() const;
 
@@ -48,10 +60,18 @@ class Transformable : public std::enable_shared_from_this<Transformable> {
     void Reset();
     void ResetLocalTransform();
 
-    glm::mat4 local_transform_;  // This Transformable's local transformation
-    glm::mat4 world_transform_;  // This transform in world coordinates, with all parent transformations applied
+    const glm::mat4& CurrentWorldTransform() const;  // Recalculates the world transform first if it's dirty
+    void UpdateWorldTransform() const;
+    size_t Depth() const;
+
+    glm::mat4 local_transform_;          // This Transformable's local transformation
+    mutable glm::mat4 world_transform_;  // This transform in world coordinates, with all parent transformations applied
+    mutable bool world_transform_dirty_;  // If this is dirty, all descendants are too
     std::weak_ptr<Transformable> parent_;
     std::unordered_set<std::shared_ptr<Transformable>> children_;
 
     bool inherits_rotation_;  // It either inherits rotation, scale, and position, or only scale and position
+
+    size_t registry_index_;
+    static std::vector<Transformable*> registry_;
 };
@@ -0,0 +1,158 @@
+#include "constants.h"
+#include "frame_allocator.h"
+#include "game_object.h"
+#include "job_system.h"
+#include "overlap_kernels.h"
+#include "transformable.h"
+#include "trigger_system.h"
+
+TriggerSystem::TriggerSystem(Arena* arena)
+    : arena_(arena), bodies_(ArenaAllocator<Body>(arena)), body_bounds_(arena), triggers_(ArenaAllocator<Trigger>(arena)) {}
+
+void TriggerSystem::AddBody(GameObject* object, uint32_t categories) {
+    bodies_.push_back(Body{object, categories});
+    body_bounds_.Add(object->world_bounds);
+
+    for (Trigger& trigger : triggers_) {  // Anything it's already inside of should hear about it
+        if (trigger.category_mask & categories) trigger.dirty = true;
+    }
+}
+
+int TriggerSystem::AddTrigger(GameObject* object, uint32_t category_mask, TriggerListener* listener) {
+    int trigger = AddTrigger(object->world_bounds, category_mask, listener);
+    triggers_[trigger].object = object;
+    return trigger;
+}
+
+int TriggerSystem::AddTrigger(const BoundingBox& bounds, uint32_t category_mask, TriggerListener* listener) {
+    triggers_.push_back(
+        Trigger{nullptr, bounds, category_mask, listener, true, false, true, ArenaVector<int>(ArenaAllocator<int>(arena_))});
+    return static_cast<int>(triggers_.size()) - 1;
+}
+
+void TriggerSystem::MoveTrigger(int trigger, const BoundingBox& bounds) {
+    if (SameBounds(triggers_[trigger].bounds, bounds)) return;
+
+    triggers_[trigger].bounds = bounds;
+    triggers_[trigger].dirty = true;
+}
+
+void TriggerSystem::SetTriggerEnabled(int trigger, bool enabled) {
+    if (triggers_[trigger].enabled == enabled) return;
+
+    triggers_[trigger].enabled = enabled;
+    triggers_[trigger].dirty = true;
+}
+
+void TriggerSystem::SetTriggerPrecise(int trigger, bool precise) {
+    if (triggers_[trigger].precise == precise) return;
+
+    triggers_[trigger].precise = precise;
+    triggers_[trigger].dirty = true;
+}
+
+GameObject* TriggerSystem::FirstOverlap(int trigger, uint32_t categories) const {
+    for (int body : triggers_[trigger].overlaps) {
+        if (bodies_[body].categories & categories) return bodies_[body].object;
+    }
+
+    return nullptr;
+}
+
+void TriggerSystem::Update() {
+    uint32_t moved_categories = 0;
+    for (int i = 0; i < body_bounds_.Size(); i++) {
+        const BoundingBox& bounds = bodies_[i].object->world_bounds;
+        if (SameBounds(body_bounds_.Get(i), bounds)) continue;
+
+        body_bounds_.Set(i, bounds);
+        moved_categories |= bodies_[i].categories;
+    }
+
+    FrameVector<int> stale;
+    for (int i = 0; i < static_cast<int>(triggers_.size()); i++) {
+        Trigger& trigger = triggers_[i];
+        if (trigger.object != nullptr && !SameBounds(trigger.bounds, trigger.object->world_bounds)) {
+            trigger.bounds = trigger.object->world_bounds;
+            trigger.dirty = true;
+        }
+        // Nothing it cares about has changed, or it's off and already knows it overlaps nothing
+        if (!trigger.dirty && (!trigger.enabled || !(trigger.category_mask & moved_categories))) continue;
+        trigger.dirty = false;
+        stale.push_back(i);
+    }
+    if (stale.empty()) return;
+
+    // Finding a trigger's overlaps only reads the bodies, so the stale triggers are re-tested across threads once the mesh tests'
+    // world transforms are composed. Each gets its own stretch of one buffer, allocated here since scratch memory allocated in a
+    // job doesn't outlive it
+    Transformable::UpdateAllWorldTransforms();
+    int stride = body_bounds_.Size() + 1;
+    int stale_count = static_cast<int>(stale.size());
+    int* overlaps = static_cast<int*>(FrameAllocator::Allocate(sizeof(int) * stride * stale_count, alignof(int)));
+    int* counts = static_cast<int*>(FrameAllocator::Allocate(sizeof(int) * stale_count, alignof(int)));
+    JobSystem::ParallelFor("Trigger overlaps", stale_count, JOB_TRIGGERS_PER_CHUNK, [&](int begin, int end) {
+        for (int n = begin; n < end; n++) {
+            counts[n] = FindOverlaps(triggers_[stale[n]], overlaps + n * stride);
+        }
+    });
+
+    // The events go out here, in trigger order, so listeners run on this thread in the same order every time
+    for (int n = 0; n < stale_count; n++) {
+        UpdateTrigger(stale[n], overlaps + n * stride, counts[n]);
+    }
+}
+
+int TriggerSystem::FindOverlaps(const Trigger& trigger, int* overlaps) const {
+    if (!trigger.enabled) return 0;
+
+    int count = 0;
+    int found = OverlapKernels::CompactOverlaps(trigger.bounds, body_bounds_, overlaps);
+    for (int j = 0; j < found; j++) {  // Compacts in place, keeping the order
+        const Body& body = bodies_[overlaps[j]];
+        if (!(body.categories & trigger.category_mask) || body.object == trigger.object) continue;
+        if (trigger.precise && !MeshesTouch(trigger, body)) continue;
+        overlaps[count++] = overlaps[j];
+    }
+    return count;
+}
+
+bool TriggerSystem::SameBounds(const BoundingBox& a, const BoundingBox& b) {
+    return a.Min() == b.Min() && a.Max() == b.Max();
+}
+
+bool TriggerSystem::MeshesTouch(const Trigger& trigger, const Body& body) const {
+    if (trigger.object != nullptr) return trigger.object->MeshIntersects(*body.object);
+
+    return body.object->MeshIntersects(trigger.bounds);
+}
+
+void TriggerSystem::UpdateTrigger(int trigger, int* overlaps, int overlap_count) {
+    // Both lists are in increasing order, so one merge-like pass finds what's left and what's new
+    FrameVector<GameObject*> exited, entered;
+    const ArenaVector<int>& previous = triggers_[trigger].overlaps;
+    size_t p = 0;
+    int c = 0;
+    while (p < previous.size() || c < overlap_count) {
+        if (c == overlap_count || (p < previous.size() && previous[p] < overlaps[c])) {
+            exited.push_back(bodies_[previous[p++]].object);
+        } else if (p == previous.size() || overlaps[c] < previous[p]) {
+            entered.push_back(bodies_[overlaps[c++]].object);
+        } else {
+            p++;
+            c++;
+        }
+    }
+
+    if (exited.empty() && entered.empty()) return;
+
+    // Recorded before the events go out, so listeners that call FirstOverlap() see the new state
+    triggers_[trigger].overlaps.assign(overlaps, overlaps + overlap_count);
+    TriggerListener* listener = triggers_[trigger].listener;
+    for (GameObject* object : exited) {
+        listener->OnTriggerExit(object);
+    }
+    for (GameObject* object : entered) {
+        listener->OnTriggerEnter(object);
+    }
+}
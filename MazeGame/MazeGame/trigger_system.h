@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include "arena.h"
+#include "bounding_box.h"
+#include "bounds_soa.h"
+
+class GameObject;
+
+// Told when something starts or stops overlapping one of its trigger volumes
+class TriggerListener {
+   public:
+    TriggerListener() = default;
+    virtual ~TriggerListener() = default;
+
+    virtual void OnTriggerEnter(GameObject* other) = 0;
+    virtual void OnTriggerExit(GameObject* other) {}
+};
+
+/**
+ * Trigger volumes that report overlaps as enter and exit events, rather than everyone polling the broadphase every step.
+ * Bodies are the objects triggers can detect, and each trigger has a mask of the categories it cares about. Update() only
+ * re-tests a trigger when it moved or a body it cares about did, so idle triggers cost nothing. Those that do get tested check
+ * every body at once with OverlapKernels, on the job system when there are enough of them.
+ */
+class TriggerSystem {
+   public:
+    explicit TriggerSystem(Arena* arena);
+
+    // Bodies and triggers given an object follow its world_bounds. Returns the trigger's id, starting from 0
+    void AddBody(GameObject* object, uint32_t categories);
+    int AddTrigger(GameObject* object, uint32_t category_mask, TriggerListener* listener);
+    int AddTrigger(const BoundingBox& bounds, uint32_t category_mask, TriggerListener* listener);
+
+    void MoveTrigger(int trigger, const BoundingBox& bounds);  // Only for triggers that don't follow an object
+    void SetTriggerEnabled(int trigger, bool enabled);          // A disabled trigger overlaps nothing, so disabling it sends exits
+    // A precise trigger only counts a body once their meshes touch, through GameObject::MeshIntersects(), rather than as soon as
+    // their boxes do. The mesh test only runs for bodies whose boxes already overlap
+    void SetTriggerPrecise(int trigger, bool precise);
+    GameObject* FirstOverlap(int trigger, uint32_t categories) const;  // As of the last Update(), or nullptr
+
+    // Brings every body's bounds up to date, then sends the events for each trigger whose overlaps changed. Listeners may move
+    // and enable triggers, but not add them. Those changes are tested on the next Update()
+    void Update();
+
+   private:
+    struct Body {
+        GameObject* object;
+        uint32_t categories;
+    };
+
+    struct Trigger {
+        GameObject* object;  // Or nullptr for triggers that are moved by hand
+        BoundingBox bounds;
+        uint32_t category_mask;
+        TriggerListener* listener;
+        bool enabled;
+        bool precise;
+        bool dirty;                // Moved or enabled since the last Update()
+        ArenaVector<int> overlaps;  // Body indices, in increasing order
+    };
+
+    static bool SameBounds(const BoundingBox& a, const BoundingBox& b);
+    int FindOverlaps(const Trigger& trigger, int* overlaps) const;  // Fills overlaps with body indices, in order. Returns how many
+    bool MeshesTouch(const Trigger& trigger, const Body& body) const;
+    void UpdateTrigger(int trigger, int* overlaps, int overlap_count);
+
+    Arena* arena_;
+    ArenaVector<Body> bodies_;
+    BoundsSoA body_bounds_;
+    ArenaVector<Trigger> triggers_;
+};
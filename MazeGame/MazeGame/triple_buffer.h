@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Hands values from one producer thread to one consumer thread without either of them ever waiting. The producer fills
+ * WriteBuffer() and calls Publish(), the consumer calls Consume() and reads ReadBuffer(). Each side owns one of the three
+ * buffers and the third sits in between, so a slow consumer just skips values rather than holding up the producer.
+ * Buffers are reused rather than cleared, so a T that holds vectors only reallocates when it outgrows them.
+ */
+template <typename T>
+class TripleBuffer {
+   public:
+    TripleBuffer() : write_(0), read_(1), middle_(2) {}
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side
+    T& WriteBuffer() {
+        return buffers_[write_];
+    }
+
+    void Publish() {
+        // Release makes the writes to the buffer visible before its index, acquire takes ownership of whatever the consumer left
+        uint8_t previous = middle_.exchange(static_cast<uint8_t>(write_ | FRESH), std::memory_order_acq_rel);
+        write_ = previous & INDEX_MASK;
+    }
+
+    // Consumer side. Returns false, leaving ReadBuffer() as it was, if nothing's been published since the last call
+    bool Consume() {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH)) return false;
+
+        uint8_t previous = middle_.exchange(read_, std::memory_order_acq_rel);
+        read_ = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& ReadBuffer() const {
+        return buffers_[read_];
+    }
+
+   private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH = 0x4;  // Set on the middle index when it holds a value the consumer hasn't seen
+
+    T buffers_[3];
+    uint8_t write_;  // Only touched by the producer
+    uint8_t read_;   // Only touched by the consumer
+    std::atomic<uint8_t> middle_;
+};
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+#include "overlap_kernels.h"
+#include "uniform_grid.h"
+
+UniformGrid::UniformGrid(Arena* arena, const glm::vec2& origin, float cell_size, int width, int height)
+    : origin_(origin),
+      cell_size_(cell_size),
+      width_(std::max(width, 1)),
+      height_(std::max(height, 1)),
+      proxies_(ArenaAllocator<Proxy>(arena)),
+      bounds_(arena),
+      cells_(ArenaAllocator<ArenaVector<int>>(arena)),
+      query_stamp_(0) {
+    cells_.reserve(width_ * height_);
+    for (int i = 0; i < width_ * height_; i++) {
+        cells_.emplace_back(ArenaAllocator<int>(arena));
+    }
+}
+
+int UniformGrid::Insert(const BoundingBox& bounds, uint32_t categories) {
+    Proxy proxy;
+    proxy.categories = categories;
+    proxy.query_stamp = query_stamp_;
+    proxy.cells = CellsCovering(bounds);
+    proxies_.push_back(proxy);
+    bounds_.Add(bounds);
+
+    int id = static_cast<int>(proxies_.size()) - 1;
+    AddToCells(id, proxy.cells);
+    return id;
+}
+
+void UniformGrid::Update(int proxy, const BoundingBox& bounds) {
+    Proxy& updated = proxies_[proxy];
+    bounds_.Set(proxy, bounds);
+
+    CellRange cells = CellsCovering(bounds);
+    if (cells == updated.cells) return;  // The common case: it moved, but not into a different set of cells
+
+    RemoveFromCells(proxy, updated.cells);
+    AddToCells(proxy, cells);
+    updated.cells = cells;
+}
+
+void UniformGrid::FindPairs(uint32_t dynamic_mask, FrameVector<std::pair<int, int>>& pairs) const {
+    // Only a handful of proxies move, so testing each of them against every box at once beats walking all the cells
+    FrameVector<int> overlaps(bounds_.Size());
+    for (int proxy = 0; proxy < static_cast<int>(proxies_.size()); proxy++) {
+        if (!(proxies_[proxy].categories & dynamic_mask)) continue;
+
+        int count = OverlapKernels::CompactOverlaps(bounds_.Get(proxy), bounds_, overlaps.data());
+        for (int i = 0; i < count; i++) {
+            int other = overlaps[i];
+            if (other == proxy) continue;
+            if ((proxies_[other].categories & dynamic_mask) && other < proxy) continue;  // Already reported from the other side
+
+            pairs.push_back(std::make_pair(std::min(proxy, other), std::max(proxy, other)));
+        }
+    }
+}
+
+BoundingBox UniformGrid::Bounds(int proxy) const {
+    return bounds_.Get(proxy);
+}
+
+glm::ivec2 UniformGrid::CellAt(const glm::vec3& position) const {
+    return glm::ivec2(CellCoordinate(position.x, origin_.x, width_), CellCoordinate(position.y, origin_.y, height_));
+}
+
+UniformGrid::CellRange UniformGrid::CellsCovering(const BoundingBox& bounds) const {
+    if (bounds.IsEmpty()) return CellRange{0, 0, 0, 0};
+
+    CellRange range;
+    range.min_x = CellCoordinate(bounds.Min().x, origin_.x, width_);
+    range.min_y = CellCoordinate(bounds.Min().y, origin_.y, height_);
+    range.max_x = CellCoordinate(bounds.Max().x, origin_.x, width_);
+    range.max_y = CellCoordinate(bounds.Max().y, origin_.y, height_);
+    return range;
+}
+
+int UniformGrid::CellCoordinate(float position, float origin, int size) const {
+    float cell = std::floor((position - origin) / cell_size_);
+    return static_cast<int>(std::min(std::max(cell, 0.0f), static_cast<float>(size - 1)));  // Clamped before the cast can overflow
+}
+
+void UniformGrid::AddToCells(int proxy, const CellRange& cells) {
+    for (int y = cells.min_y; y <= cells.max_y; y++) {
+        for (int x = cells.min_x; x <= cells.max_x; x++) {
+            cells_[y * width_ + x].push_back(proxy);
+        }
+    }
+}
+
+void UniformGrid::RemoveFromCells(int proxy, const CellRange& cells) {
+    for (int y = cells.min_y; y <= cells.max_y; y++) {
+        for (int x = cells.min_x; x <= cells.max_x; x++) {
+            ArenaVector<int>& cell = cells_[y * width_ + x];
+            auto found = std::find(cell.begin(), cell.end(), proxy);
+            if (found != cell.end()) {
+                *found = cell.back();  // Order within a cell doesn't matter
+                cell.pop_back();
+            }
+        }
+    }
+}
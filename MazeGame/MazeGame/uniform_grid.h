@@ -0,0 +1,161 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include "arena.h"
+#include "bounding_box.h"
+#include "bounds_soa.h"
+#include "frame_allocator.h"
+#include "glm.hpp"
+
+/**
+ * Broadphase over the XY plane, since the maze is one story tall. Each proxy is a world-space AABB tagged with category bits,
+ * listed in every cell it covers. Proxies whose bounds change only touch the cell lists when the range of cells they cover
+ * changes. Objects outside the grid are clamped into its edge cells, so they're still found, just less efficiently. Proxy bounds
+ * are kept in a BoundsSoA, so finding pairs tests each dynamic proxy against all of them with OverlapKernels.
+ */
+class UniformGrid {
+   public:
+    UniformGrid(Arena* arena, const glm::vec2& origin, float cell_size, int width, int height);
+
+    int Insert(const BoundingBox& bounds, uint32_t categories);  // Proxy ids count up from 0
+    void Update(int proxy, const BoundingBox& bounds);
+
+    // Calls callback(proxy) once for every proxy in any of the categories whose AABB overlaps bounds, until the callback returns
+    // true. Returns whether it stopped early
+    template <typename Callback>
+    bool Query(const BoundingBox& bounds, uint32_t category_mask, Callback callback);
+
+    // Walks the cells a ray passes through in order (2D DDA, since the grid is flat) and calls callback(proxy) once for every
+    // proxy in any of the categories listed in them. callback returns how far along the ray it hits the proxy, or a negative
+    // number if it misses. Stops as soon as no later cell can hold anything closer, and returns the nearest proxy hit, or -1,
+    // with its distance in hit_distance. Distances are in multiples of direction's length, and only the part of the ray over
+    // the grid is walked
+    template <typename Callback>
+    int RayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, uint32_t category_mask, float* hit_distance,
+                Callback callback);
+
+    // Every overlapping pair with at least one proxy in dynamic_mask, each reported once, with the lower proxy id first
+    void FindPairs(uint32_t dynamic_mask, FrameVector<std::pair<int, int>>& pairs) const;
+
+    BoundingBox Bounds(int proxy) const;
+    glm::ivec2 CellAt(const glm::vec3& position) const;  // Clamped into the grid
+
+   private:
+    struct CellRange {
+        int min_x, min_y, max_x, max_y;
+
+        bool operator==(const CellRange& other) const {
+            return min_x == other.min_x && min_y == other.min_y && max_x == other.max_x && max_y == other.max_y;
+        }
+    };
+
+    struct Proxy {
+        uint32_t categories;
+        uint32_t query_stamp;  // The last query that visited this proxy, so ones spanning several cells are only reported once
+        CellRange cells;
+    };
+
+    CellRange CellsCovering(const BoundingBox& bounds) const;
+    int CellCoordinate(float position, float origin, int size) const;
+    void AddToCells(int proxy, const CellRange& cells);
+    void RemoveFromCells(int proxy, const CellRange& cells);
+
+    glm::vec2 origin_;
+    float cell_size_;
+    int width_, height_;
+    ArenaVector<Proxy> proxies_;
+    BoundsSoA bounds_;  // Indexed by proxy id
+    ArenaVector<ArenaVector<int>> cells_;  // Row-major, indexed by y * width_ + x
+    uint32_t query_stamp_;
+};
+
+template <typename Callback>
+bool UniformGrid::Query(const BoundingBox& bounds, uint32_t category_mask, Callback callback) {
+    query_stamp_++;
+    CellRange range = CellsCovering(bounds);
+    for (int y = range.min_y; y <= range.max_y; y++) {
+        for (int x = range.min_x; x <= range.max_x; x++) {
+            for (int proxy : cells_[y * width_ + x]) {
+                Proxy& candidate = proxies_[proxy];
+                if (candidate.query_stamp == query_stamp_ || !(candidate.categories & category_mask)) continue;
+
+                candidate.query_stamp = query_stamp_;
+                if (bounds_.Overlaps(proxy, bounds) && callback(proxy)) return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+template <typename Callback>
+int UniformGrid::RayCast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, uint32_t category_mask,
+                         float* hit_distance, Callback callback) {
+    // In cell units, so cell boundaries fall on whole numbers
+    float start[2] = {(origin.x - origin_.x) / cell_size_, (origin.y - origin_.y) / cell_size_};
+    float step[2] = {direction.x / cell_size_, direction.y / cell_size_};
+    int size[2] = {width_, height_};
+
+    // Clip the ray to the grid, so the walk starts at the first cell it actually passes through
+    float enter = 0, leave = max_distance;
+    for (int axis = 0; axis < 2; axis++) {
+        if (step[axis] == 0) {
+            if (start[axis] < 0 || start[axis] > size[axis]) return -1;
+            continue;
+        }
+
+        float to_low = -start[axis] / step[axis];
+        float to_high = (size[axis] - start[axis]) / step[axis];
+        enter = std::max(enter, std::min(to_low, to_high));
+        leave = std::min(leave, std::max(to_low, to_high));
+    }
+    if (enter > leave) return -1;
+
+    // Amanatides-Woo: next_boundary is the distance to the next cell boundary on each axis, and boundary_spacing how far apart
+    // they are along the ray
+    int cell[2], cell_step[2];
+    float next_boundary[2], boundary_spacing[2];
+    for (int axis = 0; axis < 2; axis++) {
+        float entry_point = start[axis] + step[axis] * enter;
+        cell[axis] = std::min(std::max(static_cast<int>(std::floor(entry_point)), 0), size[axis] - 1);
+        if (step[axis] == 0) {
+            cell_step[axis] = 0;
+            next_boundary[axis] = boundary_spacing[axis] = INFINITY;
+        } else {
+            cell_step[axis] = step[axis] > 0 ? 1 : -1;
+            float boundary = static_cast<float>(step[axis] > 0 ? cell[axis] + 1 : cell[axis]);
+            next_boundary[axis] = (boundary - start[axis]) / step[axis];
+            boundary_spacing[axis] = std::abs(1.0f / step[axis]);
+        }
+    }
+
+    query_stamp_++;
+    int nearest = -1;
+    float nearest_distance = max_distance;
+    while (true) {
+        for (int proxy : cells_[cell[1] * width_ + cell[0]]) {
+            Proxy& candidate = proxies_[proxy];
+            if (candidate.query_stamp == query_stamp_ || !(candidate.categories & category_mask)) continue;
+
+            candidate.query_stamp = query_stamp_;
+            float distance = callback(proxy);
+            if (distance >= 0 && distance <= nearest_distance) {
+                nearest_distance = distance;
+                nearest = proxy;
+            }
+        }
+
+        int axis = next_boundary[0] < next_boundary[1] ? 0 : 1;
+        float cell_exit = next_boundary[axis];
+        if (cell_exit > leave || (nearest != -1 && nearest_distance <= cell_exit)) break;  // Later cells can't beat the hit
+
+        cell[axis] += cell_step[axis];
+        next_boundary[axis] += boundary_spacing[axis];
+        if (cell[axis] < 0 || cell[axis] >= size[axis]) break;
+    }
+
+    if (nearest != -1 && hit_distance != nullptr) *hit_distance = nearest_distance;
+    return nearest;
+}
@@ -4,5 +4,7 @@ class Updatable {
     Updatable() = default;
     virtual ~Updatable() = default;
 
-    virtual void Update() = 0;
+    // Advances game logic by dt seconds. Called once per step, or once every few steps with a longer dt for objects the
+    // SimulationScheduler slows down, and never while drawing
+    virtual void Simulate(float dt) = 0;
 };
@@ -10,11 +10,6 @@ using glm::vec3;
 using glm::vec4;
 
 VRCamera::VRCamera(float near_clip, float far_clip, vr::IVRSystem* vr_system) : near_clip_(near_clip), far_clip_(far_clip) {
-    if (vr_system == nullptr) {
-        printf("VRCamera cannot initialize with a null vr_system. Exiting...");
-        exit(-1);
-    }
-
     vr_system_ = vr_system;
 
     tracking_center_ = std::make_shared<Transformable>();
@@ -25,13 +20,18 @@ VRCamera::VRCamera(float near_clip, float far_clip, vr::IVRSystem* vr_system) :
 VRCamera::~VRCamera() {}
 
 void VRCamera::Setup() {
+    if (vr_system_ == nullptr) {
+        printf("VRCamera cannot set up without a vr_system. Exiting...");
+        exit(-1);
+    }
+
     projection_left = GetEyeProjection(vr::Eye_Left);
     projection_right = GetEyeProjection(vr::Eye_Right);
     eye_offset_left = GetEyeOffset(vr::Eye_Left);
     eye_offset_right = GetEyeOffset(vr::Eye_Right);
 }
 
-glm::mat4 VRCamera::GetCurrentWorldToViewMatrix(vr::Hmd_Eye eye) {
+glm::mat4 VRCamera::GetWorldToViewMatrix(vr::Hmd_Eye eye, const mat4& hmd_pose, const mat4& tracking_center) const {
     mat4 matMVP;
     if (eye == vr::Eye_Left) {
         matMVP = projection_left * eye_offset_left;
@@ -39,14 +39,18 @@ glm::mat4 VRCamera::GetCurrentWorldToViewMatrix(vr::Hmd_Eye eye) {
         matMVP = projection_right * eye_offset_right;
     }
 
-    matMVP = matMVP * glm::inverse(current_pose_);
+    matMVP = matMVP * glm::inverse(hmd_pose);
     matMVP = matMVP * world_to_openvr;  // Rotate and scale world to convert to OpenVR coordinates
 
-    matMVP = matMVP * glm::inverse(tracking_center_->WorldTransform());  // Kind of an addition for world to camera
+    matMVP = matMVP * glm::inverse(tracking_center);  // Kind of an addition for world to camera
 
     return matMVP;
 }
 
+glm::mat4 VRCamera::TrackingCenterTransform() const {
+    return tracking_center_->WorldTransform();
+}
+
 void VRCamera::SetCurrentPose(mat4 new_hmd_pose) {
     // printf("HMD Pose: %f, %f, %f\n", new_hmd_pose[3][0], new_hmd_pose[3][1], new_hmd_pose[3][2]);
     // printf("HMD Offset: %f, %f, %f\n", pos.x, pos.y, pos.z);
@@ -67,10 +71,17 @@ void VRCamera::SetPosition(vec3 position) {
 }
 
 void VRCamera::Translate(float right, float absolute_up, float forward) {
-    vec3 translation = right * HorizontalRight() + absolute_up * vec3(0, 0, 1) + forward * HorizontalForward();
+    Translate(HorizontalDisplacement(right, forward) + absolute_up * vec3(0, 0, 1));
+}
+
+void VRCamera::Translate(const vec3& translation) {
     tracking_center_->Translate(translation);
 }
 
+vec3 VRCamera::HorizontalDisplacement(float right, float forward) {
+    return right * HorizontalRight() + forward * HorizontalForward();
+}
+
 vec3 VRCamera::GetNormalizedLookPosition() {
     return HorizontalForward();
 }
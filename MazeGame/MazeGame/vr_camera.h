@@ -7,17 +7,21 @@
 
 class VRCamera {
    public:
-    VRCamera(float near_clip, float far_clip, vr::IVRSystem* vr_system);
+    VRCamera(float near_clip, float far_clip, vr::IVRSystem* vr_system);  // vr_system may be null for a headless replay, which never draws
     ~VRCamera();
 
     void Setup();
-    glm::mat4 GetCurrentWorldToViewMatrix(vr::Hmd_Eye eye);
+    // Takes the pose and tracking center rather than using the camera's own, since the render thread draws from a snapshot
+    glm::mat4 GetWorldToViewMatrix(vr::Hmd_Eye eye, const glm::mat4& hmd_pose, const glm::mat4& tracking_center) const;
+    glm::mat4 TrackingCenterTransform() const;
     void SetCurrentPose(glm::mat4 new_hmd_pose);
 
     void MakeChildOfHeadset(std::shared_ptr<Transformable> child);
     void MakeChildOfTrackingCenter(std::shared_ptr<Transformable> child);
     void SetPosition(glm::vec3 position);
     void Translate(float right, float absolute_up, float forward);
+    void Translate(const glm::vec3& translation);
+    glm::vec3 HorizontalDisplacement(float right, float forward);  // The world-space move for right and forward, relative to the HMD
     glm::vec3 GetNormalizedLookPosition();
 
    private:
@@ -6,6 +6,7 @@
 #include <gtc/type_ptr.hpp>
 #include <iostream>
 #include "constants.h"
+#include "gl_state.h"
 #include "gtx/rotate_vector.hpp"
 #include "shader_manager.h"
 #include "vr_camera.h"
@@ -53,16 +54,20 @@ void VRInputManager::Init() {
     vr::VRInput()->GetActionHandle("/actions/game/in/grab_right", &hands_[Right].action_grab);
 
     vr::VRInput()->GetActionSetHandle("/actions/game", &action_set_);
+}
 
+void VRInputManager::SetMap(Map* map) {
     for (Controller& controller : hands_) {
-        controller.input_manager = this;
+        controller.SetMap(map);
     }
+
+    map_ = map;
 }
 
-bool VRInputManager::HandleInput() {
+void VRInputManager::PollInput(TickInput* input) {
     if (vr_system_ == nullptr) {
         printf("Tried to handle input for uninitialized VR!");
-        return false;
+        return;
     }
 
     // Process SteamVR events
@@ -80,97 +85,135 @@ bool VRInputManager::HandleInput() {
 
     // Check for shader mode
     vr::InputDigitalActionData_t digital_action_data;
-    if (GetDigitalActionDataEdge(action_shader_mode, digital_action_data)) {
-        if (digital_action_data.bState) {  // Just pressed
-            GLint current_mode;
-            glGetUniformiv(ShaderManager::Textured_Shader, ShaderManager::Attributes.shaderMode, &current_mode);
-
-            current_mode = ((GLint)current_mode + 1) % NUM_SHADER_MODES;
-            glUseProgram(ShaderManager::Textured_Shader);
-            glUniform1i(ShaderManager::Attributes.shaderMode, current_mode);
-            glUseProgram(0);
-        }
-    }
+    input->shader_mode_pressed = GetDigitalActionDataEdge(action_shader_mode, digital_action_data) && digital_action_data.bState;
 
     // Movement inputs
     vr::InputAnalogActionData_t analog_action_data;
     vr::VRInput()->GetAnalogActionData(action_movement, &analog_action_data, sizeof(vr::InputAnalogActionData_t),
                                        vr::k_ulInvalidInputValueHandle);
-    if (analog_action_data.bActive && analog_action_data.x != 0 && analog_action_data.y != 0) {
-        // printf("Axis: %f, %f\n", analog_action_data.x, analog_action_data.y);
-        map_->GetPlayer()->Move(analog_action_data.y, analog_action_data.x, CAMERA_MOVE_SPEED * VR_MOVE_SPEED_FACTOR);
+    input->thumbstick_forward = analog_action_data.bActive ? analog_action_data.y : 0.0f;
+    input->thumbstick_right = analog_action_data.bActive ? analog_action_data.x : 0.0f;
+
+    for (Hand eHand = Left; eHand <= Right; ((int&)eHand)++) {
+        hands_[eHand].PollInput(&input->hands[eHand]);
+    }
+}
+
+void VRInputManager::ApplyInput(const TickInput& input) {
+    if (input.shader_mode_pressed) {
+        shader_mode_ = (shader_mode_ + 1) % NUM_SHADER_MODES;
     }
 
+    // The player moves by it each simulation step, so the speed doesn't depend on how often this runs
+    map_->GetPlayer()->SetThumbstickInput(input.thumbstick_forward, input.thumbstick_right);
+
     // Tell each hand to handle its own input
     for (Hand eHand = Left; eHand <= Right; ((int&)eHand)++) {
-        hands_[eHand].HandleInput();
+        hands_[eHand].ApplyInput(input.hands[eHand]);
     }
+}
 
-    return false;
+int VRInputManager::ShaderMode() const {
+    return shader_mode_;
 }
 
-void VRInputManager::RenderControllers(const glm::mat4& worldViewMatrix) const {
+void VRInputManager::ExtractControllers(ControllerSnapshot hands[2]) const {
     for (Hand eHand = Left; eHand <= Right; ((int&)eHand)++) {
-        hands_[eHand].Render(worldViewMatrix);
+        hands_[eHand].Extract(&hands[eHand]);
+    }
+}
+
+void VRInputManager::RenderControllers(const ControllerSnapshot hands[2], const glm::mat4& worldViewMatrix) {
+    GLState::UseProgram(ShaderManager::RenderModel_Shader);
+    GLint matrix_location = glGetUniformLocation(ShaderManager::RenderModel_Shader, "matrix");
+
+    for (Hand eHand = Left; eHand <= Right; ((int&)eHand)++) {
+        const ControllerSnapshot& hand = hands[eHand];
+        if (!hand.visible) continue;
+
+        if (hand_model_names_[eHand] != hand.render_model_name || !hand_models_[eHand]) {  // Or it may have finished loading
+            hand_models_[eHand] = FindOrLoadRenderModel(hand.render_model_name.c_str());
+            hand_model_names_[eHand] = hand.render_model_name;
+        }
+        RenderModel* render_model = hand_models_[eHand];
+        if (!render_model) continue;
 
-        /*printf("Rendermodel at location %f, %f, %f\n", hands_[eHand].pose[3][0], hands_[eHand].pose[3][1],
-               hands_[eHand].pose[3][2]);*/
+        glm::mat4 matMVP = worldViewMatrix * hand.world_transform;
+        glUniformMatrix4fv(matrix_location, 1, GL_FALSE, glm::value_ptr(matMVP));
+        render_model->Draw();
     }
 }
 
 RenderModel* VRInputManager::FindOrLoadRenderModel(const char* render_model_name) {
-    RenderModel* pRenderModel = NULL;
     for (RenderModel* i : render_models_) {
-        if (!_stricmp(i->GetName().c_str(), render_model_name)) {
-            pRenderModel = i;
-            break;
-        }
+        if (!_stricmp(i->GetName().c_str(), render_model_name)) return i;
+    }
+    for (RenderModelLoad* load : render_model_loads_) {
+        if (!_stricmp(load->name.c_str(), render_model_name)) return NULL;  // Still loading, or it failed
     }
 
     // load the model if we didn't find one
-    if (!pRenderModel) {
-        vr::RenderModel_t* pModel;
-        vr::EVRRenderModelError error;
-        while (1) {
-            error = vr::VRRenderModels()->LoadRenderModel_Async(render_model_name, &pModel);
-            if (error != vr::VRRenderModelError_Loading) break;
-
-            ThreadSleep(1);
-        }
+    RenderModelLoad* load = new RenderModelLoad();
+    render_model_loads_.push_back(load);
+    load->manager = this;
+    load->name = render_model_name;
+    JobSystem::Run(Job{&LoadModelJob, load, 0, 1, "Render model load", &load->model_loaded});
+    JobSystem::RunAfter(Job{&LoadTextureJob, load, 0, 1, "Render model texture load", nullptr}, &load->model_loaded);
+    return NULL;
+}
 
-        if (error != vr::VRRenderModelError_None) {
-            printf("Unable to load render model %s - %s\n", render_model_name,
-                   vr::VRRenderModels()->GetRenderModelErrorNameFromEnum(error));
-            return NULL;  // move on to the next tracked device
-        }
+void VRInputManager::LoadModelJob(void* data, int begin, int end) {
+    RenderModelLoad* load = static_cast<RenderModelLoad*>(data);
+    vr::EVRRenderModelError error;
+    while (1) {
+        error = vr::VRRenderModels()->LoadRenderModel_Async(load->name.c_str(), &load->model);
+        if (error != vr::VRRenderModelError_Loading) break;
 
-        vr::RenderModel_TextureMap_t* pTexture;
-        while (1) {
-            error = vr::VRRenderModels()->LoadTexture_Async(pModel->diffuseTextureId, &pTexture);
-            if (error != vr::VRRenderModelError_Loading) break;
+        ThreadSleep(1);
+    }
 
-            ThreadSleep(1);
-        }
+    if (error != vr::VRRenderModelError_None) {
+        printf("Unable to load render model %s - %s\n", load->name.c_str(),
+               vr::VRRenderModels()->GetRenderModelErrorNameFromEnum(error));
+        load->model = nullptr;
+    }
+}
 
-        if (error != vr::VRRenderModelError_None) {
-            printf("Unable to load render texture id:%d for render model %s\n", pModel->diffuseTextureId, render_model_name);
-            vr::VRRenderModels()->FreeRenderModel(pModel);
-            return NULL;  // move on to the next tracked device
-        }
+void VRInputManager::LoadTextureJob(void* data, int begin, int end) {
+    RenderModelLoad* load = static_cast<RenderModelLoad*>(data);
+    if (load->model == nullptr) return;
 
-        pRenderModel = new RenderModel(render_model_name);
-        if (!pRenderModel->Init(*pModel, *pTexture)) {
-            printf("Unable to create GL model from render model %s\n", render_model_name);
-            delete pRenderModel;
-            pRenderModel = NULL;
-        } else {
-            render_models_.push_back(pRenderModel);
-        }
-        vr::VRRenderModels()->FreeRenderModel(pModel);
-        vr::VRRenderModels()->FreeTexture(pTexture);
+    vr::EVRRenderModelError error;
+    while (1) {
+        error = vr::VRRenderModels()->LoadTexture_Async(load->model->diffuseTextureId, &load->texture);
+        if (error != vr::VRRenderModelError_Loading) break;
+
+        ThreadSleep(1);
+    }
+
+    if (error != vr::VRRenderModelError_None) {
+        printf("Unable to load render texture id:%d for render model %s\n", load->model->diffuseTextureId, load->name.c_str());
+        vr::VRRenderModels()->FreeRenderModel(load->model);
+        load->model = nullptr;
+        return;
     }
 
-    return pRenderModel;
+    JobSystem::RunOnMainThread(Job{&UploadRenderModelJob, load, 0, 1, "Render model upload", nullptr});
+}
+
+void VRInputManager::UploadRenderModelJob(void* data, int begin, int end) {
+    RenderModelLoad* load = static_cast<RenderModelLoad*>(data);
+    RenderModel* pRenderModel = new RenderModel(load->name);
+    if (!pRenderModel->Init(*load->model, *load->texture)) {
+        printf("Unable to create GL model from render model %s\n", load->name.c_str());
+        delete pRenderModel;
+    } else {
+        load->manager->render_models_.push_back(pRenderModel);
+    }
+    vr::VRRenderModels()->FreeRenderModel(load->model);
+    vr::VRRenderModels()->FreeTexture(load->texture);
+    load->model = nullptr;
+    load->texture = nullptr;
 }
 
 bool VRInputManager::GetDigitalActionDataEdge(vr::VRActionHandle_t action, vr::InputDigitalActionData_t& action_data,
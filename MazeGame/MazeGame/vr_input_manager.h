@@ -2,12 +2,24 @@
 #include <vector>
 #include "controller.h"
 #include "glm.hpp"
+#include "job_system.h"
 #include "map.h"
 #include "render_model.h"
 #include "transformable.h"
 
 class VRCamera;
 
+// Everything from outside the game the simulation reads in a tick. Ticks given the same inputs (and the same number of steps)
+// always end in the same state, which is what lets a recording of them be played back
+struct TickInput {
+    glm::mat4 hmd_pose;
+    bool hmd_pose_valid = false;
+    float keyboard_forward = 0.0f, keyboard_right = 0.0f;      // Each in [-1, 1]
+    float thumbstick_forward = 0.0f, thumbstick_right = 0.0f;  // Likewise
+    bool shader_mode_pressed = false;
+    HandInput hands[2];
+};
+
 class VRInputManager {
    public:
     VRInputManager();
@@ -15,9 +27,16 @@ class VRInputManager {
     ~VRInputManager();
 
     void Init();  // Sets up action handles
-    bool HandleInput();
-    void RenderControllers(const glm::mat4 &worldViewMatrix) const;
+    void SetMap(Map *map);  // Also makes the hands let go of anything from the previous map, and gives them grab triggers in this one
+    // Simulation thread only. PollInput() fills in what comes from OpenVR, leaving the HMD pose and keyboard as they are
+    void PollInput(TickInput *input);
+    void ApplyInput(const TickInput &input);
+    int ShaderMode() const;  // Cycled by the shader mode action. The render thread applies it, since that needs the GL context
+    void ExtractControllers(ControllerSnapshot hands[2]) const;
 
+    // Render thread only, like everything else that touches GL
+    void RenderControllers(const ControllerSnapshot hands[2], const glm::mat4 &worldViewMatrix);
+    // Null until the model has loaded, which happens off this thread the first time it's asked for, or if it couldn't be
     RenderModel *FindOrLoadRenderModel(const char *render_model_name);
 
     // Given an action it returns the action data, and sets the device source if relevant
@@ -28,6 +47,20 @@ class VRInputManager {
     Map *map_;
 
    private:
+    // A render model on its way in. OpenVR's loads can only be polled until they finish, so they wait on workers, and just the GL
+    // upload at the end comes back to the main thread
+    struct RenderModelLoad {
+        VRInputManager *manager;
+        std::string name;
+        vr::RenderModel_t *model = nullptr;
+        vr::RenderModel_TextureMap_t *texture = nullptr;
+        JobCounter model_loaded;  // The texture's id comes from the model, so its load waits on this
+    };
+
+    static void LoadModelJob(void *data, int begin, int end);
+    static void LoadTextureJob(void *data, int begin, int end);
+    static void UploadRenderModelJob(void *data, int begin, int end);  // On the main thread
+
     void ProcessVREvent(const vr::VREvent_t &event);
 
     Controller hands_[2];
@@ -35,5 +68,9 @@ class VRInputManager {
     vr::VRActionHandle_t action_movement = vr::k_ulInvalidActionHandle;
     vr::VRActionHandle_t action_shader_mode = vr::k_ulInvalidActionHandle;
     vr::IVRSystem *vr_system_;
+    int shader_mode_ = 0;
     std::vector<RenderModel *> render_models_;
+    std::vector<RenderModelLoad *> render_model_loads_;  // Every one started, so a model is only ever loaded once
+    RenderModel *hand_models_[2] = {nullptr, nullptr};  // Looked up again when a hand's model name changes, or until it's loaded
+    std::string hand_model_names_[2];
 };
@@ -8,6 +8,7 @@
 
 #include <stdio.h>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include "glad.h"
 
@@ -15,10 +16,17 @@
 
 #include <gtc/type_ptr.hpp>
 #include "bounding_box.h"
+#include "constants.h"
+#include "gl_state.h"
+#include "input_recording.h"
+#include "job_system.h"
 #include "map_loader.h"
 #include "model_manager.h"
+#include "overlap_kernels.h"
+#include "scene_renderer.h"
 #include "shader_manager.h"
 #include "texture_manager.h"
+#include "transform_kernels.h"
 const char *INSTRUCTIONS =
     "***************\n"
     "This is a game made by Jackson Kruger for CSCI 5607 at the University of Minnesota.\n"
@@ -28,6 +36,7 @@ const char *INSTRUCTIONS =
     "Space - Player jump\n"
     "Left ctrl - Player crouch\n"
     "g - Drop key\n"
+    "Tab - Switch between map1.txt and map2.txt\n"
     "Esc - Quit\n"
     "F11 - Fullscreen\n"
     "***************\n";
@@ -38,7 +47,13 @@ const char *USAGE =
     "   Example: -m 800x600\n"
     "-m map\n"
     "   This map must be in the root of the directory the game's being run from.\n"
-    "   Example: -m map1.txt\n";
+    "   Example: -m map1.txt\n"
+    "-benchmark\n"
+    "   Times the transform kernels against the per-object glm code, then exits.\n"
+    "-record file\n"
+    "   Records the first level's input and simulation checksums to file.\n"
+    "-replay file\n"
+    "   Plays a recording back as fast as possible, without VR, and reports the first tick that simulates differently.\n";
 
 static bool g_bPrintf = true;
 using glm::mat4;
@@ -53,6 +68,8 @@ VRManager::VRManager(int argc, char *argv[])
       m_pContext(NULL),
       m_nCompanionWindowWidth(1280),
       m_nCompanionWindowHeight(640),
+      map(nullptr),
+      player(nullptr),
       m_pHMD(NULL),
       m_unSceneVAO(0),
       m_nSceneMatrixLocation(-1),
@@ -60,6 +77,10 @@ VRManager::VRManager(int argc, char *argv[])
       m_strPoseClasses("") {
     // other initialization tasks are done in Init
     memset(m_rDevClassChar, 0, sizeof(m_rDevClassChar));
+
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "-record") == 0) record_path_ = argv[i + 1];
+    }
 };
 
 //-----------------------------------------------------------------------------
@@ -121,10 +142,15 @@ bool VRManager::Init() {
     }
 
     SDL_SetWindowTitle(m_pCompanionWindow, "MazeGameVR");
+    GLState::Invalidate();
 
     m_iTexture = 0;
     m_uiVertcount = 0;
 
+    TransformKernels::Init();
+    OverlapKernels::Init();
+    JobSystem::Init();
+
     vr_camera_ = new VRCamera(0.1f, 500.0f, m_pHMD);
     vr_camera_->Setup();
 
@@ -179,6 +205,9 @@ bool VRManager::InitCompositor() {
 // Purpose:
 //-----------------------------------------------------------------------------
 void VRManager::Shutdown() {
+    UnloadLevel();  // While the GL context is still around to delete the level's VBO
+    JobSystem::Shutdown();
+
     if (m_pHMD) {
         vr::VR_Shutdown();
         m_pHMD = NULL;
@@ -212,6 +241,8 @@ void VRManager::RunMainLoop() {
             if (windowEvent.type == SDL_KEYUP) {  // Exit event loop
                 if (windowEvent.key.keysym.sym == SDLK_ESCAPE) {
                     quit = true;
+                } else if (windowEvent.key.keysym.sym == SDLK_TAB) {
+                    LoadLevel(map_file_ == "map1.txt" ? "map2.txt" : "map1.txt");
                 }
             }
 
@@ -238,13 +269,21 @@ void VRManager::RunMainLoop() {
         if (currentTime - lastTime >= 1000) {  // If last printf() was more than 1 sec ago
             // printf and reset timer
             printf("%f ms/frame\n", 1000.0 / double(nbFrames));
+            const RenderQueue::Stats& stats = SceneRenderer::QueueStats();
+            printf("%d draws, %d state changes sorted (%d unsorted)\n", stats.draws, stats.sorted_state_changes,
+                   stats.unsorted_state_changes);
+#ifdef _DEBUG
+            GLState::Counts gl_counts = GLState::LastFrameCounts();
+            printf("%d GL state calls made, %d skipped as redundant\n", gl_counts.issued, gl_counts.elided);
+#endif
             nbFrames = 0;
             lastTime += 1000;
         }
 
-        vr_input_manager_.HandleInput();
-
+        PublishInput();
+        JobSystem::RunMainThreadJobs();  // Anything that needed the GL context, queued since the last frame
         RenderFrame();
+        if (simulation_thread_.LatestSnapshot().level_complete) quit = true;  // Shut down normally, from this thread
     }
 
     SDL_StopTextInput();
@@ -264,47 +303,143 @@ void VRManager::ProcessVREvent(const vr::VREvent_t &event) {
     }
 }
 
+void VRManager::PublishInput() {
+    FrameInput &input = simulation_thread_.NextInput();
+    input.hmd_pose = hmd_pose_;
+    input.hmd_pose_valid = hmd_pose_valid_;
+
+    const Uint8 *key_state = SDL_GetKeyboardState(NULL);
+    input.keyboard_forward = key_state[SDL_SCANCODE_W] ? 1.0f : (key_state[SDL_SCANCODE_S] ? -1.0f : 0.0f);
+    input.keyboard_right = key_state[SDL_SCANCODE_D] ? 1.0f : (key_state[SDL_SCANCODE_A] ? -1.0f : 0.0f);
+
+    simulation_thread_.PublishInput();
+}
+
 void VRManager::RenderFrame() {
+    const RenderSnapshot &snapshot = simulation_thread_.LatestSnapshot();
+
+    // Draw the last step blended in from the one before, by however long it's been since the last step was due
+    Sint64 since_step = static_cast<Sint64>(SDL_GetPerformanceCounter() - snapshot.step_counter);
+    float interpolation = static_cast<float>(since_step) / (SIMULATION_STEP * SDL_GetPerformanceFrequency());
+    interpolation = glm::clamp(interpolation, 0.0f, 1.0f);
+    snapshot.Interpolate(interpolation, render_packets_);
+
+    if (snapshot.shader_mode != shader_mode_) {  // The uniform keeps its value in the program, so it's only set on changes
+        shader_mode_ = snapshot.shader_mode;
+        GLState::UseProgram(ShaderManager::Textured_Shader);
+        glUniform1i(ShaderManager::Attributes.shaderMode, shader_mode_);
+    }
+
     // for now as fast as possible
     if (m_pHMD) {
-        RenderStereoTargets();
+        RenderStereoTargets(snapshot);
         RenderCompanionWindow();
 
         vr::Texture_t leftEyeTexture = {(void *)(uintptr_t)leftEyeDesc.m_nResolveTextureId, vr::TextureType_OpenGL, vr::ColorSpace_Gamma};
         vr::VRCompositor()->Submit(vr::Eye_Left, &leftEyeTexture);
         vr::Texture_t rightEyeTexture = {(void *)(uintptr_t)rightEyeDesc.m_nResolveTextureId, vr::TextureType_OpenGL, vr::ColorSpace_Gamma};
         vr::VRCompositor()->Submit(vr::Eye_Right, &rightEyeTexture);
+        GLState::Invalidate();  // The compositor shares the context, and doesn't promise to leave its state alone
     }
 
     SDL_GL_SwapWindow(m_pCompanionWindow);
+    GLState::EndFrame();
 
     UpdateHMDMatrixPose();
+
+    FrameAllocator::Reset();  // Nothing from this frame's scratch memory is used past here
 }
 
 void VRManager::SetupScene() {
     glGenVertexArrays(1, &m_unSceneVAO);  // Create a VAO
-    glBindVertexArray(m_unSceneVAO);      // Bind the above created VAO to the current context
 
-    std::string map_file = "map1.txt";
-    map = map_loader.LoadMap(map_file, m_unSceneVAO);
-    player = new Player(vr_camera_, map);
-    map->Add(player);
-    vr_input_manager_.map_ = map;
+    ShaderManager::InitShaders();  // Compiled before the level, which points the VAO's attributes at its VBO
+
+    LoadLevel("map1.txt");
+    m_nSceneMatrixLocation = ShaderManager::Attributes.projection;
 
     TextureManager::InitTextures();
 
+    GLState::Enable(GL_DEPTH_TEST);
+
+    printf("%s\n", INSTRUCTIONS);
+}
+
+void VRManager::LoadLevel(const std::string &map_file) {
+    Uint32 start_time = SDL_GetTicks();
+    UnloadLevel();
+
+    GLState::BindVertexArray(m_unSceneVAO);  // Bind the above created VAO to the current context
+    {
+        Arena::Scope level_scope(&level_arena_);
+        map = map_loader.LoadMap(map_file, m_unSceneVAO, &level_arena_);
+        player = level_arena_.New<Player>(vr_camera_, map);
+        map->Add(player);
+    }
+    map_file_ = map_file;
+    vr_input_manager_.SetMap(map);
+
     ModelManager::InitVBO();
+    ShaderManager::InitShaderAttributes();
+    GLState::BindVertexArray(0);  // Unbind the VAO in case we want to create a new one
+
+    map->UpdateTransformsAndBounds();  // So collision works before the first frame is rendered
+    map->SaveStepTransforms();
+    map->ExtractStaticRenderPackets(render_packets_);  // Drawn instanced from here on, so they're uploaded once
+    SceneRenderer::SetStaticPackets(render_packets_);
+    if (!record_path_.empty()) {
+        if (!simulation_thread_.Record(record_path_, map_file)) printf("Couldn't open %s to record to\n", record_path_.c_str());
+        record_path_.clear();  // A replay starts from a freshly loaded level, so only the first one is worth recording
+    }
+    simulation_thread_.Start(map, vr_camera_, &vr_input_manager_);
 
-    ShaderManager::InitShaders();
-    m_nSceneMatrixLocation = ShaderManager::Attributes.projection;
+    printf("Loaded %s in %u ms using %zu KB of level memory\n", map_file.c_str(), SDL_GetTicks() - start_time,
+           level_arena_.BytesUsed() / 1024);
+}
 
-    TextureManager::InitTextures();
+bool VRManager::Replay(const std::string &recording_path) {
+    InputPlayback playback;
+    if (!playback.Open(recording_path)) {
+        printf("Couldn't read a recording from %s\n", recording_path.c_str());
+        return false;
+    }
 
-    glBindVertexArray(0);  // Unbind the VAO in case we want to create a new one
+    TransformKernels::Init();
+    OverlapKernels::Init();
+    JobSystem::Init();
+    vr_camera_ = new VRCamera(0.1f, 500.0f, nullptr);  // Never set up, since nothing's drawn
+    vr_input_manager_ = VRInputManager(nullptr, vr_camera_);
+
+    {
+        Arena::Scope level_scope(&level_arena_);
+        map = map_loader.LoadMap(playback.MapFile(), 0, &level_arena_);
+        player = level_arena_.New<Player>(vr_camera_, map);
+        map->Add(player);
+    }
+    map_file_ = playback.MapFile();
+    vr_input_manager_.SetMap(map);
 
-    glEnable(GL_DEPTH_TEST);
+    map->UpdateTransformsAndBounds();
+    map->SaveStepTransforms();
+    bool matched = simulation_thread_.Replay(map, vr_camera_, &vr_input_manager_, &playback);
 
-    printf("%s\n", INSTRUCTIONS);
+    JobSystem::PrintTimings();
+    JobSystem::Shutdown();
+    return matched;
+}
+
+void VRManager::UnloadLevel() {
+    if (map == nullptr) return;
+
+    simulation_thread_.Stop();  // It owns the map while it runs
+    JobSystem::PrintTimings();  // What the level's jobs took, all told
+    vr_input_manager_.SetMap(nullptr);
+    SceneRenderer::Cleanup();
+    ModelManager::Cleanup();
+    level_arena_.Reset();  // Destroys the map, its objects, their transforms, and the models
+
+    map = nullptr;
+    player = nullptr;
 }
 
 //-----------------------------------------------------------------------------
@@ -321,7 +456,7 @@ bool VRManager::CreateFrameBuffer(int nWidth, int nHeight, FramebufferDesc &fram
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, framebufferDesc.m_nDepthBufferId);
 
     glGenTextures(1, &framebufferDesc.m_nRenderTextureId);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, framebufferDesc.m_nRenderTextureId);
+    GLState::BindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, framebufferDesc.m_nRenderTextureId);
     glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGBA8, nWidth, nHeight, true);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, framebufferDesc.m_nRenderTextureId, 0);
 
@@ -329,7 +464,10 @@ bool VRManager::CreateFrameBuffer(int nWidth, int nHeight, FramebufferDesc &fram
     glBindFramebuffer(GL_FRAMEBUFFER, framebufferDesc.m_nResolveFramebufferId);
 
     glGenTextures(1, &framebufferDesc.m_nResolveTextureId);
-    glBindTexture(GL_TEXTURE_2D, framebufferDesc.m_nResolveTextureId);
+    GLState::BindTexture(0, GL_TEXTURE_2D, framebufferDesc.m_nResolveTextureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // How the companion window samples it, set once here
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, nWidth, nHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
@@ -378,14 +516,14 @@ void VRManager::SetupCompanionWindow() {
     m_uiCompanionWindowIndexSize = _countof(vIndices);
 
     glGenVertexArrays(1, &m_unCompanionWindowVAO);
-    glBindVertexArray(m_unCompanionWindowVAO);
+    GLState::BindVertexArray(m_unCompanionWindowVAO);
 
     glGenBuffers(1, &m_glCompanionWindowIDVertBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, m_glCompanionWindowIDVertBuffer);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_glCompanionWindowIDVertBuffer);
     glBufferData(GL_ARRAY_BUFFER, vVerts.size() * sizeof(VertexDataWindow), &vVerts[0], GL_STATIC_DRAW);
 
     glGenBuffers(1, &m_glCompanionWindowIDIndexBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glCompanionWindowIDIndexBuffer);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glCompanionWindowIDIndexBuffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_uiCompanionWindowIndexSize * sizeof(GLushort), &vIndices[0], GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0);
@@ -394,26 +532,26 @@ void VRManager::SetupCompanionWindow() {
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(VertexDataWindow), (void *)offsetof(VertexDataWindow, texCoord));
 
-    glBindVertexArray(0);
+    GLState::BindVertexArray(0);
 
     glDisableVertexAttribArray(0);
     glDisableVertexAttribArray(1);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-void VRManager::RenderStereoTargets() {
+void VRManager::RenderStereoTargets(const RenderSnapshot &snapshot) {
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glEnable(GL_MULTISAMPLE);
+    GLState::Enable(GL_MULTISAMPLE);
 
     // Left Eye
     glBindFramebuffer(GL_FRAMEBUFFER, leftEyeDesc.m_nRenderFramebufferId);
-    glViewport(0, 0, m_nRenderWidth, m_nRenderHeight);
-    RenderScene(vr::Eye_Left);
+    GLState::Viewport(0, 0, m_nRenderWidth, m_nRenderHeight);
+    RenderScene(vr::Eye_Left, snapshot);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    glDisable(GL_MULTISAMPLE);
+    GLState::Disable(GL_MULTISAMPLE);
 
     // Copy pixels from the renderframebuffer to the resolveframebuffer
     // I think this has something to do with MSAA?
@@ -426,15 +564,15 @@ void VRManager::RenderStereoTargets() {
     glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-    glEnable(GL_MULTISAMPLE);
+    GLState::Enable(GL_MULTISAMPLE);
 
     // Right Eye
     glBindFramebuffer(GL_FRAMEBUFFER, rightEyeDesc.m_nRenderFramebufferId);
-    glViewport(0, 0, m_nRenderWidth, m_nRenderHeight);
-    RenderScene(vr::Eye_Right);
+    GLState::Viewport(0, 0, m_nRenderWidth, m_nRenderHeight);
+    RenderScene(vr::Eye_Right, snapshot);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    glDisable(GL_MULTISAMPLE);
+    GLState::Disable(GL_MULTISAMPLE);
 
     glBindFramebuffer(GL_READ_FRAMEBUFFER, rightEyeDesc.m_nRenderFramebufferId);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, rightEyeDesc.m_nResolveFramebufferId);
@@ -448,51 +586,38 @@ void VRManager::RenderStereoTargets() {
 //-----------------------------------------------------------------------------
 // Purpose: Renders a scene with respect to nEye.
 //-----------------------------------------------------------------------------
-void VRManager::RenderScene(vr::Hmd_Eye nEye) {
-    mat4 current_world_to_view = vr_camera_->GetCurrentWorldToViewMatrix(nEye);
+void VRManager::RenderScene(vr::Hmd_Eye nEye, const RenderSnapshot &snapshot) {
+    mat4 current_world_to_view = vr_camera_->GetWorldToViewMatrix(nEye, hmd_pose_, snapshot.tracking_center);
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
+    GLState::Enable(GL_DEPTH_TEST);
 
-    glUseProgram(ShaderManager::Textured_Shader);
+    GLState::UseProgram(ShaderManager::Textured_Shader);
     glUniformMatrix4fv(m_nSceneMatrixLocation, 1, GL_FALSE, glm::value_ptr(current_world_to_view));
     glUniformMatrix4fv(ShaderManager::Attributes.view, 1, GL_FALSE, glm::value_ptr(mat4()));  // Temporary
     TextureManager::Update();
-    glBindVertexArray(m_unSceneVAO);
-    map->UpdateAll();
-    vr_input_manager_.RenderControllers(current_world_to_view);
-    glBindVertexArray(0);
-
-    glUseProgram(0);
+    SceneRenderer::DrawStatic(current_world_to_view);
+    GLState::BindVertexArray(m_unSceneVAO);
+    SceneRenderer::Cull(render_packets_, current_world_to_view, visible_packets_);
+    SceneRenderer::Draw(render_packets_, visible_packets_, current_world_to_view);
+    vr_input_manager_.RenderControllers(snapshot.hands, current_world_to_view);
 }
 
 void VRManager::RenderCompanionWindow() {
-    glDisable(GL_DEPTH_TEST);
-    glViewport(0, 0, m_nCompanionWindowWidth, m_nCompanionWindowHeight);
-    glActiveTexture(GL_TEXTURE0);  // Must reset this, as this is where the companion window shader expects these textures
+    GLState::Disable(GL_DEPTH_TEST);
+    GLState::Viewport(0, 0, m_nCompanionWindowWidth, m_nCompanionWindowHeight);
 
-    glBindVertexArray(m_unCompanionWindowVAO);
-    glUseProgram(ShaderManager::CompanionWindow_Shader);
+    GLState::BindVertexArray(m_unCompanionWindowVAO);
+    GLState::UseProgram(ShaderManager::CompanionWindow_Shader);
 
-    // render left eye (first half of index array )
-    glBindTexture(GL_TEXTURE_2D, leftEyeDesc.m_nResolveTextureId);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // render left eye (first half of index array ). Unit 0 is where the companion window shader expects these textures
+    GLState::BindTexture(0, GL_TEXTURE_2D, leftEyeDesc.m_nResolveTextureId);
     glDrawElements(GL_TRIANGLES, m_uiCompanionWindowIndexSize / 2, GL_UNSIGNED_SHORT, 0);
 
     // render right eye (second half of index array )
-    glBindTexture(GL_TEXTURE_2D, rightEyeDesc.m_nResolveTextureId);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    GLState::BindTexture(0, GL_TEXTURE_2D, rightEyeDesc.m_nResolveTextureId);
     glDrawElements(GL_TRIANGLES, m_uiCompanionWindowIndexSize / 2, GL_UNSIGNED_SHORT,
                    (const void *)(uintptr_t)(m_uiCompanionWindowIndexSize));
-
-    glBindVertexArray(0);
-    glUseProgram(0);
 }
 
 void VRManager::UpdateHMDMatrixPose() {
@@ -533,7 +658,8 @@ void VRManager::UpdateHMDMatrixPose() {
     }
 
     if (m_rTrackedDevicePose[vr::k_unTrackedDeviceIndex_Hmd].bPoseIsValid) {
-        vr_camera_->SetCurrentPose(m_rmat4DevicePose[vr::k_unTrackedDeviceIndex_Hmd]);
+        hmd_pose_ = m_rmat4DevicePose[vr::k_unTrackedDeviceIndex_Hmd];  // The simulation thread gets it with the next PublishInput()
+        hmd_pose_valid_ = true;
     }
 }
 
@@ -546,19 +672,31 @@ mat4 VRManager::ConvertSteamVRMatrixToMat4(const vr::HmdMatrix34_t &matPose) {
     return matrixObj;
 }
 
-std::string VRManager::GetTrackedDeviceString(vr::TrackedDeviceIndex_t unDevice, vr::TrackedDeviceProperty prop,
+FrameString VRManager::GetTrackedDeviceString(vr::TrackedDeviceIndex_t unDevice, vr::TrackedDeviceProperty prop,
                                               vr::TrackedPropertyError *peError) {
     uint32_t unRequiredBufferLen = vr::VRSystem()->GetStringTrackedDeviceProperty(unDevice, prop, NULL, 0, peError);
-    if (unRequiredBufferLen == 0) return "";
+    if (unRequiredBufferLen == 0) return FrameString();
 
-    char *pchBuffer = new char[unRequiredBufferLen];
+    char *pchBuffer = static_cast<char *>(FrameAllocator::Allocate(unRequiredBufferLen, 1));
     unRequiredBufferLen = vr::VRSystem()->GetStringTrackedDeviceProperty(unDevice, prop, pchBuffer, unRequiredBufferLen, peError);
-    std::string sResult = pchBuffer;
-    delete[] pchBuffer;
-    return sResult;
+    return FrameString(pchBuffer);
 }
 
 int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-benchmark") == 0) {
+            TransformKernels::Init();
+            TransformKernels::RunBenchmark();
+            OverlapKernels::Init();
+            OverlapKernels::RunBenchmark();
+            return 0;
+        }
+        if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc) {
+            VRManager replay(argc, argv);
+            return replay.Replay(argv[i + 1]) ? 0 : 1;
+        }
+    }
+
     VRManager *pMainApplication = new VRManager(argc, argv);
 
     if (!pMainApplication->Init()) {
@@ -3,9 +3,12 @@
 #include <OpenVR/openvr.h>
 #include <SDL.h>
 #include <glm.hpp>
+#include "arena.h"
+#include "frame_allocator.h"
 #include "map.h"
 #include "map_loader.h"
 #include "player.h"
+#include "simulation_thread.h"
 #include "vr_camera.h"
 #include "vr_input_manager.h"
 
@@ -21,30 +24,45 @@ class VRManager {
     void Shutdown();
 
     void RunMainLoop();
+    void PublishInput();  // Hands the simulation thread what only this thread can read: the keyboard and the latest HMD pose
     void ProcessVREvent(const vr::VREvent_t &event);
-    void RenderFrame();
+    void RenderFrame();  // Draws the latest snapshot from the simulation thread
+
+    // Plays a recording made with -record back without VR or a window, and reports whether it simulated the same way
+    bool Replay(const std::string &recording_path);
 
     void SetupScene();
+    void LoadLevel(const std::string &map_file);  // Unloads the current level first, if there is one
+    void UnloadLevel();
     bool SetupStereoRenderTargets();
     void SetupCompanionWindow();
 
-    void RenderStereoTargets();
+    void RenderStereoTargets(const RenderSnapshot &snapshot);
     void RenderCompanionWindow();
-    void RenderScene(vr::Hmd_Eye nEye);
+    void RenderScene(vr::Hmd_Eye nEye, const RenderSnapshot &snapshot);
 
     void UpdateHMDMatrixPose();
 
     static glm::mat4 ConvertSteamVRMatrixToMat4(const vr::HmdMatrix34_t &matPose);
-    static std::string GetTrackedDeviceString(vr::TrackedDeviceIndex_t unDevice, vr::TrackedDeviceProperty prop,
-                                              vr::TrackedPropertyError *peError = NULL);
+    static FrameString GetTrackedDeviceString(vr::TrackedDeviceIndex_t unDevice, vr::TrackedDeviceProperty prop,
+                                              vr::TrackedPropertyError *peError = NULL);  // Only valid until the end of the frame
 
    private:
+    Arena level_arena_;  // Everything owned by the current level. Resetting it is the whole of unloading the level
+    std::string map_file_;
+    std::string record_path_;  // The next level loaded is recorded here, if it's set
     MapLoader map_loader;
     Map *map;
     VRCamera *vr_camera_;
     Player *player;
+    std::vector<RenderPacket> render_packets_;  // Interpolated once per frame and drawn for each eye. Reused so it doesn't reallocate
+    std::vector<uint8_t> visible_packets_;     // Which of them the eye being drawn can see
+    glm::mat4 hmd_pose_;  // The latest from WaitGetPoses. The view uses it directly, rather than waiting on the simulation
+    bool hmd_pose_valid_ = false;
+    int shader_mode_ = 0;  // What the textured shader's shaderMode uniform is currently set to. GL starts it at 0 when linking
 
     VRInputManager vr_input_manager_;
+    SimulationThread simulation_thread_;  // Declared after everything it uses, so it's stopped before they're destroyed
 
     vr::IVRSystem *m_pHMD;
     std::string m_strDriver;
@@ -1,7 +1,7 @@
 #pragma once
 #include "game_object.h"
 
-class Wall : public GameObject {
+class Wall final : public GameObject {
    public:
     Wall(Model* model) : GameObject(model) {}
     Wall(Model* model, bool solid) : GameObject(model) {